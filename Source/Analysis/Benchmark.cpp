@@ -0,0 +1,362 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:Benchmark.cpp
+
+		Implementation of Benchmark.h, and the entry point of the benchmark target,
+		which hosts the processor and the views without a window.
+
+*************************************************************************************/
+
+#include "Benchmark.h"
+#include "../Processor/PluginProcessor.h"
+#include "../Vectorscope/Vectorscope.h"
+#include "../Oscilloscope/Oscilloscope.h"
+#include "../Spectrum/Spectrum.h"
+#include "../version.h"
+#include <cpl/system/SysStats.h>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
+namespace Signalizer
+{
+	static const char * Usage =
+		"usage: SignalizerBenchmark [options]\n"
+		"\n"
+		"  --csv <file>             write the results as CSV (default: standard output)\n"
+		"  --json <file>            write the results as JSON\n"
+		"  --kernel <name>          only measure kernels containing name, may be repeated\n"
+		"  --windows <n,n,...>      transform sizes of window size dependent kernels (default: 512,2048,8192,32768)\n"
+		"  --block <samples>        block size of the audio thread kernels (default: 512)\n"
+		"  --time <seconds>         minimum time of each timed batch (default: 0.05)\n"
+		"  --batches <count>        timed batches per measurement, of which the fastest is reported (default: 5)\n";
+
+	/// <summary>
+	/// Deterministic stereo test signal: a few partials in different phases between the channels, and some noise,
+	/// such that trigger, transform and colouring kernels all have content to work on.
+	/// </summary>
+	static void GenerateTestSignal(AFloat * left, AFloat * right, std::size_t numSamples, std::uint64_t position, double sampleRate, std::minstd_rand & random)
+	{
+		const double partials[] = { 110, 440, 3520 };
+		const double tau = 2 * 3.14159265358979323846;
+		std::uniform_real_distribution<AFloat> noise(-0.05f, 0.05f);
+
+		for (std::size_t n = 0; n < numSamples; ++n)
+		{
+			const double t = (position + n) / sampleRate;
+			double l = 0, r = 0;
+
+			for (std::size_t p = 0; p < std::extent<decltype(partials)>::value; ++p)
+			{
+				l += std::sin(tau * partials[p] * t) / (p + 3);
+				r += std::sin(tau * partials[p] * t + 0.5 * (p + 1)) / (p + 3);
+			}
+
+			left[n] = static_cast<AFloat>(l) + noise(random);
+			right[n] = static_cast<AFloat>(r) + noise(random);
+		}
+	}
+
+	Benchmark::Benchmark(const Options & optionsToUse, std::function<void()> settle)
+		: options(optionsToUse)
+		, settleAudio(std::move(settle))
+	{
+		std::minstd_rand random(1);
+
+		testSignal[0].resize(options.blockSize);
+		testSignal[1].resize(options.blockSize);
+		GenerateTestSignal(testSignal[0].data(), testSignal[1].data(), options.blockSize, 0, options.sampleRate, random);
+	}
+
+	bool Benchmark::isSelected(const std::string & kernel) const
+	{
+		if (options.filters.empty())
+			return true;
+
+		for (auto & filter : options.filters)
+		{
+			if (kernel.find(filter) != std::string::npos)
+				return true;
+		}
+
+		return false;
+	}
+
+	void Benchmark::record(const Result & result)
+	{
+		results.push_back(result);
+
+		std::cerr << result.kernel << " (" << result.variant << ", " << result.isa << "): "
+			<< result.nanosecondsPerFrame << " ns/frame, " << result.samplesPerSecond() << " samples/s" << std::endl;
+	}
+
+	void Benchmark::writeCSV(std::ostream & output) const
+	{
+		output << "kernel,variant,isa,samples_per_frame,ns_per_frame,samples_per_second,frames\n";
+
+		for (auto & r : results)
+		{
+			output << r.kernel << ",\"" << r.variant << "\"," << r.isa << ',' << r.samplesPerFrame << ','
+				<< r.nanosecondsPerFrame << ',' << r.samplesPerSecond() << ',' << r.frames << '\n';
+		}
+	}
+
+	void Benchmark::writeJSON(std::ostream & output) const
+	{
+		output
+			<< "{\n"
+			<< "\t\"version\": \"" << SIGNALIZER_VERSION_STRING << "\",\n"
+			<< "\t\"cpu\": \"" << juce::SystemStats::getCpuVendor().toStdString() << "\",\n"
+			<< "\t\"mhz\": " << cpl::system::CProcessor::getMHz() << ",\n"
+			<< "\t\"sample_rate\": " << options.sampleRate << ",\n"
+			<< "\t\"block_size\": " << options.blockSize << ",\n"
+			<< "\t\"results\": [";
+
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			auto & r = results[i];
+
+			output
+				<< (i ? ",\n" : "\n")
+				<< "\t\t{ \"kernel\": \"" << r.kernel << "\", \"variant\": \"" << r.variant << "\", \"isa\": \"" << r.isa << "\", "
+				<< "\"samples_per_frame\": " << r.samplesPerFrame << ", \"ns_per_frame\": " << r.nanosecondsPerFrame << ", "
+				<< "\"samples_per_second\": " << r.samplesPerSecond() << ", \"frames\": " << r.frames << " }";
+		}
+
+		output << "\n\t]\n}\n";
+	}
+
+	/// <summary>
+	/// Hosts the processor and the views, and feeds the test signal through the processor when they need audio.
+	/// </summary>
+	class BenchmarkHost
+		: private AudioStream::Listener
+	{
+	public:
+
+		BenchmarkHost(const Benchmark::Options & optionsToUse)
+			: options(optionsToUse)
+			, random(2)
+			, position(0)
+			, deliveredSamples(0)
+		{
+			globalBehaviour.hideWidgetsOnMouseExit.store(false);
+			globalBehaviour.stopProcessingOnSuspend.store(false);
+
+			processor = std::make_unique<AudioProcessor>();
+			processor->prepareToPlay(options.sampleRate, static_cast<int>(options.blockSize));
+
+			auto & stream = processor->stream;
+			auto & parameters = processor->parameterMap;
+
+			vectorScope = std::make_unique<VectorScope>(globalBehaviour, "Vectorscope", stream, parameters.getState("Vectorscope"));
+			oscilloscope = std::make_unique<Oscilloscope>(globalBehaviour, "Oscilloscope", stream, parameters.getState("Oscilloscope"));
+			spectrum = std::make_unique<Spectrum>(globalBehaviour, "Spectrum", stream, parameters.getState("Spectrum"));
+
+			vectorScope->setSize(700, 480);
+			oscilloscope->setSize(700, 480);
+			spectrum->setSize(700, 480);
+
+			listenToSource(stream);
+		}
+
+		~BenchmarkHost()
+		{
+			detachFromSource();
+
+			spectrum = nullptr;
+			oscilloscope = nullptr;
+			vectorScope = nullptr;
+			processor = nullptr;
+		}
+
+		/// <summary>
+		/// Runs the benchmarks of every view.
+		/// </summary>
+		void run(Benchmark & suite)
+		{
+			settle();
+
+			spectrum->runBenchmarks(suite);
+			oscilloscope->runBenchmarks(suite);
+			vectorScope->runBenchmarks(suite);
+		}
+
+		/// <summary>
+		/// Replaces the whole audio history with the test signal, and waits for the views to receive it.
+		/// </summary>
+		void settle()
+		{
+			auto & stream = processor->stream;
+			const auto blockSize = static_cast<int>(options.blockSize);
+			const auto samples = stream.getAudioHistoryCapacity() + options.blockSize;
+
+			juce::AudioSampleBuffer buffer(2, blockSize);
+			juce::MidiBuffer midi;
+
+			for (std::size_t fed = 0; fed < samples; fed += options.blockSize)
+			{
+				GenerateTestSignal(buffer.getWritePointer(0), buffer.getWritePointer(1), options.blockSize, position, options.sampleRate, random);
+				processor->processBlock(buffer, midi);
+				position += options.blockSize;
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+
+			while (deliveredSamples.load(std::memory_order_acquire) < position)
+			{
+				if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10))
+				{
+					std::cerr << "timed out waiting for the asynchronous listeners" << std::endl;
+					std::exit(1);
+				}
+
+				std::this_thread::yield();
+			}
+		}
+
+	private:
+
+		bool onAsyncAudio(const AudioStream & source, AudioStream::DataType ** buffer, std::size_t numChannels, std::size_t numSamples) override
+		{
+			deliveredSamples.fetch_add(numSamples, std::memory_order_release);
+			return false;
+		}
+
+		Benchmark::Options options;
+		SharedBehaviour globalBehaviour;
+		std::unique_ptr<AudioProcessor> processor;
+		std::unique_ptr<VectorScope> vectorScope;
+		std::unique_ptr<Oscilloscope> oscilloscope;
+		std::unique_ptr<Spectrum> spectrum;
+		std::minstd_rand random;
+		std::uint64_t position;
+		std::atomic<std::uint64_t> deliveredSamples;
+	};
+
+	static bool ParseArguments(int argc, char * argv[], Benchmark::Options & options, std::string & csv, std::string & json)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+
+			if (i + 1 >= argc)
+				return false;
+
+			const std::string value = argv[++i];
+
+			if (arg == "--csv")
+			{
+				csv = value;
+			}
+			else if (arg == "--json")
+			{
+				json = value;
+			}
+			else if (arg == "--kernel")
+			{
+				options.filters.push_back(value);
+			}
+			else if (arg == "--windows")
+			{
+				options.windowSizes.clear();
+				std::stringstream list(value);
+				std::string size;
+
+				while (std::getline(list, size, ','))
+				{
+					if (std::atoi(size.c_str()) > 0)
+						options.windowSizes.push_back(static_cast<std::size_t>(std::atoi(size.c_str())));
+				}
+
+				if (options.windowSizes.empty())
+					return false;
+			}
+			else if (arg == "--block")
+			{
+				options.blockSize = static_cast<std::size_t>(std::max(1, std::atoi(value.c_str())));
+			}
+			else if (arg == "--time")
+			{
+				options.batchSeconds = std::atof(value.c_str());
+			}
+			else if (arg == "--batches")
+			{
+				options.batches = std::max(1, std::atoi(value.c_str()));
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+int main(int argc, char * argv[])
+{
+	using namespace Signalizer;
+
+	Benchmark::Options options;
+	std::string csv, json;
+
+	if (!ParseArguments(argc, argv, options, csv, json))
+	{
+		std::cerr << Usage;
+		return 2;
+	}
+
+	// views are components, and need the message manager
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+	BenchmarkHost host(options);
+	Benchmark suite(options, [&] { host.settle(); });
+
+	host.run(suite);
+
+	if (!json.empty())
+	{
+		std::ofstream output(json);
+		suite.writeJSON(output);
+	}
+
+	if (!csv.empty())
+	{
+		std::ofstream output(csv);
+		suite.writeCSV(output);
+	}
+	else if (json.empty())
+	{
+		suite.writeCSV(std::cout);
+	}
+
+	return 0;
+}
@@ -0,0 +1,196 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:Benchmark.h
+
+		Timing and reporting of the DSP kernels of the views, forced through
+		every instruction set available. Only part of the benchmark target.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_BENCHMARK_H
+	#define SIGNALIZER_BENCHMARK_H
+
+	#include "../Signalizer.h"
+	#include <cpl/simd.h>
+	#include <chrono>
+	#include <cstdint>
+	#include <functional>
+	#include <limits>
+	#include <ostream>
+	#include <string>
+	#include <vector>
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// A suite of kernel measurements. Views implement runBenchmarks(Benchmark &), which sets up
+		/// their state for each variant of a kernel, and times it through measure() for each ISA
+		/// given by forEachISA().
+		///
+		/// A frame is one call of a kernel, and the samples of a frame are the audio samples it consumes:
+		/// the block size for audio thread kernels, the transform size for kernels processing a transform,
+		/// and the amount of filters for kernels post-processing one.
+		/// </summary>
+		class Benchmark
+		{
+		public:
+
+			/// <summary>
+			/// Descriptor of an instruction set, like those passed to the dispatchers by cpl::simd::dynamic_isa_dispatch.
+			/// </summary>
+			template<typename Vector>
+				struct ForcedISA
+				{
+					typedef Vector V;
+				};
+
+			struct Result
+			{
+				std::string kernel, variant, isa;
+				std::size_t samplesPerFrame;
+				double nanosecondsPerFrame;
+				std::uint64_t frames;
+
+				double samplesPerSecond() const noexcept
+				{
+					return nanosecondsPerFrame > 0 ? samplesPerFrame * 1e9 / nanosecondsPerFrame : 0;
+				}
+			};
+
+			struct Options
+			{
+				/// <summary>
+				/// Minimum time of each timed batch, of which the fastest is reported.
+				/// </summary>
+				double batchSeconds = 0.05;
+				int batches = 5;
+				std::size_t blockSize = 512;
+				double sampleRate = 48000;
+				/// <summary>
+				/// Transform sizes of the window size dependent kernels.
+				/// </summary>
+				std::vector<std::size_t> windowSizes { 512, 2048, 8192, 32768 };
+				/// <summary>
+				/// If not empty, only kernels containing any of these strings are measured.
+				/// </summary>
+				std::vector<std::string> filters;
+			};
+
+			/// <summary>
+			/// settle is called by views after changes that need the audio stream to process more audio,
+			/// and must not return before the audio has been delivered to the views.
+			/// </summary>
+			Benchmark(const Options & options, std::function<void()> settle);
+
+			/// <summary>
+			/// Calls functor(ForcedISA<V>(), name) for every vector type V of floats supported by this processor,
+			/// scalars included.
+			/// </summary>
+			template<class Functor>
+				static void forEachISA(Functor && functor)
+				{
+					functor(ForcedISA<float>(), "scalar");
+
+					if (juce::SystemStats::hasSSE())
+						functor(ForcedISA<cpl::simd::v4sf>(), "sse");
+
+					if (juce::SystemStats::hasAVX())
+						functor(ForcedISA<cpl::simd::v8sf>(), "avx");
+				}
+
+			/// <summary>
+			/// Returns whether the kernel is selected by the filters.
+			/// </summary>
+			bool isSelected(const std::string & kernel) const;
+
+			/// <summary>
+			/// Times repeated calls of kernel, and records the result. Does nothing if the kernel isn't selected.
+			/// </summary>
+			template<class Kernel>
+				void measure(const std::string & kernel, const std::string & variant, const char * isa, std::size_t samplesPerFrame, Kernel && call)
+				{
+					if (!isSelected(kernel))
+						return;
+
+					typedef std::chrono::steady_clock clock;
+
+					// first call sizes any lazily allocated state, and warms the caches
+					call();
+
+					auto timeFrames = [&](std::uint64_t frames)
+					{
+						const auto start = clock::now();
+
+						for (std::uint64_t i = 0; i < frames; ++i)
+							call();
+
+						return std::chrono::duration<double>(clock::now() - start).count();
+					};
+
+					// double the batch until it takes long enough to be timed reliably
+					std::uint64_t frames = 1;
+					double elapsed = timeFrames(frames);
+
+					while (elapsed < options.batchSeconds && frames < (std::uint64_t(1) << 40))
+					{
+						frames *= 2;
+						elapsed = timeFrames(frames);
+					}
+
+					double fastest = elapsed;
+
+					for (int i = 1; i < options.batches; ++i)
+						fastest = std::min(fastest, timeFrames(frames));
+
+					record({ kernel, variant, isa, samplesPerFrame, fastest * 1e9 / frames, frames });
+				}
+
+			/// <summary>
+			/// Feeds more audio through the stream, see the constructor.
+			/// </summary>
+			void settle() { settleAudio(); }
+
+			const Options & getOptions() const noexcept { return options; }
+
+			/// <summary>
+			/// A channel of a stereo test signal of getOptions().blockSize samples. Kernels may not modify it.
+			/// </summary>
+			AFloat * getTestChannel(std::size_t channel) noexcept { return testSignal[channel].data(); }
+
+			const std::vector<Result> & getResults() const noexcept { return results; }
+
+			void writeCSV(std::ostream & output) const;
+			void writeJSON(std::ostream & output) const;
+
+		private:
+
+			void record(const Result & result);
+
+			Options options;
+			std::function<void()> settleAudio;
+			std::vector<Result> results;
+			cpl::aligned_vector<AFloat, 32> testSignal[2];
+		};
+	};
+#endif
@@ -0,0 +1,517 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:OfflineAnalysis.cpp
+
+		Implementation of OfflineAnalysis.h, and the entry point of the
+		command-line analysis target.
+
+*************************************************************************************/
+
+#include "OfflineAnalysis.h"
+#include "../Processor/PluginProcessor.h"
+#include "../Vectorscope/Vectorscope.h"
+#include "../Oscilloscope/Oscilloscope.h"
+#include "../Oscilloscope/StreamPreprocessing.h"
+#include "../Spectrum/Spectrum.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace Signalizer
+{
+	static const char * Usage =
+		"usage: SignalizerAnalysis [options] <input>\n"
+		"\n"
+		"  --out <dir>              directory for the CSV results (default: current)\n"
+		"  --block <samples>        block size passed to processBlock (default: 512)\n"
+		"  --fps <rate>             simulated frames per second of audio (default: 60)\n"
+		"  --size <width> <height>  size of the simulated views (default: 700 480)\n"
+		"  --raw <rate> <channels>  read the input as raw interleaved 32-bit floats\n"
+		"  --set <name> <value>     set an exported parameter to a normalized value\n"
+		"  --only <view>            only drive the named view: spectrum, oscilloscope or vectorscope\n"
+		"  --trace <file>           write the trace zones as Chrome trace events (needs SIGNALIZER_TRACING)\n"
+		"  --check-triggers         fail if the oscilloscope's trigger columns never change (for periodic inputs)\n";
+
+	/// <summary>
+	/// Time a block may take to be delivered to the asynchronous listeners, before the analysis gives up.
+	/// </summary>
+	static const auto DeliveryTimeout = std::chrono::seconds(10);
+
+	OfflineAnalysis::OfflineAnalysis(const Options & optionsToUse)
+		: options(optionsToUse)
+		, sampleRate(0)
+		, numChannels(0)
+		, readPosition(0)
+		, lastTriggers()
+		, oscilloscopeRows(0)
+		, triggersChanged(false)
+		, deliveredSamples(0)
+	{
+		globalBehaviour.hideWidgetsOnMouseExit.store(false);
+		globalBehaviour.stopProcessingOnSuspend.store(false);
+	}
+
+	OfflineAnalysis::~OfflineAnalysis()
+	{
+		if (processor)
+			detachFromSource();
+
+		// views listen to the processor's stream
+		spectrum = nullptr;
+		oscilloscope = nullptr;
+		vectorScope = nullptr;
+		processor = nullptr;
+	}
+
+	bool OfflineAnalysis::openInput()
+	{
+		juce::File file = juce::File::getCurrentWorkingDirectory().getChildFile(options.input);
+
+		if (!file.existsAsFile())
+		{
+			std::cerr << "input doesn't exist: " << options.input << std::endl;
+			return false;
+		}
+
+		if (options.raw)
+		{
+			rawInput.reset(file.createInputStream());
+			sampleRate = options.rawSampleRate;
+			numChannels = options.rawChannels;
+			return rawInput != nullptr;
+		}
+
+		juce::AudioFormatManager formats;
+		formats.registerBasicFormats();
+		reader.reset(formats.createReaderFor(file));
+
+		if (!reader)
+		{
+			std::cerr << "unsupported audio file: " << options.input << std::endl;
+			return false;
+		}
+
+		sampleRate = reader->sampleRate;
+		numChannels = static_cast<int>(reader->numChannels);
+		return true;
+	}
+
+	int OfflineAnalysis::readBlock(juce::AudioSampleBuffer & buffer)
+	{
+		const int maxFrames = buffer.getNumSamples();
+		int frames = 0;
+
+		if (reader)
+		{
+			frames = static_cast<int>(std::min<juce::int64>(maxFrames, reader->lengthInSamples - readPosition));
+
+			if (frames > 0)
+				reader->read(&buffer, 0, frames, readPosition, true, true);
+		}
+		else
+		{
+			interleaved.resize(static_cast<std::size_t>(maxFrames * numChannels));
+			const auto bytes = rawInput->read(interleaved.data(), static_cast<int>(interleaved.size() * sizeof(float)));
+			frames = std::max(0, bytes) / static_cast<int>(numChannels * sizeof(float));
+
+			for (int c = 0; c < numChannels; ++c)
+			{
+				auto channel = buffer.getWritePointer(c);
+				for (int n = 0; n < frames; ++n)
+					channel[n] = interleaved[n * numChannels + c];
+			}
+		}
+
+		frames = std::max(0, frames);
+
+		// the processor always processes stereo: mono inputs are duplicated.
+		for (int c = std::min(numChannels, buffer.getNumChannels()); c < buffer.getNumChannels(); ++c)
+			buffer.copyFrom(c, 0, buffer, 0, 0, frames);
+
+		readPosition += frames;
+		return frames;
+	}
+
+	bool OfflineAnalysis::applyParameters()
+	{
+		for (auto & parameter : options.parameters)
+		{
+			bool found = false;
+
+			for (int i = 0; i < processor->getNumParameters(); ++i)
+			{
+				if (processor->getParameterName(i).toStdString() == parameter.first)
+				{
+					processor->setParameter(i, parameter.second);
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+			{
+				std::cerr << "unknown parameter: " << parameter.first << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool OfflineAnalysis::onAsyncAudio(const AudioStream & source, AudioStream::DataType ** buffer, std::size_t numChannels, std::size_t numSamples)
+	{
+		deliveredSamples.fetch_add(numSamples, std::memory_order_release);
+		return false;
+	}
+
+	bool OfflineAnalysis::waitForDelivery(std::uint64_t samples)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		while (deliveredSamples.load(std::memory_order_acquire) < samples)
+		{
+			if (std::chrono::steady_clock::now() - start > DeliveryTimeout)
+				return false;
+
+			std::this_thread::yield();
+		}
+
+		return true;
+	}
+
+	void OfflineAnalysis::frame(std::uint64_t position)
+	{
+		SIGNALIZER_TRACE_ZONE("OfflineAnalysis::frame");
+
+		if (vectorScope)
+		{
+			auto & v = *vectorScope;
+			// the same lock the renderer holds while updating
+			auto && lockedView = v.audioStream.getAudioBufferViews();
+			(void)lockedView;
+			v.handleFlagUpdates();
+
+			vectorScopeOutput
+				<< position << ','
+				<< v.shared.autoGainEnvelope.load(std::memory_order_acquire) << ','
+				<< v.filters.balance[0][0] << ',' << v.filters.balance[0][1] << ','
+				<< v.filters.balance[1][0] << ',' << v.filters.balance[1][1] << ','
+				<< v.filters.phase[0] << ',' << v.filters.phase[1] << '\n';
+		}
+
+		if (oscilloscope)
+		{
+			auto & o = *oscilloscope;
+			MeasuredMutex lock(o.bufferLock, LockStatistics::Owner::Rendering);
+			o.handleFlagUpdates();
+			o.channelData.acquireDisplay();
+			// triggering and sizing of the audio storage is done while rendering
+			o.analyseDisplay();
+
+			const TriggerColumns triggers {
+				o.triggerState.fundamental,
+				o.triggerState.cycleSamples,
+				o.triggerState.phase,
+				o.triggerState.sampleOffset,
+				o.channelData.published.read().start
+			};
+
+			if (oscilloscopeRows++ > 0 && !(triggers == lastTriggers))
+				triggersChanged = true;
+
+			lastTriggers = triggers;
+
+			oscilloscopeOutput
+				<< position << ','
+				<< triggers.fundamental << ','
+				<< triggers.cycleSamples << ','
+				<< triggers.phase << ','
+				<< triggers.sampleOffset << ','
+				<< triggers.windowStart << ','
+				<< o.triggerState.preprocessingTrigger->getDroppedTriggers() << ','
+				<< o.triggerState.preprocessingTrigger->getCoalescedTriggers() << ','
+				<< o.shared.autoGainEnvelope.load(std::memory_order_acquire) << '\n';
+		}
+
+		if (spectrum)
+		{
+			auto & s = *spectrum;
+			s.handleFlagUpdates();
+
+			if (s.state.displayMode == SpectrumContent::DisplayMode::LineGraph)
+			{
+				if (s.lineGraphExchange.acquireLatest())
+				{
+					for (std::size_t i = 0; i < SpectrumContent::LineGraphs::LineEnd; ++i)
+					{
+						spectrumOutput << position << ',' << i;
+
+						for (auto & point : s.lineGraphExchange.front()[i])
+							spectrumOutput << ',' << point.magnitude;
+
+						spectrumOutput << '\n';
+					}
+				}
+			}
+			else
+			{
+				// every queued frame is a column of the colour spectrum, and has to be returned to the pool
+				while (s.processNextFrame())
+				{
+					const auto & results = s.lineGraphs[SpectrumContent::LineGraphs::LineMain].results;
+					const auto numFilters = std::min<std::size_t>(results.size(), static_cast<std::size_t>(s.getNumFilters()));
+
+					spectrumOutput << position << ",colour";
+
+					for (std::size_t i = 0; i < numFilters; ++i)
+						spectrumOutput << ',' << results[i].magnitude;
+
+					spectrumOutput << '\n';
+				}
+			}
+		}
+	}
+
+	int OfflineAnalysis::run()
+	{
+		// frames are analysed, and blocks processed, on this thread
+		SIGNALIZER_TRACE_THREAD("Analysis");
+
+		if (!openInput())
+			return 1;
+
+		if (numChannels < 1)
+		{
+			std::cerr << "input has no channels" << std::endl;
+			return 1;
+		}
+
+		processor = std::make_unique<AudioProcessor>();
+		processor->prepareToPlay(sampleRate, options.blockSize);
+
+		if (!applyParameters())
+			return 1;
+
+		auto & stream = processor->stream;
+		auto & parameters = processor->parameterMap;
+
+		if (options.vectorscope)
+			vectorScope = std::make_unique<VectorScope>(globalBehaviour, "Vectorscope", stream, parameters.getState("Vectorscope"));
+		if (options.oscilloscope)
+			oscilloscope = std::make_unique<Oscilloscope>(globalBehaviour, "Oscilloscope", stream, parameters.getState("Oscilloscope"));
+		if (options.spectrum)
+			spectrum = std::make_unique<Spectrum>(globalBehaviour, "Spectrum", stream, parameters.getState("Spectrum"));
+
+		for (juce::Component * view : { (juce::Component *)vectorScope.get(), (juce::Component *)oscilloscope.get(), (juce::Component *)spectrum.get() })
+		{
+			if (view)
+				view->setSize(options.width, options.height);
+		}
+
+		listenToSource(stream);
+
+		juce::File directory = juce::File::getCurrentWorkingDirectory().getChildFile(options.outputDirectory);
+		directory.createDirectory();
+
+		auto openOutput = [&](std::ofstream & output, const char * name, const char * header)
+		{
+			output.open(directory.getChildFile(name).getFullPathName().toStdString());
+			output.precision(9);
+			output << header << '\n';
+		};
+
+		if (vectorScope)
+			openOutput(vectorScopeOutput, "vectorscope.csv", "position,autogain,balance_slow_left,balance_slow_right,balance_fast_left,balance_fast_right,phase_slow,phase_fast");
+		if (oscilloscope)
+			openOutput(oscilloscopeOutput, "oscilloscope.csv", "position,fundamental,cycle_samples,phase,sample_offset,window_start,dropped_triggers,coalesced_triggers,autogain");
+		if (spectrum)
+			openOutput(spectrumOutput, "spectrum.csv", "position,source,magnitudes...");
+
+		// first frame initializes the views, like the first rendered frame would.
+		frame(0);
+
+		const double samplesPerFrame = sampleRate / std::max(1e-3, options.framesPerSecond);
+		double nextFrame = samplesPerFrame;
+
+		juce::AudioSampleBuffer buffer(std::max(2, numChannels), options.blockSize);
+		juce::MidiBuffer midi;
+		std::uint64_t fed = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+
+		while (true)
+		{
+			buffer.setSize(buffer.getNumChannels(), options.blockSize, false, false, true);
+			const int frames = readBlock(buffer);
+
+			if (frames <= 0)
+				break;
+
+			buffer.setSize(buffer.getNumChannels(), frames, true, false, true);
+
+			// the processor is stereo.
+			juce::AudioSampleBuffer stereo(buffer.getArrayOfWritePointers(), 2, frames);
+			processor->processBlock(stereo, midi);
+			fed += frames;
+
+			if (!waitForDelivery(fed))
+			{
+				std::cerr << "timed out waiting for the asynchronous listeners at sample " << fed << std::endl;
+				return 1;
+			}
+
+			while (fed >= nextFrame)
+			{
+				frame(fed);
+				nextFrame += samplesPerFrame;
+			}
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const double audioSeconds = fed / sampleRate;
+		const auto & perf = stream.getPerfMeasures();
+
+		std::cout
+			<< "processed " << fed << " samples (" << audioSeconds << " s) in " << seconds << " s: "
+			<< (seconds > 0 ? audioSeconds / seconds : 0) << "x real time, "
+			<< (seconds > 0 ? fed / seconds : 0) << " samples/s\n"
+			<< "async usage " << 100 * perf.asyncUsage.load(std::memory_order_relaxed) << "%, "
+			<< "async overhead " << 100 * perf.asyncOverhead.load(std::memory_order_relaxed) << "%" << std::endl;
+
+		if (options.checkTriggers && oscilloscope && !triggersChanged)
+		{
+			std::cerr << "check failed: the trigger columns of oscilloscope.csv never changed" << std::endl;
+			return 1;
+		}
+
+		if (!options.traceFile.empty())
+		{
+		#ifdef SIGNALIZER_TRACING
+			std::ofstream trace(options.traceFile);
+			Tracing::writeChromeTrace(trace);
+		#else
+			std::cerr << "tracing isn't compiled in, define SIGNALIZER_TRACING" << std::endl;
+			return 1;
+		#endif
+		}
+
+		return 0;
+	}
+
+	static bool ParseArguments(int argc, char * argv[], OfflineAnalysis::Options & options)
+	{
+		bool onlySome = false;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const int remaining = argc - i - 1;
+
+			if (arg == "--out" && remaining >= 1)
+			{
+				options.outputDirectory = argv[++i];
+			}
+			else if (arg == "--block" && remaining >= 1)
+			{
+				options.blockSize = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (arg == "--fps" && remaining >= 1)
+			{
+				options.framesPerSecond = std::atof(argv[++i]);
+			}
+			else if (arg == "--size" && remaining >= 2)
+			{
+				options.width = std::max(1, std::atoi(argv[++i]));
+				options.height = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (arg == "--raw" && remaining >= 2)
+			{
+				options.raw = true;
+				options.rawSampleRate = std::atof(argv[++i]);
+				options.rawChannels = std::max(1, std::atoi(argv[++i]));
+			}
+			else if (arg == "--set" && remaining >= 2)
+			{
+				const std::string name = argv[++i];
+				options.parameters.emplace_back(name, static_cast<float>(std::atof(argv[++i])));
+			}
+			else if (arg == "--only" && remaining >= 1)
+			{
+				if (!onlySome)
+				{
+					options.spectrum = options.oscilloscope = options.vectorscope = false;
+					onlySome = true;
+				}
+
+				const std::string view = argv[++i];
+
+				if (view == "spectrum")
+					options.spectrum = true;
+				else if (view == "oscilloscope")
+					options.oscilloscope = true;
+				else if (view == "vectorscope")
+					options.vectorscope = true;
+				else
+					return false;
+			}
+			else if (arg == "--trace" && remaining >= 1)
+			{
+				options.traceFile = argv[++i];
+			}
+			else if (arg == "--check-triggers")
+			{
+				options.checkTriggers = true;
+			}
+			else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0)
+			{
+				return false;
+			}
+			else
+			{
+				options.input = arg;
+			}
+		}
+
+		return !options.input.empty();
+	}
+};
+
+int main(int argc, char * argv[])
+{
+	Signalizer::OfflineAnalysis::Options options;
+
+	if (!Signalizer::ParseArguments(argc, argv, options))
+	{
+		std::cerr << Signalizer::Usage;
+		return 2;
+	}
+
+	// views are components, and need the message manager
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+	Signalizer::OfflineAnalysis analysis(options);
+
+	return analysis.run();
+}
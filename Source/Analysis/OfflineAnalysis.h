@@ -0,0 +1,168 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:OfflineAnalysis.h
+
+		Headless driver of the processor and the analysis of the views, fed from
+		audio files instead of a host.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_OFFLINEANALYSIS_H
+	#define SIGNALIZER_OFFLINEANALYSIS_H
+
+	#include "../Signalizer.h"
+	#include <atomic>
+	#include <cstdint>
+	#include <fstream>
+	#include <memory>
+	#include <string>
+	#include <utility>
+	#include <vector>
+
+	namespace Signalizer
+	{
+		class AudioProcessor;
+		class VectorScope;
+		class Oscilloscope;
+		class Spectrum;
+
+		/// <summary>
+		/// Feeds an audio file through AudioProcessor::processBlock() in fixed block sizes, and drives the
+		/// audio analysis of the views without a window or an OpenGL context. Instead of rendering, the views are
+		/// updated at a fixed frame rate (of the audio timeline), and their results are written as CSV files:
+		///
+		///		spectrum.csv: the mapped magnitudes of every published line graph, with the source being the index of the
+		///			line graph, or of every colour spectrum frame, with the source being "colour"
+		///		oscilloscope.csv: the trigger state, the start of the displayed window and the auto-gain
+		///		vectorscope.csv: the auto-gain, balance and phase filters
+		///
+		/// Each block is waited upon until it has been delivered to the asynchronous listeners, so results don't
+		/// depend on the speed of the machine, while processing still runs as fast as possible.
+		/// </summary>
+		class OfflineAnalysis
+			: private AudioStream::Listener
+		{
+		public:
+
+			struct Options
+			{
+				std::string input;
+				std::string outputDirectory = ".";
+				/// <summary>
+				/// If set, the input is raw interleaved 32-bit floats, otherwise any format juce can read.
+				/// </summary>
+				bool raw = false;
+				double rawSampleRate = 48000;
+				int rawChannels = 2;
+				int blockSize = 512;
+				/// <summary>
+				/// Simulated frames per second of audio, at which views are updated and results are written.
+				/// </summary>
+				double framesPerSecond = 60;
+				/// <summary>
+				/// Size of the simulated views in pixels, which determines f.ex. the resolution of the spectrum.
+				/// </summary>
+				int width = 700, height = 480;
+				bool spectrum = true, oscilloscope = true, vectorscope = true;
+				/// <summary>
+				/// Exported parameter names and normalized values, applied before processing.
+				/// </summary>
+				std::vector<std::pair<std::string, float>> parameters;
+				/// <summary>
+				/// If set, the trace zones are written here as Chrome trace events after processing, see Tracing.h.
+				/// </summary>
+				std::string traceFile;
+				/// <summary>
+				/// If set, the analysis fails if the trigger columns of oscilloscope.csv never changed,
+				/// which they should for any periodic input.
+				/// </summary>
+				bool checkTriggers = false;
+			};
+
+			OfflineAnalysis(const Options & options);
+			~OfflineAnalysis();
+
+			/// <summary>
+			/// Processes the whole input. Returns zero on success, and prints errors otherwise.
+			/// </summary>
+			int run();
+
+		private:
+
+			bool onAsyncAudio(const AudioStream & source, AudioStream::DataType ** buffer, std::size_t numChannels, std::size_t numSamples) override;
+
+			/// <summary>
+			/// Reads the next block of at most options.blockSize frames into the buffer, returning the amount read.
+			/// </summary>
+			int readBlock(juce::AudioSampleBuffer & buffer);
+			bool openInput();
+			bool applyParameters();
+			/// <summary>
+			/// Waits until the asynchronous listeners have received the amount of samples, returning false on a timeout.
+			/// </summary>
+			bool waitForDelivery(std::uint64_t samples);
+			/// <summary>
+			/// Does what the views do for a rendered frame, except rendering: Updates their state from the parameters,
+			/// and picks up the latest results, writing them out.
+			/// </summary>
+			void frame(std::uint64_t position);
+
+			Options options;
+			std::unique_ptr<AudioProcessor> processor;
+			SharedBehaviour globalBehaviour;
+			std::unique_ptr<VectorScope> vectorScope;
+			std::unique_ptr<Oscilloscope> oscilloscope;
+			std::unique_ptr<Spectrum> spectrum;
+
+			std::unique_ptr<juce::AudioFormatReader> reader;
+			std::unique_ptr<juce::FileInputStream> rawInput;
+			std::vector<float> interleaved;
+			double sampleRate;
+			int numChannels;
+			std::int64_t readPosition;
+
+			std::ofstream spectrumOutput, oscilloscopeOutput, vectorScopeOutput;
+
+			/// <summary>
+			/// The trigger columns of the last oscilloscope row, see Options::checkTriggers.
+			/// </summary>
+			struct TriggerColumns
+			{
+				double fundamental, cycleSamples, phase, sampleOffset;
+				std::uint64_t windowStart;
+
+				bool operator == (const TriggerColumns & other) const noexcept
+				{
+					return fundamental == other.fundamental && cycleSamples == other.cycleSamples && phase == other.phase
+						&& sampleOffset == other.sampleOffset && windowStart == other.windowStart;
+				}
+			};
+
+			TriggerColumns lastTriggers;
+			std::size_t oscilloscopeRows;
+			bool triggersChanged;
+			std::atomic<std::uint64_t> deliveredSamples;
+		};
+	};
+#endif
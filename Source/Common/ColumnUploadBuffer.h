@@ -0,0 +1,268 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:ColumnUploadBuffer.h
+
+		Batches column updates of a circularly written texture, so they can be
+		transferred to the GPU in at most two sub-image uploads.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_COLUMNUPLOADBUFFER_H
+	#define SIGNALIZER_COLUMNUPLOADBUFFER_H
+
+	#include <cpl/Common.h>
+	#include <cpl/rendering/COpenGLImage.h>
+	#include <algorithm>
+	#include <cstring>
+	#include <vector>
+
+	#ifdef _WIN32
+		#define SIGNALIZER_GL_CALLTYPE __stdcall
+	#else
+		#define SIGNALIZER_GL_CALLTYPE
+	#endif
+
+	#ifndef GL_PIXEL_UNPACK_BUFFER
+		#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+	#endif
+	#ifndef GL_STREAM_DRAW
+		#define GL_STREAM_DRAW 0x88E0
+	#endif
+	#ifndef GL_UNPACK_ROW_LENGTH
+		#define GL_UNPACK_ROW_LENGTH 0x0CF2
+	#endif
+	#ifndef GL_UNPACK_SKIP_PIXELS
+		#define GL_UNPACK_SKIP_PIXELS 0x0CF4
+	#endif
+	#ifndef GL_MAP_WRITE_BIT
+		#define GL_MAP_WRITE_BIT 0x0002
+	#endif
+	#ifndef GL_MAP_INVALIDATE_BUFFER_BIT
+		#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+	#endif
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Stages columns written to a circular image on the CPU, laid out like the texture.
+		/// Once per frame, all pending columns are copied into a persistent pixel-unpack buffer and
+		/// uploaded to the bound texture with one sub-image call, or two if the columns wrap around.
+		///
+		/// Falls back to uploading from client memory if mapping of buffers isn't supported.
+		/// All functions except resize() and addColumn() must be called with the OpenGL context active.
+		///
+		/// Pixel is the (trivially copyable) client side pixel type, of 1, 2 or 4 bytes.
+		/// </summary>
+		template<typename Pixel>
+		class ColumnUploadBuffer
+		{
+		public:
+
+			static_assert(sizeof(Pixel) == 1 || sizeof(Pixel) == 2 || sizeof(Pixel) == 4, "Unsupported pixel size");
+
+			/// <summary>
+			/// Resizes the staging area, discarding any pending columns.
+			/// </summary>
+			void resize(std::size_t newWidth, std::size_t newHeight)
+			{
+				width = newWidth;
+				height = newHeight;
+				staging.resize(width * height);
+				clear();
+			}
+
+			std::size_t getWidth() const noexcept { return width; }
+			std::size_t getHeight() const noexcept { return height; }
+
+			/// <summary>
+			/// Discards any pending columns.
+			/// </summary>
+			void clear() noexcept
+			{
+				firstPending = numPending = 0;
+			}
+
+			/// <summary>
+			/// Makes the whole image pending, for instance if the texture was recreated.
+			/// </summary>
+			void invalidate() noexcept
+			{
+				firstPending = 0;
+				numPending = width;
+			}
+
+			/// <summary>
+			/// Sets every pixel to the value, making the whole image pending.
+			/// </summary>
+			void fill(const Pixel & value)
+			{
+				std::fill(staging.begin(), staging.end(), value);
+				invalidate();
+			}
+
+			/// <summary>
+			/// Stages a column of getHeight() pixels. Columns are expected to be added consecutively (modulo the width),
+			/// as done when circularly writing an image.
+			/// </summary>
+			void addColumn(std::size_t column, const Pixel * pixels) noexcept
+			{
+				if (column >= width)
+					return;
+
+				if (numPending == 0)
+					firstPending = column;
+
+				for (std::size_t y = 0; y < height; ++y)
+					staging[y * width + column] = pixels[y];
+
+				// if the column overwrote the first pending, the whole image is pending.
+				numPending = std::min(numPending + 1, width);
+			}
+
+			/// <summary>
+			/// Uploads all pending columns to the texture currently bound to GL_TEXTURE_2D,
+			/// with the pixels described by format and type (as for glTexSubImage2D).
+			/// </summary>
+			void upload(juce::OpenGLContext & context, GLenum format, GLenum type)
+			{
+				if (numPending == 0 || width == 0 || height == 0)
+					return;
+
+				if (!hasResolvedFunctions)
+				{
+					mapBufferRange = reinterpret_cast<MapBufferRange>(juce::OpenGLHelpers::getExtensionFunction("glMapBufferRange"));
+					unmapBuffer = reinterpret_cast<UnmapBuffer>(juce::OpenGLHelpers::getExtensionFunction("glUnmapBuffer"));
+					hasResolvedFunctions = true;
+				}
+
+				// columns to upload, as at most two contiguous ranges
+				std::size_t first = numPending == width ? 0 : firstPending;
+				std::size_t firstCount = std::min(numPending, width - first);
+				std::size_t secondCount = numPending - firstCount;
+
+				const char * source = reinterpret_cast<const char *>(staging.data());
+				const std::size_t bytes = staging.size() * sizeof(Pixel);
+				const bool usePixelBuffer = mapBufferRange && unmapBuffer;
+
+				if (usePixelBuffer)
+				{
+					auto & gl = context.extensions;
+
+					if (!pixelBuffer)
+						gl.glGenBuffers(1, &pixelBuffer);
+
+					gl.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+
+					if (bufferSize != bytes)
+					{
+						gl.glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_DRAW);
+						bufferSize = bytes;
+					}
+
+					// only the pending columns are ever read, so the rest of the buffer can be discarded
+					// (avoiding synchronization with the previous upload).
+					auto mapped = static_cast<char *>(mapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+					if (mapped)
+					{
+						auto copyRange = [&](std::size_t column, std::size_t count)
+						{
+							for (std::size_t y = 0; y < height; ++y)
+							{
+								const auto offset = (y * width + column) * sizeof(Pixel);
+								std::memcpy(mapped + offset, source + offset, count * sizeof(Pixel));
+							}
+						};
+
+						copyRange(first, firstCount);
+						if (secondCount)
+							copyRange(0, secondCount);
+
+						unmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+						// offsets are now relative to the bound buffer
+						source = nullptr;
+					}
+					else
+					{
+						gl.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+					}
+				}
+
+				glPixelStorei(GL_UNPACK_ALIGNMENT, static_cast<GLint>(sizeof(Pixel)));
+				glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(width));
+
+				auto uploadRange = [&](std::size_t column, std::size_t count)
+				{
+					glPixelStorei(GL_UNPACK_SKIP_PIXELS, static_cast<GLint>(column));
+					glTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(column), 0, static_cast<GLsizei>(count), static_cast<GLsizei>(height), format, type, source);
+				};
+
+				uploadRange(first, firstCount);
+				if (secondCount)
+					uploadRange(0, secondCount);
+
+				glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+				glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+				if (usePixelBuffer)
+					context.extensions.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+				clear();
+			}
+
+			/// <summary>
+			/// Deletes the pixel buffer. Call before the context is destroyed.
+			/// </summary>
+			void release(juce::OpenGLContext & context)
+			{
+				if (pixelBuffer)
+				{
+					context.extensions.glDeleteBuffers(1, &pixelBuffer);
+					pixelBuffer = 0;
+				}
+
+				bufferSize = 0;
+				hasResolvedFunctions = false;
+				mapBufferRange = nullptr;
+				unmapBuffer = nullptr;
+			}
+
+		private:
+
+			typedef void * (SIGNALIZER_GL_CALLTYPE * MapBufferRange)(GLenum, GLintptr, GLsizeiptr, GLbitfield);
+			typedef GLboolean (SIGNALIZER_GL_CALLTYPE * UnmapBuffer)(GLenum);
+
+			std::vector<Pixel> staging;
+			std::size_t width = 0, height = 0;
+			std::size_t firstPending = 0, numPending = 0;
+			std::size_t bufferSize = 0;
+			GLuint pixelBuffer = 0;
+			bool hasResolvedFunctions = false;
+			MapBufferRange mapBufferRange = nullptr;
+			UnmapBuffer unmapBuffer = nullptr;
+		};
+
+	};
+#endif
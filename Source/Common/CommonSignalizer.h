@@ -35,8 +35,11 @@
 	#include <cpl/gui/GUI.h>
 	#include <cpl/CAudioStream.h>
 	#include <complex>
+	#include <atomic>
+	#include <array>
 	#include <cpl/infrastructure/parameters/ParameterSystem.h>
 	#include "SignalizerDesign.h"
+	#include "Latency.h"
 
 	namespace Signalizer
 	{
@@ -92,18 +95,23 @@
 		{
 		public:
 
-			SystemView(AudioStream & audioStream, ParameterSet::AutomatedProcessor & automatedProcessor)
-				: stream(audioStream), processor(automatedProcessor)
+			SystemView(AudioStream & audioStream, ParameterSet::AutomatedProcessor & automatedProcessor, const BlockTimeline & blockTimeline)
+				: stream(audioStream), processor(automatedProcessor), timeline(blockTimeline)
 			{
 
 			}
 
 			ParameterSet::AutomatedProcessor & getProcessor() noexcept { return processor; }
 			AudioStream & getAudioStream() noexcept { return stream; }
+			/// <summary>
+			/// When the blocks of the audio stream entered the processor, see Latency.h.
+			/// </summary>
+			const BlockTimeline & getBlockTimeline() const noexcept { return timeline; }
 
 		private:
 			AudioStream & stream;
 			ParameterSet::AutomatedProcessor & processor;
+			const BlockTimeline & timeline;
 		};
 
 		struct ChoiceParameter
@@ -700,6 +708,75 @@
 				FDeserializer deserializer;
 			};
 
+		/// <summary>
+		/// Wait-free single producer, single consumer exchange of a value, where the consumer only ever
+		/// sees the latest complete value published by the producer. Neither side ever blocks or copies.
+		/// </summary>
+		template<typename T>
+		class ConcurrentTripleBuffer
+		{
+		public:
+
+			ConcurrentTripleBuffer()
+				: frontIndex(0), middleIndex(1), backIndex(2)
+			{
+
+			}
+
+			/// <summary>
+			/// The value the producer may write to. Only accessible by the producer.
+			/// </summary>
+			T & back() noexcept { return slots[backIndex]; }
+
+			/// <summary>
+			/// Exchanges the back buffer with the middle buffer, making it available to the consumer.
+			/// Only accessible by the producer.
+			/// </summary>
+			void publish() noexcept
+			{
+				backIndex = middleIndex.exchange(backIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+			}
+
+			/// <summary>
+			/// Picks up any newly published value. Returns true if the front buffer changed.
+			/// Only accessible by the consumer.
+			/// </summary>
+			bool acquireLatest() noexcept
+			{
+				if (!(middleIndex.load(std::memory_order_relaxed) & freshBit))
+					return false;
+
+				frontIndex = middleIndex.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+				return true;
+			}
+
+			/// <summary>
+			/// The latest value picked up by acquireLatest(). Only accessible by the consumer.
+			/// </summary>
+			const T & front() const noexcept { return slots[frontIndex]; }
+
+			/// <summary>
+			/// Provides access to all buffers, for resizing etc.
+			/// Not thread safe: Both the producer and the consumer must be halted.
+			/// </summary>
+			template<typename Functor>
+			void forEach(Functor f)
+			{
+				for (auto & slot : slots)
+					f(slot);
+			}
+
+		private:
+
+			static const int freshBit = 0x4;
+			static const int indexMask = 0x3;
+
+			std::array<T, 3> slots;
+			int frontIndex;
+			std::atomic<int> middleIndex;
+			int backIndex;
+		};
+
 		struct ParameterMap
 		{
 			void insert(std::pair<std::string, std::unique_ptr<ProcessorState>> entry)
@@ -0,0 +1,260 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:Contention.h
+
+		Wait and hold times of the locks shared between the asynchronous audio
+		listeners and the rendering threads.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_CONTENTION_H
+	#define SIGNALIZER_CONTENTION_H
+
+	#include <cpl/CMutex.h>
+	#include <algorithm>
+	#include <array>
+	#include <atomic>
+	#include <chrono>
+	#include <cstdint>
+	#include <cstdio>
+	#include <string>
+	#include "Tracing.h"
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Statistics of the acquisitions of a lock, per owning thread. Safe to read from any thread while being written.
+		/// </summary>
+		class LockStatistics
+		{
+		public:
+
+			enum class Owner
+			{
+				/// <summary>
+				/// The thread calling onAsyncAudio.
+				/// </summary>
+				AsyncAudio,
+				/// <summary>
+				/// The thread rendering the view, and handling its flag updates. The offline analysis and benchmarks
+				/// acquire as this owner too, standing in for the renderer.
+				/// </summary>
+				Rendering,
+				End
+			};
+
+			/// <summary>
+			/// Acquisitions waiting longer than this (in nanoseconds) are considered contended.
+			/// Uncontended acquisitions take well below it, including the timing.
+			/// </summary>
+			static constexpr std::int64_t contentionThreshold = 10000;
+
+			struct Snapshot
+			{
+				std::uint64_t acquisitions, contended;
+				/// <summary>
+				/// In milliseconds.
+				/// </summary>
+				double totalWait, maxWait, totalHold, maxHold;
+
+				double meanWait() const noexcept { return acquisitions ? totalWait / acquisitions : 0; }
+				double meanHold() const noexcept { return acquisitions ? totalHold / acquisitions : 0; }
+			};
+
+			/// <summary>
+			/// name is shown in the diagnostics, and waitZone names the waits in traces. Both must be string literals.
+			/// </summary>
+			LockStatistics(const char * lockName, const char * waitZoneName)
+				: name(lockName)
+				, waitZone(waitZoneName)
+			{
+			}
+
+			Snapshot get(Owner owner) const noexcept
+			{
+				auto & o = owners[static_cast<std::size_t>(owner)];
+
+				return {
+					o.acquisitions.load(std::memory_order_relaxed),
+					o.contended.load(std::memory_order_relaxed),
+					o.totalWait.load(std::memory_order_relaxed) * 1e-6,
+					o.maxWait.load(std::memory_order_relaxed) * 1e-6,
+					o.totalHold.load(std::memory_order_relaxed) * 1e-6,
+					o.maxHold.load(std::memory_order_relaxed) * 1e-6
+				};
+			}
+
+			/// <summary>
+			/// A single line for the diagnostics overlays.
+			/// </summary>
+			std::string describe(Owner owner) const
+			{
+				static const char * ownerNames[] = { "async audio", "rendering" };
+
+				const auto s = get(owner);
+				char text[300];
+
+				sprintf(text, "%s, %s: %llu of %llu contended, wait %.3f ms (max %.3f ms), hold %.3f ms (max %.3f ms)",
+					name, ownerNames[static_cast<std::size_t>(owner)],
+					static_cast<unsigned long long>(s.contended), static_cast<unsigned long long>(s.acquisitions),
+					s.meanWait(), s.maxWait, s.meanHold(), s.maxHold);
+
+				return text;
+			}
+
+			const char * getWaitZone() const noexcept { return waitZone; }
+
+			static std::int64_t now() noexcept
+			{
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			}
+
+			void recordWait(Owner owner, std::int64_t wait) noexcept
+			{
+				auto & o = owners[static_cast<std::size_t>(owner)];
+
+				o.acquisitions.fetch_add(1, std::memory_order_relaxed);
+				o.totalWait.fetch_add(wait, std::memory_order_relaxed);
+
+				if (wait > contentionThreshold)
+					o.contended.fetch_add(1, std::memory_order_relaxed);
+
+				storeMax(o.maxWait, wait);
+			}
+
+			void recordHold(Owner owner, std::int64_t hold) noexcept
+			{
+				auto & o = owners[static_cast<std::size_t>(owner)];
+
+				o.totalHold.fetch_add(hold, std::memory_order_relaxed);
+				storeMax(o.maxHold, hold);
+			}
+
+		private:
+
+			struct PerOwner
+			{
+				std::atomic<std::uint64_t> acquisitions { 0 }, contended { 0 };
+				/// <summary>
+				/// In nanoseconds.
+				/// </summary>
+				std::atomic<std::int64_t> totalWait { 0 }, maxWait { 0 }, totalHold { 0 }, maxHold { 0 };
+			};
+
+			static void storeMax(std::atomic<std::int64_t> & maximum, std::int64_t value) noexcept
+			{
+				auto current = maximum.load(std::memory_order_relaxed);
+				while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed));
+			}
+
+			const char * name, * waitZone;
+			std::array<PerOwner, static_cast<std::size_t>(Owner::End)> owners;
+		};
+
+		/// <summary>
+		/// A cpl::CMutex::Lockable keeping statistics of acquisitions through MeasuredMutex.
+		/// Acquisitions through a plain cpl::CMutex are not measured.
+		/// </summary>
+		class MeasuredLockable : public cpl::CMutex::Lockable
+		{
+		public:
+
+			MeasuredLockable(const char * name, const char * waitZone)
+				: statistics(name, waitZone)
+			{
+			}
+
+			LockStatistics statistics;
+		};
+
+		/// <summary>
+		/// Replaces cpl::CMutex for MeasuredLockables, recording the wait for and hold of the lock on behalf of the owner.
+		/// </summary>
+		class MeasuredMutex
+		{
+		public:
+
+			MeasuredMutex(LockStatistics::Owner lockOwner) noexcept
+				: owner(lockOwner)
+				, resource(nullptr)
+				, acquired(0)
+			{
+			}
+
+			MeasuredMutex(MeasuredLockable & lockable, LockStatistics::Owner lockOwner)
+				: MeasuredMutex(lockOwner)
+			{
+				acquire(lockable);
+			}
+
+			/// <summary>
+			/// Has the semantics of cpl::CMutex::acquire. Acquiring the currently held lockable again is not measured.
+			/// </summary>
+			void acquire(MeasuredLockable & lockable)
+			{
+				if (resource == &lockable)
+				{
+					mutex.acquire(lockable);
+					return;
+				}
+
+				finishHold();
+
+				const auto start = LockStatistics::now();
+
+				{
+				#ifdef SIGNALIZER_TRACING
+					Tracing::Zone zone(lockable.statistics.getWaitZone());
+				#endif
+					mutex.acquire(lockable);
+				}
+
+				acquired = LockStatistics::now();
+				lockable.statistics.recordWait(owner, acquired - start);
+				resource = &lockable;
+			}
+
+			~MeasuredMutex()
+			{
+				finishHold();
+			}
+
+			MeasuredMutex(const MeasuredMutex &) = delete;
+			MeasuredMutex & operator = (const MeasuredMutex &) = delete;
+
+		private:
+
+			void finishHold() noexcept
+			{
+				if (resource)
+					resource->statistics.recordHold(owner, LockStatistics::now() - acquired);
+			}
+
+			LockStatistics::Owner owner;
+			MeasuredLockable * resource;
+			std::int64_t acquired;
+			cpl::CMutex mutex;
+		};
+	};
+#endif
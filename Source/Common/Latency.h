@@ -0,0 +1,259 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:Latency.h
+
+		Measurement of the time from audio entering the processor, until the
+		frame in which it is first drawn.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_LATENCY_H
+	#define SIGNALIZER_LATENCY_H
+
+	#include <algorithm>
+	#include <array>
+	#include <atomic>
+	#include <chrono>
+	#include <cstdint>
+	#include "Tracing.h"
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// The wall time at which each block entered the audio stream, indexed by the steady sample clock
+		/// of the stream (the clock of AudioStream playheads, counting every sample passed to the stream).
+		///
+		/// Written wait-free by the audio thread, and read by any thread. Readers can look up blocks of
+		/// about the last capacity blocks.
+		///
+		/// The timeline counts the samples itself, so it must be reset whenever the stream's steady clock restarts,
+		/// which is when the stream is reinitialized.
+		/// </summary>
+		class BlockTimeline
+		{
+		public:
+
+			static constexpr std::size_t capacity = 4096;
+
+			/// <summary>
+			/// Steady wall time in nanoseconds, with an arbitrary origin.
+			/// </summary>
+			static std::int64_t now() noexcept
+			{
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			}
+
+			/// <summary>
+			/// Records that a block of numSamples entered the stream now. Only called by the audio thread,
+			/// before passing the block to the stream.
+			/// </summary>
+			void stamp(std::size_t numSamples) noexcept
+			{
+				const auto index = ended.load(std::memory_order_relaxed);
+				auto & slot = slots[index % capacity];
+
+				position += numSamples;
+
+				begun.store(index + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+
+				slot.end.store(position, std::memory_order_relaxed);
+				slot.time.store(now(), std::memory_order_relaxed);
+
+				ended.store(index + 1, std::memory_order_release);
+			}
+
+			/// <summary>
+			/// Restarts the timeline from a steady clock of zero, forgetting every block. Only called while the audio thread
+			/// isn't stamping. Lookups racing with this fail.
+			/// </summary>
+			void reset() noexcept
+			{
+				// readers see every block as overwritten while they're cleared
+				const auto index = ended.load(std::memory_order_relaxed) + capacity;
+
+				begun.store(index, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+
+				for (auto & slot : slots)
+				{
+					slot.end.store(0, std::memory_order_relaxed);
+					slot.time.store(0, std::memory_order_relaxed);
+				}
+
+				position = 0;
+				ended.store(index, std::memory_order_release);
+			}
+
+			/// <summary>
+			/// Returns whether the timeline has stamped the samples before the steady clock position, and still has them.
+			/// For checking that the timeline follows the stream's steady clock, from the asynchronous listeners.
+			/// </summary>
+			bool hasStamped(std::uint64_t clock) const noexcept
+			{
+				std::int64_t entryTime;
+				return clock == 0 || find(clock - 1, entryTime);
+			}
+
+			/// <summary>
+			/// Finds the wall time at which the sample at the steady clock position entered the stream.
+			/// Returns false if it hasn't entered yet, or is older than the timeline.
+			/// </summary>
+			bool find(std::uint64_t sample, std::int64_t & entryTime) const noexcept
+			{
+				const auto end = ended.load(std::memory_order_acquire);
+				const auto first = end > capacity ? end - capacity : 0;
+
+				if (first == end)
+					return false;
+
+				// the first block whose end is past the sample
+				auto low = first, high = end;
+
+				while (low < high)
+				{
+					const auto middle = low + (high - low) / 2;
+
+					if (slots[middle % capacity].end.load(std::memory_order_relaxed) > sample)
+						high = middle;
+					else
+						low = middle + 1;
+				}
+
+				if (low == end || (low == first && first != 0))
+					return false;
+
+				const auto time = slots[low % capacity].time.load(std::memory_order_relaxed);
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+
+				// the search may have read blocks being overwritten meanwhile (see Tracing.h)
+				const auto begin = begun.load(std::memory_order_relaxed);
+
+				if (begin > capacity && first < begin - capacity)
+					return false;
+
+				entryTime = time;
+				return true;
+			}
+
+		private:
+
+			struct Slot
+			{
+				/// <summary>
+				/// The steady clock after the block.
+				/// </summary>
+				std::atomic<std::uint64_t> end { 0 };
+				std::atomic<std::int64_t> time { 0 };
+			};
+
+			std::uint64_t position = 0;
+			std::atomic<std::uint64_t> begun { 0 }, ended { 0 };
+			std::array<Slot, capacity> slots;
+		};
+
+		/// <summary>
+		/// Latencies of the frames of a view, from the newest sample of a frame entering the stream until the frame
+		/// was drawn. Percentiles are over the last history measurements. Only accessed by the rendering thread.
+		/// </summary>
+		class LatencyMeter
+		{
+		public:
+
+			static constexpr std::size_t history = 512;
+
+			/// <summary>
+			/// Names of the trace counters of the measurements, see Tracing.h. Must be string literals.
+			/// </summary>
+			struct TraceNames
+			{
+				const char * latest, * p50, * p99;
+			};
+
+			LatencyMeter(const TraceNames & names)
+				: traceNames(names)
+			{
+			}
+
+			/// <summary>
+			/// Call for every rendered frame, with the steady clock after the newest sample drawn in the frame.
+			/// Only the first frame drawing a sample is measured.
+			/// </summary>
+			void frameDrawn(const BlockTimeline & timeline, std::uint64_t drawnClock) noexcept
+			{
+				if (drawnClock == 0 || drawnClock == lastClock)
+					return;
+
+				lastClock = drawnClock;
+
+				std::int64_t entryTime;
+
+				if (!timeline.find(drawnClock - 1, entryTime))
+					return;
+
+				latest = (BlockTimeline::now() - entryTime) * 1e-6;
+				measurements[written++ % history] = latest;
+
+			#ifdef SIGNALIZER_TRACING
+				SIGNALIZER_TRACE_COUNTER(traceNames.latest, latest);
+				SIGNALIZER_TRACE_COUNTER(traceNames.p50, getPercentile(0.5));
+				SIGNALIZER_TRACE_COUNTER(traceNames.p99, getPercentile(0.99));
+			#endif
+			}
+
+			/// <summary>
+			/// The p'th percentile (0 - 1) of the latencies in milliseconds, or zero if nothing was measured yet.
+			/// Not intended for every frame, unless diagnostics are enabled.
+			/// </summary>
+			double getPercentile(double p) const noexcept
+			{
+				const auto size = std::min<std::size_t>(written, history);
+
+				if (!size)
+					return 0;
+
+				std::copy(measurements.begin(), measurements.begin() + size, sorted.begin());
+				const auto rank = sorted.begin() + std::min(size - 1, static_cast<std::size_t>(p * size));
+				std::nth_element(sorted.begin(), rank, sorted.begin() + size);
+
+				return *rank;
+			}
+
+			/// <summary>
+			/// The latency of the last measured frame, in milliseconds.
+			/// </summary>
+			double getLatest() const noexcept { return latest; }
+
+		private:
+
+			TraceNames traceNames;
+			std::array<double, history> measurements {};
+			mutable std::array<double, history> sorted {};
+			std::size_t written = 0;
+			std::uint64_t lastClock = 0;
+			double latest = 0;
+		};
+	};
+#endif
@@ -0,0 +1,148 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:PolyphaseLanczos.h
+
+		Lanczos interpolation through a table of precomputed kernels for
+		quantized fractional delays, evaluated as vectorized dot products.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_POLYPHASELANCZOS_H
+	#define SIGNALIZER_POLYPHASELANCZOS_H
+
+	#include <cpl/Common.h>
+	#include <cpl/simd.h>
+	#include <cmath>
+	#include <cstdint>
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Interpolates between samples using a Lanczos kernel of KernelSize lobes.
+		/// The kernel is tabulated for Phases + 1 evenly spaced fractional delays in [0, 1], so no
+		/// trigonometry is evaluated per output. Each tabulated kernel is normalized to unity gain.
+		///
+		/// Rows are padded with zeroes to getStride() taps, a multiple of any vector size.
+		/// </summary>
+		template<typename T, std::size_t KernelSize, std::size_t Phases = 512>
+		class PolyphaseLanczos
+		{
+		public:
+
+			static_assert(KernelSize > 0, "Kernel size must be positive");
+
+			/// <summary>
+			/// The amount of samples contributing to an output.
+			/// </summary>
+			static const std::size_t taps = 2 * KernelSize;
+
+			/// <summary>
+			/// Amount of taps stored per row, and the amount of samples read by evaluate().
+			/// </summary>
+			static constexpr std::size_t getStride() noexcept { return (taps + padding - 1) & ~(padding - 1); }
+
+			PolyphaseLanczos()
+				: table((Phases + 1) * getStride())
+			{
+				const double pi = cpl::simd::consts<double>::pi;
+
+				auto sinc = [pi](double x)
+				{
+					return x == 0 ? 1.0 : std::sin(pi * x) / (pi * x);
+				};
+
+				for (std::size_t p = 0; p <= Phases; ++p)
+				{
+					T * row = table.data() + p * getStride();
+					const double fraction = static_cast<double>(p) / Phases;
+					double sum = 0;
+
+					// tap j weights the sample at floor(position) + j - (KernelSize - 1)
+					for (std::size_t j = 0; j < taps; ++j)
+					{
+						const double x = fraction + (KernelSize - 1) - static_cast<double>(j);
+						const double weight = std::abs(x) < KernelSize ? sinc(x) * sinc(x / KernelSize) : 0;
+						row[j] = static_cast<T>(weight);
+						sum += weight;
+					}
+
+					for (std::size_t j = 0; j < taps; ++j)
+						row[j] = static_cast<T>(row[j] / sum);
+
+					for (std::size_t j = taps; j < getStride(); ++j)
+						row[j] = 0;
+				}
+			}
+
+			/// <summary>
+			/// Interpolates the samples at the fractional position. The samples from
+			/// floor(position) - (KernelSize - 1) until getStride() samples after that must be readable.
+			/// </summary>
+			template<typename V>
+			inline T interpolate(const T * samples, double position) const noexcept
+			{
+				const auto base = static_cast<std::ptrdiff_t>(std::floor(position));
+				const auto phase = static_cast<std::size_t>((position - base) * Phases + 0.5);
+
+				return evaluate<V>(samples + base - static_cast<std::ptrdiff_t>(KernelSize - 1), phase);
+			}
+
+			/// <summary>
+			/// Returns the dot product of the getStride() samples in window with the kernel of the phase (0 ... Phases inclusive).
+			/// </summary>
+			template<typename V>
+			inline T evaluate(const T * window, std::size_t phase) const noexcept
+			{
+				using namespace cpl::simd;
+
+				const T * row = table.data() + phase * getStride();
+				const std::size_t vectorLength = elements_of<V>::value;
+
+				V sum = zero<V>();
+
+				for (std::size_t j = 0; j < getStride(); j += vectorLength)
+					sum = sum + loadu<V>(window + j) * load<V>(row + j);
+
+				alignas(V) T lanes[vectorLength];
+				*reinterpret_cast<V *>(lanes) = sum;
+
+				T result = 0;
+				for (std::size_t i = 0; i < vectorLength; ++i)
+					result += lanes[i];
+
+				return result;
+			}
+
+		private:
+
+			/// <summary>
+			/// Enough to hold whole vectors of any ISA, which also keeps rows aligned.
+			/// </summary>
+			static const std::size_t padding = 32 / sizeof(T);
+
+			cpl::aligned_vector<T, 32> table;
+		};
+	};
+
+#endif
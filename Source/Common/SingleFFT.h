@@ -0,0 +1,205 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:SingleFFT.h
+
+		Single precision radix-2 fourier transform with vectorized butterflies,
+		for analysis where double precision is overkill.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_SINGLEFFT_H
+	#define SIGNALIZER_SINGLEFFT_H
+
+	#include <cpl/Common.h>
+	#include <cpl/simd.h>
+	#include <complex>
+	#include <cstdint>
+	#include <vector>
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// In-place, forward complex single precision FFT of power-of-two sizes.
+		/// Output ordering, scaling and sign convention matches signaldust::DustFFT_fwdDa.
+		///
+		/// Internally, the transform is done on a split real/imaginary representation, so
+		/// butterflies are plain vector arithmetic for any ISA.
+		/// </summary>
+		class SingleFFT
+		{
+		public:
+
+			SingleFFT() : size(0), stages(0) {}
+
+			/// <summary>
+			/// Prepares tables for transforms of any power-of-two size up to and including maxSize.
+			/// Allocates, so don't call this from any real-time thread.
+			/// </summary>
+			void setMaxSize(std::size_t maxSize)
+			{
+				std::size_t newStages = 0;
+				while ((std::size_t(1) << newStages) < maxSize)
+					newStages++;
+
+				size = maxSize ? std::size_t(1) << newStages : 0;
+				stages = newStages;
+
+				bitReversal.resize(size);
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					std::uint32_t reversed = 0;
+					for (std::size_t b = 0; b < stages; ++b)
+						reversed |= static_cast<std::uint32_t>(((i >> b) & 1) << (stages - 1 - b));
+					bitReversal[i] = reversed;
+				}
+
+				// twiddles for each stage, concatenated in order of increasing butterfly span.
+				// the stage with span h uses e^(-i * pi * j / h) for j = 0 ... h - 1
+				twiddleReal.resize(size ? size - 1 : 0);
+				twiddleImag.resize(size ? size - 1 : 0);
+
+				std::size_t offset = 0;
+				for (std::size_t half = 1; half < size; half <<= 1)
+				{
+					for (std::size_t j = 0; j < half; ++j)
+					{
+						auto const w = std::polar(1.0, -cpl::simd::consts<double>::pi * j / half);
+						twiddleReal[offset + j] = static_cast<float>(w.real());
+						twiddleImag[offset + j] = static_cast<float>(w.imag());
+					}
+					offset += half;
+				}
+
+				real.resize(size);
+				imag.resize(size);
+			}
+
+			std::size_t getMaxSize() const noexcept { return size; }
+
+			/// <summary>
+			/// Transforms N complex samples in place. N must be a power of two, no larger than getMaxSize().
+			/// </summary>
+			template<typename ISA>
+			void forward(std::complex<float> * data, std::size_t N) noexcept
+			{
+				typedef typename ISA::V V;
+				using namespace cpl::simd;
+
+				if (N < 2 || N > size)
+					return;
+
+				// the bit reversal of indices for a smaller transform are the leading bits of the larger one.
+				std::size_t shift = 0;
+				while ((N << shift) < size)
+					shift++;
+
+				float * const re = real.data();
+				float * const im = imag.data();
+
+				for (std::size_t i = 0; i < N; ++i)
+				{
+					auto const & source = data[bitReversal[i] >> shift];
+					re[i] = source.real();
+					im[i] = source.imag();
+				}
+
+				const std::size_t vectorLength = elements_of<V>::value;
+				const float * twr = twiddleReal.data();
+				const float * twi = twiddleImag.data();
+
+				for (std::size_t half = 1; half < N; half <<= 1)
+				{
+					if (half >= vectorLength)
+					{
+						for (std::size_t block = 0; block < N; block += half << 1)
+						{
+							for (std::size_t j = 0; j < half; j += vectorLength)
+							{
+								float * const ar = re + block + j;
+								float * const ai = im + block + j;
+								float * const br = ar + half;
+								float * const bi = ai + half;
+
+								const V wr = loadu<V>(twr + j);
+								const V wi = loadu<V>(twi + j);
+
+								const V vbr = load<V>(br);
+								const V vbi = load<V>(bi);
+								const V tr = vbr * wr - vbi * wi;
+								const V ti = vbr * wi + vbi * wr;
+
+								const V var = load<V>(ar);
+								const V vai = load<V>(ai);
+
+								storeAligned(ar, var + tr);
+								storeAligned(ai, vai + ti);
+								storeAligned(br, var - tr);
+								storeAligned(bi, vai - ti);
+							}
+						}
+					}
+					else
+					{
+						for (std::size_t block = 0; block < N; block += half << 1)
+						{
+							for (std::size_t j = 0; j < half; ++j)
+							{
+								const std::size_t a = block + j, b = a + half;
+
+								const float tr = re[b] * twr[j] - im[b] * twi[j];
+								const float ti = re[b] * twi[j] + im[b] * twr[j];
+
+								re[b] = re[a] - tr;
+								im[b] = im[a] - ti;
+								re[a] += tr;
+								im[a] += ti;
+							}
+						}
+					}
+
+					twr += half;
+					twi += half;
+				}
+
+				for (std::size_t i = 0; i < N; ++i)
+				{
+					data[i] = std::complex<float>(re[i], im[i]);
+				}
+			}
+
+		private:
+
+			template<typename V>
+			static void storeAligned(float * where, V what) noexcept
+			{
+				*reinterpret_cast<V *>(where) = what;
+			}
+
+			std::size_t size, stages;
+			std::vector<std::uint32_t> bitReversal;
+			cpl::aligned_vector<float, 32> twiddleReal, twiddleImag, real, imag;
+		};
+
+	};
+#endif
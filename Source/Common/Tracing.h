@@ -0,0 +1,379 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:Tracing.h
+
+		Scoped trace zones and counters on the audio, analysis and rendering
+		paths, exported as Chrome trace events (chrome://tracing, Perfetto).
+		Only compiled in with SIGNALIZER_TRACING defined, otherwise the macros
+		expand to nothing.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_TRACING_H
+	#define SIGNALIZER_TRACING_H
+
+	#ifdef SIGNALIZER_TRACING
+
+		#include <algorithm>
+		#include <array>
+		#include <atomic>
+		#include <chrono>
+		#include <cstdint>
+		#include <memory>
+		#include <mutex>
+		#include <ostream>
+		#include <string>
+		#include <vector>
+
+		namespace Signalizer
+		{
+			/// <summary>
+			/// Records zones and counter values into a ring buffer per thread, which is written wait-free by its thread.
+			/// Buffers are owned by a process-wide registry, so all instances of the plugin are traced on the
+			/// same timeline, and zones of threads that since exited can still be written out.
+			///
+			/// Only registered threads are traced, events of other threads are discarded. Registering allocates,
+			/// so real-time threads instead adopt a buffer reserved for them beforehand, see adoptReservedBuffer().
+			/// Zone and counter names must be string literals.
+			/// </summary>
+			class Tracing
+			{
+			public:
+
+				/// <summary>
+				/// Zones kept per thread. Older zones are overwritten.
+				/// </summary>
+				static constexpr std::size_t capacity = 1 << 15;
+
+				/// <summary>
+				/// Records the lifetime of the object as a zone of the calling thread.
+				/// </summary>
+				class Zone
+				{
+				public:
+
+					Zone(const char * zoneName) noexcept
+						: name(zoneName)
+						, start(now())
+					{
+					}
+
+					~Zone()
+					{
+						if (auto buffer = getThreadBuffer())
+							buffer->record(name, start, now() - start, 0);
+					}
+
+					Zone(const Zone &) = delete;
+					Zone & operator = (const Zone &) = delete;
+
+				private:
+
+					const char * name;
+					std::int64_t start;
+				};
+
+				/// <summary>
+				/// Records the value of a counter at this time. Counters are drawn as graphs over time.
+				/// </summary>
+				static void counter(const char * name, double value) noexcept
+				{
+					if (auto buffer = getThreadBuffer())
+						buffer->record(name, now(), -1, value);
+				}
+
+				/// <summary>
+				/// Registers the calling thread with the name, if it isn't already. Allocates the buffer of the thread,
+				/// so not for real-time threads.
+				/// </summary>
+				static void registerThread(const char * name)
+				{
+					auto & buffer = getThreadBuffer();
+
+					if (!buffer)
+						buffer = createBuffer();
+
+					nameBuffer(*buffer, name);
+				}
+
+				/// <summary>
+				/// Reserves a buffer for the next real-time thread calling adoptReservedBuffer(), unless one is reserved already.
+				/// Call before real-time processing starts, from a thread that may allocate.
+				/// </summary>
+				static void reserveBuffer()
+				{
+					auto & reserved = getReservedBuffer();
+
+					if (reserved.load(std::memory_order_acquire))
+						return;
+
+					ThreadBuffer * expected = nullptr;
+					// if someone else reserved one meanwhile, this one just stays empty
+					reserved.compare_exchange_strong(expected, createBuffer(), std::memory_order_acq_rel);
+				}
+
+				/// <summary>
+				/// Registers the calling thread with the buffer reserved by reserveBuffer(), if it isn't registered already.
+				/// Wait-free, and if no buffer is reserved the thread isn't traced.
+				/// </summary>
+				static void adoptReservedBuffer(const char * name) noexcept
+				{
+					auto & buffer = getThreadBuffer();
+
+					if (!buffer)
+						buffer = getReservedBuffer().exchange(nullptr, std::memory_order_acq_rel);
+
+					if (buffer)
+						nameBuffer(*buffer, name);
+				}
+
+				/// <summary>
+				/// Writes the zones of every thread as a Chrome trace event JSON object. Safe to call from any thread,
+				/// while zones are being recorded.
+				/// </summary>
+				static void writeChromeTrace(std::ostream & output)
+				{
+					std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+					{
+						auto & registry = getRegistry();
+						std::lock_guard<std::mutex> lock(registry.mutex);
+						buffers = registry.buffers;
+					}
+
+					output << "{\n\"displayTimeUnit\": \"ns\",\n\"traceEvents\": [\n";
+					output << "{ \"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": { \"name\": \"Signalizer\" } }";
+
+					std::vector<Event> events;
+
+					for (auto & buffer : buffers)
+					{
+						if (auto name = buffer->name.load(std::memory_order_relaxed))
+						{
+							output << ",\n{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->id
+								<< ", \"args\": { \"name\": \"" << name << "\" } }";
+						}
+
+						buffer->copyInto(events);
+
+						for (auto & e : events)
+						{
+							output << ",\n{ \"name\": \"" << e.name << "\", \"cat\": \"signalizer\", \"pid\": 1, \"tid\": " << buffer->id
+								<< ", \"ts\": " << e.start / 1000 << '.' << Fraction(e.start);
+
+							if (e.isCounter())
+								output << ", \"ph\": \"C\", \"args\": { \"value\": " << e.value << " } }";
+							else
+								output << ", \"ph\": \"X\", \"dur\": " << e.duration / 1000 << '.' << Fraction(e.duration) << " }";
+						}
+					}
+
+					output << "\n]\n}\n";
+				}
+
+			private:
+
+				struct Event
+				{
+					const char * name;
+					std::int64_t start;
+					/// <summary>
+					/// Negative for counters.
+					/// </summary>
+					std::int64_t duration;
+					double value;
+
+					bool isCounter() const noexcept { return duration < 0; }
+				};
+
+				/// <summary>
+				/// The last three digits of nanoseconds, as a fraction of microseconds.
+				/// </summary>
+				struct Fraction
+				{
+					Fraction(std::int64_t nanoseconds) : value(static_cast<int>(nanoseconds % 1000)) {}
+
+					friend std::ostream & operator << (std::ostream & output, const Fraction & f)
+					{
+						const char digits[] = { char('0' + f.value / 100), char('0' + f.value / 10 % 10), char('0' + f.value % 10), '\0' };
+						return output << digits;
+					}
+
+					int value;
+				};
+
+				/// <summary>
+				/// Single writer ring buffer, read as a sequence lock: the writer announces the zone it is about to overwrite,
+				/// and readers discard what may have been overwritten while they were copying.
+				/// </summary>
+				class ThreadBuffer
+				{
+				public:
+
+					ThreadBuffer(int threadID)
+						: id(threadID)
+					{
+					}
+
+					void record(const char * eventName, std::int64_t start, std::int64_t duration, double value) noexcept
+					{
+						const auto index = ended.load(std::memory_order_relaxed);
+						auto & slot = slots[index % capacity];
+
+						begun.store(index + 1, std::memory_order_relaxed);
+						std::atomic_thread_fence(std::memory_order_release);
+
+						slot.name.store(eventName, std::memory_order_relaxed);
+						slot.start.store(start, std::memory_order_relaxed);
+						slot.duration.store(duration, std::memory_order_relaxed);
+						slot.value.store(value, std::memory_order_relaxed);
+
+						ended.store(index + 1, std::memory_order_release);
+					}
+
+					void copyInto(std::vector<Event> & events) const
+					{
+						events.clear();
+
+						const auto end = ended.load(std::memory_order_acquire);
+						const auto first = end > capacity ? end - capacity : 0;
+
+						for (auto i = first; i < end; ++i)
+						{
+							auto & slot = slots[i % capacity];
+							events.push_back({
+								slot.name.load(std::memory_order_relaxed),
+								slot.start.load(std::memory_order_relaxed),
+								slot.duration.load(std::memory_order_relaxed),
+								slot.value.load(std::memory_order_relaxed)
+							});
+						}
+
+						std::atomic_thread_fence(std::memory_order_acquire);
+
+						// a zone being written overwrites the one recorded capacity zones before it
+						const auto begin = begun.load(std::memory_order_relaxed);
+						const auto overwritten = begin > capacity ? std::min(begin - capacity, end) : 0;
+
+						if (overwritten > first)
+							events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(overwritten - first));
+					}
+
+					const int id;
+					std::atomic<const char *> name { nullptr };
+
+				private:
+
+					struct Slot
+					{
+						std::atomic<const char *> name { nullptr };
+						std::atomic<std::int64_t> start { 0 }, duration { 0 };
+						std::atomic<double> value { 0 };
+					};
+
+					std::atomic<std::uint64_t> begun { 0 }, ended { 0 };
+					std::array<Slot, capacity> slots;
+				};
+
+				struct Registry
+				{
+					std::mutex mutex;
+					std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+				};
+
+				static Registry & getRegistry()
+				{
+					static Registry registry;
+					return registry;
+				}
+
+				/// <summary>
+				/// The buffer of the calling thread, or null if it isn't registered. Buffers are never unregistered,
+				/// so the registry keeps them alive.
+				/// </summary>
+				static ThreadBuffer *& getThreadBuffer() noexcept
+				{
+					thread_local ThreadBuffer * buffer = nullptr;
+					return buffer;
+				}
+
+				static std::atomic<ThreadBuffer *> & getReservedBuffer() noexcept
+				{
+					static std::atomic<ThreadBuffer *> reserved { nullptr };
+					return reserved;
+				}
+
+				static ThreadBuffer * createBuffer()
+				{
+					auto & registry = getRegistry();
+					std::lock_guard<std::mutex> lock(registry.mutex);
+					registry.buffers.push_back(std::make_shared<ThreadBuffer>(static_cast<int>(registry.buffers.size() + 1)));
+					return registry.buffers.back().get();
+				}
+
+				static void nameBuffer(ThreadBuffer & buffer, const char * name) noexcept
+				{
+					if (!buffer.name.load(std::memory_order_relaxed))
+						buffer.name.store(name, std::memory_order_relaxed);
+				}
+
+				/// <summary>
+				/// Nanoseconds since the first zone of the process.
+				/// </summary>
+				static std::int64_t now() noexcept
+				{
+					static const auto epoch = std::chrono::steady_clock::now();
+					return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+				}
+			};
+		};
+
+		#define SIGNALIZER_TRACE_CONCAT_(a, b) a ## b
+		#define SIGNALIZER_TRACE_CONCAT(a, b) SIGNALIZER_TRACE_CONCAT_(a, b)
+
+		/// <summary>
+		/// Records the rest of the enclosing scope as a zone with the name, which must be a string literal.
+		/// </summary>
+		#define SIGNALIZER_TRACE_ZONE(name) ::Signalizer::Tracing::Zone SIGNALIZER_TRACE_CONCAT(signalizerTraceZone, __LINE__)(name)
+		/// <summary>
+		/// Registers the calling thread under the name. Allocates the first time, so not for real-time threads.
+		/// </summary>
+		#define SIGNALIZER_TRACE_THREAD(name) ::Signalizer::Tracing::registerThread(name)
+		/// <summary>
+		/// Registers a real-time thread under the name, with a buffer reserved through SIGNALIZER_TRACE_RESERVE().
+		/// </summary>
+		#define SIGNALIZER_TRACE_REALTIME_THREAD(name) ::Signalizer::Tracing::adoptReservedBuffer(name)
+		#define SIGNALIZER_TRACE_RESERVE() ::Signalizer::Tracing::reserveBuffer()
+		#define SIGNALIZER_TRACE_COUNTER(name, value) ::Signalizer::Tracing::counter(name, value)
+
+	#else
+
+		#define SIGNALIZER_TRACE_ZONE(name) do {} while(0)
+		#define SIGNALIZER_TRACE_THREAD(name) do {} while(0)
+		#define SIGNALIZER_TRACE_REALTIME_THREAD(name) do {} while(0)
+		#define SIGNALIZER_TRACE_RESERVE() do {} while(0)
+		#define SIGNALIZER_TRACE_COUNTER(name, value) do {} while(0)
+
+	#endif
+#endif
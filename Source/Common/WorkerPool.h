@@ -0,0 +1,189 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:WorkerPool.h
+
+		A small pool of threads for splitting blocking work across cores.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_WORKERPOOL_H
+	#define SIGNALIZER_WORKERPOOL_H
+
+	#include <atomic>
+	#include <condition_variable>
+	#include <cstdint>
+	#include <mutex>
+	#include <thread>
+	#include <vector>
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Runs indexed jobs in parallel on a set of worker threads together with the calling thread,
+		/// returning when all are done. With a concurrency of one, jobs are simply run on the calling thread.
+		///
+		/// Only one thread may call parallelFor() at a time, and not concurrently with setConcurrency().
+		/// </summary>
+		class WorkerPool
+		{
+		public:
+
+			WorkerPool() = default;
+			WorkerPool(const WorkerPool &) = delete;
+			WorkerPool & operator = (const WorkerPool &) = delete;
+
+			~WorkerPool()
+			{
+				setConcurrency(1);
+			}
+
+			/// <summary>
+			/// Sets the amount of threads running jobs, including the calling thread.
+			/// Starts and stops threads, so don't call this from any real-time thread.
+			/// </summary>
+			void setConcurrency(std::size_t concurrency)
+			{
+				if (concurrency < 1)
+					concurrency = 1;
+
+				if (concurrency == getConcurrency())
+					return;
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					quit = true;
+				}
+
+				wake.notify_all();
+
+				for (auto & thread : threads)
+					thread.join();
+
+				threads.clear();
+				quit = false;
+
+				for (std::size_t i = 1; i < concurrency; ++i)
+					threads.emplace_back([this] { run(); });
+			}
+
+			std::size_t getConcurrency() const noexcept
+			{
+				return threads.size() + 1;
+			}
+
+			/// <summary>
+			/// Calls job(i) for i = 0 ... count - 1, distributed over the threads.
+			/// </summary>
+			template<class Job>
+			void parallelFor(std::size_t count, Job & job)
+			{
+				if (threads.empty() || count < 2)
+				{
+					for (std::size_t i = 0; i < count; ++i)
+						job(i);
+
+					return;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					context = &job;
+					invoke = &invokeJob<Job>;
+					jobCount = count;
+					next.store(0, std::memory_order_relaxed);
+					remaining.store(count, std::memory_order_relaxed);
+					active = true;
+					generation++;
+				}
+
+				wake.notify_all();
+				work();
+
+				std::unique_lock<std::mutex> lock(mutex);
+				// workers that joined this generation must leave before the job goes out of scope
+				done.wait(lock, [this] { return remaining.load(std::memory_order_acquire) == 0 && busy == 0; });
+				active = false;
+			}
+
+		private:
+
+			template<class Job>
+			static void invokeJob(void * job, std::size_t index)
+			{
+				(*static_cast<Job *>(job))(index);
+			}
+
+			void work()
+			{
+				std::size_t index;
+
+				while ((index = next.fetch_add(1, std::memory_order_relaxed)) < jobCount)
+				{
+					invoke(context, index);
+
+					if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						done.notify_all();
+					}
+				}
+			}
+
+			void run()
+			{
+				std::uint64_t seen = 0;
+				std::unique_lock<std::mutex> lock(mutex);
+
+				while (true)
+				{
+					wake.wait(lock, [&] { return quit || (active && generation != seen); });
+
+					if (quit)
+						return;
+
+					seen = generation;
+					busy++;
+
+					lock.unlock();
+					work();
+					lock.lock();
+
+					if (--busy == 0)
+						done.notify_all();
+				}
+			}
+
+			std::vector<std::thread> threads;
+			std::mutex mutex;
+			std::condition_variable wake, done;
+
+			void * context = nullptr;
+			void (*invoke)(void *, std::size_t) = nullptr;
+			std::size_t jobCount = 0, busy = 0;
+			std::atomic<std::size_t> next { 0 }, remaining { 0 };
+			std::uint64_t generation = 0;
+			bool active = false, quit = false;
+		};
+	};
+#endif
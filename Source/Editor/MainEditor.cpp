@@ -36,6 +36,7 @@
 #include <cpl/LexicalConversion.h>
 #include "version.h"
 #include <cpl/Mathext.h>
+#include <fstream>
 
 namespace cpl
 {
@@ -1295,6 +1296,16 @@ namespace Signalizer
 
 	bool MainEditor::keyPressed(const juce::KeyPress &key, juce::Component *originatingComponent)
 	{
+#ifdef SIGNALIZER_TRACING
+		// dumps the trace zones of all instances to the desktop
+		if (key == juce::KeyPress('t', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0))
+		{
+			auto file = juce::File::getSpecialLocation(juce::File::userDesktopDirectory).getNonexistentChildFile("Signalizer trace", ".json");
+			std::ofstream output(file.getFullPathName().toStdString());
+			Tracing::writeChromeTrace(output);
+			return true;
+		}
+#endif
 		if (hasCurrentView() && (activeView().getWindow() == originatingComponent))
 		{
 			if (key.isKeyCode(key.escapeKey) && kkiosk.bGetValue() > 0.5)
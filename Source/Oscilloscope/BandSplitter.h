@@ -0,0 +1,239 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:BandSplitter.h
+
+		Vectorized band energy analysis used for colouring the oscilloscope
+		by frequency content.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_BANDSPLITTER_H
+	#define SIGNALIZER_BANDSPLITTER_H
+
+	#include <cpl/Common.h>
+	#include <cpl/simd.h>
+	#include <algorithm>
+	#include <cmath>
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Splits Feeds signals into up to maxBands frequency bands each, and tracks the smoothed energy of every band.
+		///
+		/// Each (feed, band) pair is a lane. Every band is filtered directly from its feed, through a 4th order
+		/// Linkwitz-Riley lowpass at its upper crossover and a highpass at its lower crossover (the outer bands skip one of them).
+		/// As all lanes run the same four biquads, all bands of all feeds are processed in parallel vectors.
+		/// The bands aren't phase aligned, which doesn't matter as only their energy is used.
+		///
+		/// Lanes of unused bands have zero gain, so their energy stays at zero.
+		/// </summary>
+		template<typename T, std::size_t Feeds>
+		class BandSplitter
+		{
+		public:
+
+			static const std::size_t maxBands = 4;
+
+			/// <summary>
+			/// Amount of lanes processed per sample, padded to whole vectors of any ISA (32 bytes).
+			/// </summary>
+			static const std::size_t lanes = (Feeds * maxBands + 32 / sizeof(T) - 1) & ~(32 / sizeof(T) - 1);
+
+			BandSplitter()
+				: coefficients(sections * Coefficient::end * lanes)
+				, state(2 * sections * lanes)
+				, energy(lanes)
+				, input(lanes)
+				, pole(32 / sizeof(T))
+			{
+				design(nullptr, 1, 1);
+			}
+
+			/// <summary>
+			/// Designs the filters for the amount of bands (1 ... maxBands), separated by the bands - 1 ascending crossovers (in hertz).
+			/// Filter states are kept, so this can be called while running.
+			/// </summary>
+			void design(const double * crossovers, std::size_t bands, double sampleRate)
+			{
+				if (bands > maxBands)
+					bands = maxBands;
+				else if (bands < 1)
+					bands = 1;
+
+				for (std::size_t f = 0; f < Feeds; ++f)
+				{
+					for (std::size_t b = 0; b < maxBands; ++b)
+					{
+						const auto lane = f * maxBands + b;
+
+						if (b >= bands)
+						{
+							for (std::size_t s = 0; s < sections; ++s)
+								setSection(s, lane, {});
+
+							continue;
+						}
+
+						const auto lowpass = b + 1 < bands ? butterworth(crossovers[b], sampleRate, false) : passthrough();
+						const auto highpass = b > 0 ? butterworth(crossovers[b - 1], sampleRate, true) : passthrough();
+
+						// squared butterworths make up a linkwitz-riley
+						setSection(0, lane, lowpass);
+						setSection(1, lane, lowpass);
+						setSection(2, lane, highpass);
+						setSection(3, lane, highpass);
+					}
+				}
+
+				for (std::size_t lane = Feeds * maxBands; lane < lanes; ++lane)
+				{
+					for (std::size_t s = 0; s < sections; ++s)
+						setSection(s, lane, {});
+				}
+			}
+
+			/// <summary>
+			/// Sets the pole of the one-pole filter smoothing the band energies.
+			/// </summary>
+			void setSmoothing(T smoothingPole) noexcept
+			{
+				std::fill(pole.begin(), pole.end(), smoothingPole);
+			}
+
+			/// <summary>
+			/// Processes one sample of the feeds [first, last), and updates their energies.
+			/// Feeds sharing vectors with the range are processed as well, on stale input.
+			/// </summary>
+			template<typename V>
+			inline void process(const T (&samples)[Feeds], std::size_t first = 0, std::size_t last = Feeds) noexcept
+			{
+				using namespace cpl::simd;
+
+				const std::size_t vectorLength = elements_of<V>::value;
+				const auto begin = (first * maxBands) & ~(vectorLength - 1);
+				const auto end = (last * maxBands + vectorLength - 1) & ~(vectorLength - 1);
+
+				for (std::size_t f = first; f < last; ++f)
+				{
+					for (std::size_t b = 0; b < maxBands; ++b)
+						input[f * maxBands + b] = samples[f];
+				}
+
+				const V vPole = load<V>(pole.data());
+
+				for (std::size_t lane = begin; lane < end; lane += vectorLength)
+				{
+					V x = load<V>(input.data() + lane);
+
+					for (std::size_t s = 0; s < sections; ++s)
+					{
+						const T * c = coefficients.data() + s * Coefficient::end * lanes + lane;
+						T * z1 = state.data() + (2 * s) * lanes + lane;
+						T * z2 = z1 + lanes;
+
+						// transposed direct form II
+						const V y = load<V>(c + Coefficient::b0 * lanes) * x + load<V>(z1);
+						*reinterpret_cast<V *>(z1) = load<V>(c + Coefficient::b1 * lanes) * x - load<V>(c + Coefficient::a1 * lanes) * y + load<V>(z2);
+						*reinterpret_cast<V *>(z2) = load<V>(c + Coefficient::b2 * lanes) * x - load<V>(c + Coefficient::a2 * lanes) * y;
+						x = y;
+					}
+
+					const V power = x * x;
+					const V previous = load<V>(energy.data() + lane);
+					*reinterpret_cast<V *>(energy.data() + lane) = power + vPole * (previous - power);
+				}
+			}
+
+			/// <summary>
+			/// Returns the maxBands smoothed energies of the feed.
+			/// </summary>
+			const T * getEnergies(std::size_t feed) const noexcept
+			{
+				return energy.data() + feed * maxBands;
+			}
+
+			void reset() noexcept
+			{
+				std::fill(state.begin(), state.end(), T(0));
+				std::fill(energy.begin(), energy.end(), T(0));
+			}
+
+		private:
+
+			static const std::size_t sections = 4;
+
+			struct Biquad
+			{
+				double b0, b1, b2, a1, a2;
+			};
+
+			/// <summary>
+			/// Each coefficient of a section is stored in its own row of lanes.
+			/// </summary>
+			enum Coefficient
+			{
+				b0, b1, b2, a1, a2, end
+			};
+
+			static Biquad passthrough() noexcept
+			{
+				return { 1, 0, 0, 0, 0 };
+			}
+
+			static Biquad butterworth(double frequency, double sampleRate, bool highpass) noexcept
+			{
+				const double pi = cpl::simd::consts<double>::pi;
+				const double omega = 2 * pi * std::min(frequency / sampleRate, 0.49);
+				const double cosine = std::cos(omega);
+				const double alpha = std::sin(omega) / std::sqrt(2.0);
+				const double a0 = 1 + alpha;
+				const double gain = (highpass ? 1 + cosine : 1 - cosine) / (2 * a0);
+
+				return { gain, (highpass ? -2 : 2) * gain, gain, -2 * cosine / a0, (1 - alpha) / a0 };
+			}
+
+			void setSection(std::size_t section, std::size_t lane, const Biquad & b) noexcept
+			{
+				T * c = coefficients.data() + section * Coefficient::end * lanes + lane;
+				c[Coefficient::b0 * lanes] = static_cast<T>(b.b0);
+				c[Coefficient::b1 * lanes] = static_cast<T>(b.b1);
+				c[Coefficient::b2 * lanes] = static_cast<T>(b.b2);
+				c[Coefficient::a1 * lanes] = static_cast<T>(b.a1);
+				c[Coefficient::a2 * lanes] = static_cast<T>(b.a2);
+			}
+
+			cpl::aligned_vector<T, 32> coefficients;
+			/// <summary>
+			/// The two delays of each section, each lanes wide.
+			/// </summary>
+			cpl::aligned_vector<T, 32> state;
+			cpl::aligned_vector<T, 32> energy, input;
+			/// <summary>
+			/// The smoothing pole, splat over a vector.
+			/// </summary>
+			cpl::aligned_vector<T, 32> pole;
+		};
+	};
+
+#endif
@@ -32,46 +32,192 @@
 
 	#include "Signalizer.h"
 	#include <cpl/simd.h>
-	#include <cpl/dsp/LinkwitzRileyNetwork.h>
-	#include <cpl/dsp/SmoothedParameterState.h>
+	#include "MinMaxPyramid.h"
+	#include "BandSplitter.h"
+	#include <algorithm>
+	#include <atomic>
+	#include <cmath>
+	#include <cstdint>
 
 	namespace Signalizer
 	{
 		struct ChannelData
 		{
+			/// <summary>
+			/// The maximum amount of coloured frequency bands.
+			/// </summary>
 			static const std::size_t Bands = 3;
-			typedef cpl::dsp::LinkwitzRileyNetwork<AFloat, Bands> Crossover;
 			typedef cpl::GraphicsND::UPixel<cpl::GraphicsND::ComponentOrder::OpenGL> PixelType;
 			typedef cpl::CLIFOStream<AFloat, 32> AudioBuffer;
 			typedef cpl::CLIFOStream<PixelType, 32> ColourBuffer;
+			typedef MinMaxPyramid<AFloat, PixelType> LevelPyramid;
+
+			/// <summary>
+			/// Colours are only stored once every ColourDecimation samples (a power of two), and interpolated in between.
+			/// They follow smoothed band energies, so they change slowly compared to the samples.
+			/// </summary>
+			static const std::size_t ColourDecimation = 32;
+
+			/// <summary>
+			/// The colours of a sample stream. Entry k holds the colour of the absolute sample position k * ColourDecimation,
+			/// so a track must be written exactly at those positions to stay aligned with the samples.
+			/// </summary>
+			struct ColourTrack
+			{
+				/// <summary>
+				/// Reads interpolated colours of consecutive samples.
+				/// </summary>
+				class Reader
+				{
+				public:
+
+					/// <summary>
+					/// Written is the total amount of samples written to the track's buffer.
+					/// </summary>
+					Reader(const ColourTrack & track, std::uint64_t written)
+						: view(track.entries.createProxyView())
+						, entries(static_cast<std::int64_t>((written + ColourDecimation - 1) / ColourDecimation))
+					{
+
+					}
+
+					std::size_t size() const noexcept
+					{
+						return view.size();
+					}
+
+					/// <summary>
+					/// Moves to the absolute sample position. Positions outside of the history read the nearest stored colour.
+					/// </summary>
+					void seek(std::int64_t sample) noexcept
+					{
+						const auto decimation = static_cast<std::int64_t>(ColourDecimation);
+						// floored, as the position can precede the first sample
+						entry = sample >= 0 ? sample / decimation : -((decimation - 1 - sample) / decimation);
+						phase = static_cast<std::size_t>(sample - entry * decimation);
+						load();
+					}
+
+					PixelType evaluate() const noexcept
+					{
+						return current.lerp(next, phase * (1.0f / ColourDecimation));
+					}
+
+					void inc() noexcept
+					{
+						if (++phase == ColourDecimation)
+						{
+							phase = 0;
+							entry++;
+							load();
+						}
+					}
+
+				private:
+
+					void load() noexcept
+					{
+						current = at(entry);
+						next = at(entry + 1);
+					}
+
+					PixelType at(std::int64_t index) const noexcept
+					{
+						const auto size = static_cast<std::int64_t>(view.size());
+
+						if (entries < 1 || size < 1)
+							return {};
+
+						const auto newest = entries - 1;
+						index = std::max(std::min(index, newest), std::max<std::int64_t>(0, entries - size));
+
+						// the cursor is the position after the newest entry
+						auto position = static_cast<std::int64_t>(view.cursorPosition()) - (entries - index);
+
+						while (position < 0)
+							position += size;
+
+						return view.begin()[position];
+					}
+
+					ColourBuffer::ProxyView view;
+					std::int64_t entries, entry = 0;
+					std::size_t phase = 0;
+					PixelType current {}, next {};
+				};
+
+				void setStorageRequirements(std::size_t samples)
+				{
+					// the window can straddle an entry at both ends
+					const auto size = samples / ColourDecimation + 2;
+					entries.setStorageRequirements(size, cpl::Math::nextPow2Inc(size));
+				}
+
+				ColourBuffer entries;
+			};
 
 			struct Channel
 			{
 				AudioBuffer audioData;
-				ColourBuffer colourData;
+				ColourTrack colourData;
+				/// <summary>
+				/// Decimations of audioData and colourData, see Buffer::updateLevels()
+				/// </summary>
+				LevelPyramid levels;
 			};
 
 			struct FilterStates
 			{
+				enum StereoFeeds
+				{
+					Left,
+					Right,
+					Mid,
+					Side
+				};
+
 				struct ChannelState
 				{
-					Crossover::BandArray smoothFilters{};
-					Crossover network;
 					juce::Colour defaultKey;
 				};
 
 				std::vector<ChannelState> channels;
 
-				Crossover network;
+				/// <summary>
+				/// Band energies of the feeds in StereoFeeds, for two or more channels.
+				/// </summary>
+				BandSplitter<AFloat, 4> stereo;
+				BandSplitter<AFloat, 1> mono;
+			};
 
+			/// <summary>
+			/// Parameters of the frequency colouring filters. Filters are only redesigned when this changes.
+			/// </summary>
+			struct ColouringDesign
+			{
+				double lowCrossover, highCrossover, smoothingMilliseconds, sampleRate;
+				std::size_t bands;
 
-				Crossover::BandArray midSideSmoothsFilters[2];
+				bool operator == (const ColouringDesign & other) const noexcept
+				{
+					return lowCrossover == other.lowCrossover && highCrossover == other.highCrossover && smoothingMilliseconds == other.smoothingMilliseconds
+						&& sampleRate == other.sampleRate && bands == other.bands;
+				}
+
+				bool operator != (const ColouringDesign & other) const noexcept
+				{
+					return !(*this == other);
+				}
 			};
 
 			struct Buffer
 			{
 				std::vector<Channel> channels{ 1 };
-				ColourBuffer midSideColour[2];
+				ColourTrack midSideColour[2];
+				/// <summary>
+				/// Decimations of the mid and side signals, along with midSideColour.
+				/// </summary>
+				LevelPyramid midSideLevels[2];
 
 				Channel & defaultChannel()
 				{
@@ -86,12 +232,139 @@
 					for (auto & c : channels)
 					{
 						c.audioData.setStorageRequirements(samples, capacity);
-						c.colourData.setStorageRequirements(samples, capacity);
+						c.colourData.setStorageRequirements(samples);
 					}
 
 					for (auto & c : midSideColour)
 					{
-						c.setStorageRequirements(samples, capacity);
+						c.setStorageRequirements(samples);
+					}
+
+					// this is called for every frame, so only rebuild the levels if the size changed
+					bool levelsChanged = false;
+
+					for (auto & c : channels)
+					{
+						if (c.levels.getSize() != samples)
+						{
+							c.levels.resize(samples);
+							levelsChanged = true;
+						}
+					}
+
+					for (auto & l : midSideLevels)
+					{
+						if (l.getSize() != samples)
+						{
+							l.resize(samples);
+							levelsChanged = true;
+						}
+					}
+
+					if (levelsChanged)
+					{
+						// rebuild all levels from whatever history survived the resize, as they must stay aligned
+						for (auto & c : channels)
+							c.levels.clear();
+
+						for (auto & l : midSideLevels)
+							l.clear();
+
+						updateLevels(samples);
+					}
+				}
+
+				/// <summary>
+				/// Registers the newest amount of samples written to the audio and colour buffers.
+				/// Call this every time the buffers are written to, as the colour tracks are addressed by written.
+				/// </summary>
+				void advance(std::size_t newSamples)
+				{
+					written += newSamples;
+					updateLevels(newSamples);
+				}
+
+				std::size_t getSize() const noexcept
+				{
+					return channels[0].audioData.getSize();
+				}
+
+				/// <summary>
+				/// The total amount of samples written, ie. the position of the next sample.
+				/// </summary>
+				std::uint64_t written = 0;
+
+				/// <summary>
+				/// Appends the newest amount of samples written to the audio and colour buffers to the level pyramids.
+				/// </summary>
+				void updateLevels(std::size_t newSamples)
+				{
+					// wraps the position into the view, starting at newSamples before the cursor
+					auto oldest = [](const auto & view, std::size_t samples)
+					{
+						auto position = static_cast<cpl::ssize_t>(view.cursorPosition()) - static_cast<cpl::ssize_t>(samples);
+
+						while (position < 0)
+							position += view.size();
+
+						return static_cast<std::size_t>(position);
+					};
+
+					for (auto & c : channels)
+					{
+						auto && audio = c.audioData.createProxyView();
+						ColourTrack::Reader colour(c.colourData, written);
+
+						const auto samples = std::min<std::size_t>(newSamples, audio.size());
+
+						if (!samples || !colour.size())
+							continue;
+
+						auto a = oldest(audio, samples);
+						colour.seek(static_cast<std::int64_t>(written - samples));
+
+						for (std::size_t n = 0; n < samples; ++n)
+						{
+							c.levels.append(audio.begin()[a], colour.evaluate());
+
+							if (++a == audio.size())
+								a = 0;
+
+							colour.inc();
+						}
+					}
+
+					if (channels.size() < 2)
+						return;
+
+					auto && left = channels[0].audioData.createProxyView();
+					auto && right = channels[1].audioData.createProxyView();
+
+					if (left.size() != right.size())
+						return;
+
+					for (std::size_t i = 0; i < std::extent<decltype(midSideColour)>::value; ++i)
+					{
+						ColourTrack::Reader colour(midSideColour[i], written);
+						const auto samples = std::min<std::size_t>(newSamples, left.size());
+
+						if (!samples || !colour.size())
+							continue;
+
+						auto a = oldest(left, samples);
+						colour.seek(static_cast<std::int64_t>(written - samples));
+
+						for (std::size_t n = 0; n < samples; ++n)
+						{
+							const AFloat l = left.begin()[a], r = right.begin()[a];
+							// same as the mid/side sample colour evaluators
+							midSideLevels[i].append(static_cast<AFloat>(0.5) * (i == 0 ? l + r : l - r), colour.evaluate());
+
+							if (++a == left.size())
+								a = 0;
+
+							colour.inc();
+						}
 					}
 				}
 			};
@@ -120,40 +393,171 @@
 
 			}
 
-			void swapBuffers(std::size_t historySize, cpl::ssize_t offset)
+			/// <summary>
+			/// Range of samples in a buffer to display, measured in samples written to the buffer.
+			/// </summary>
+			struct Window
 			{
-				auto swapBuf = [historySize, offset](const auto & inBuf, auto & outBuf)
+				enum BufferID : std::uint32_t
 				{
-					outBuf.createWriter().copyIntoHead(inBuf.createProxyView(), historySize, offset);
+					Front,
+					Back
 				};
 
-				for (std::size_t i = 0; i < std::extent<decltype(Buffer::midSideColour)>::value; ++i)
+				std::uint64_t start, length;
+				BufferID buffer;
+				/// <summary>
+				/// The steady clock of the stream after the newest sample of the window.
+				/// </summary>
+				std::uint64_t clock;
+			};
+
+			/// <summary>
+			/// Holds the most recently published window. Publishing and reading are lock-free, and readers
+			/// always see a consistent window (a sequence lock, retrying if a publish happened meanwhile).
+			/// </summary>
+			class PublishedWindow
+			{
+			public:
+
+				void publish(const Window & window) noexcept
 				{
-					swapBuf(back.midSideColour[i], front.midSideColour[i]);
+					const auto current = sequence.load(std::memory_order_relaxed);
+					// odd sequences mark writes in progress
+					sequence.store(current + 1, std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_release);
+
+					start.store(window.start, std::memory_order_relaxed);
+					length.store(window.length, std::memory_order_relaxed);
+					buffer.store(window.buffer, std::memory_order_relaxed);
+					clock.store(window.clock, std::memory_order_relaxed);
+
+					sequence.store(current + 2, std::memory_order_release);
 				}
 
-				for (std::size_t i = 0; i < back.channels.size(); ++i)
+				Window read() const noexcept
 				{
-					swapBuf(back.channels[i].audioData, front.channels[i].audioData);
-					swapBuf(back.channels[i].colourData, front.channels[i].colourData);
+					Window window;
+					std::uint64_t before, after;
+
+					do
+					{
+						before = sequence.load(std::memory_order_acquire);
+
+						window.start = start.load(std::memory_order_relaxed);
+						window.length = length.load(std::memory_order_relaxed);
+						window.buffer = static_cast<Window::BufferID>(buffer.load(std::memory_order_relaxed));
+						window.clock = clock.load(std::memory_order_relaxed);
+
+						std::atomic_thread_fence(std::memory_order_acquire);
+						after = sequence.load(std::memory_order_relaxed);
+
+					} while ((before & 1) || before != after);
+
+					return window;
 				}
+
+			private:
+
+				std::atomic<std::uint64_t> sequence { 0 }, start { 0 }, length { 0 }, clock { 0 };
+				std::atomic<std::uint32_t> buffer { Window::Front };
+			};
+
+			/// <summary>
+			/// The window being rendered, see acquireDisplay()
+			/// </summary>
+			struct Display
+			{
+				const Buffer * buffer;
+				/// <summary>
+				/// The amount of samples between the end of the window and the newest sample in the buffer.
+				/// </summary>
+				std::size_t distance;
+				/// <summary>
+				/// See Window::clock.
+				/// </summary>
+				std::uint64_t clock;
+			};
+
+			/// <summary>
+			/// Sizes the buffers for showing windows of the amount of samples.
+			/// The back buffer has additional headroom, so published windows remain in it while the renderer catches up.
+			/// </summary>
+			void resizeStorage(std::size_t windowSamples, std::size_t headroom, std::size_t capacity)
+			{
+				displayedSamples = windowSamples;
+				front.resizeStorage(windowSamples, std::max(windowSamples, capacity));
+				back.resizeStorage(windowSamples + headroom, std::max(windowSamples + headroom, capacity));
+			}
+
+			/// <summary>
+			/// Publishes the newest samples of the front buffer as the window to display.
+			/// clock is the steady clock of the stream after the newest sample written to the front buffer.
+			/// </summary>
+			void publishFront(std::uint64_t clock) noexcept
+			{
+				const auto size = front.getSize();
+				published.publish({ front.written - std::min<std::uint64_t>(front.written, size), size, Window::Front, clock });
 			}
 
-			void tuneCrossOver(double lowCrossover, double highCrossover, double sampleRate)
+			/// <summary>
+			/// Publishes historySize samples of the back buffer, starting offset samples from its newest, as the window to display.
+			/// Replaces copying the window into the front buffer.
+			/// clock is the steady clock of the stream after the newest sample written to the back buffer.
+			/// </summary>
+			void publishBack(std::size_t historySize, cpl::ssize_t offset, std::uint64_t clock) noexcept
 			{
-				networkCoeffs = Crossover::Coefficients::design({ static_cast<AFloat>(lowCrossover / sampleRate), static_cast<AFloat>(highCrossover / sampleRate) });
+				const auto start = static_cast<std::uint64_t>(static_cast<std::int64_t>(back.written) + offset);
+				const auto windowClock = static_cast<std::uint64_t>(static_cast<std::int64_t>(clock) + offset) + historySize;
+				published.publish({ start, historySize, Window::Back, windowClock });
 			}
 
-			void tuneColourSmoothing(double milliseconds, double sampleRate)
+			/// <summary>
+			/// Selects the most recently published window for rendering, until the next call.
+			/// </summary>
+			void acquireDisplay() noexcept
 			{
-				smoothFilterPole = cpl::dsp::SmoothedParameterState<AFloat, 1>::design(milliseconds, sampleRate);
+				const auto window = published.read();
+				const auto & buffer = window.buffer == Window::Back ? back : front;
+				const auto end = std::min(window.start + window.length, buffer.written);
+				const auto size = buffer.channels.empty() ? 0 : buffer.getSize();
+
+				// in case the window was overwritten already, show the oldest samples left
+				const std::uint64_t maxDistance = size > displayedSamples ? size - displayedSamples : 0;
+
+				display.buffer = &buffer;
+				display.distance = static_cast<std::size_t>(std::min(buffer.written - end, maxDistance));
+				display.clock = window.clock;
+			}
+
+			/// <summary>
+			/// Redesigns the colouring filters, if the design changed since last time.
+			/// </summary>
+			void tuneColouring(const ColouringDesign & design)
+			{
+				if (design == colouringDesign)
+					return;
+
+				colouringDesign = design;
+
+				// two bands are split at the low crossover
+				const auto crossovers = std::minmax(design.lowCrossover, design.highCrossover);
+				const double frequencies[] = { crossovers.first, crossovers.second };
+				const auto pole = static_cast<AFloat>(std::exp(-1000.0 / (design.smoothingMilliseconds * design.sampleRate)));
+
+				filterStates.stereo.design(frequencies, design.bands, design.sampleRate);
+				filterStates.stereo.setSmoothing(pole);
+				filterStates.mono.design(frequencies, design.bands, design.sampleRate);
+				filterStates.mono.setSmoothing(pole);
 			}
 
-			Crossover::Coefficients networkCoeffs;
-			cpl::dsp::SmoothedParameterState<AFloat, 1>::PoleState smoothFilterPole;
+			ColouringDesign colouringDesign {};
 
 			FilterStates filterStates;
 			Buffer back, front;
+			PublishedWindow published;
+			Display display { &front, 0, 0 };
+			std::size_t displayedSamples = 0;
 
 		};
 	};
@@ -0,0 +1,212 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:MinMaxPyramid.h
+
+		Incrementally updated min/max decimations of a sample history, used for
+		drawing waveforms with many samples per pixel.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_MINMAXPYRAMID_H
+	#define SIGNALIZER_MINMAXPYRAMID_H
+
+	#include <cpl/Common.h>
+	#include <algorithm>
+	#include <cstdint>
+	#include <vector>
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Stores the range and average colour of a sample history, at power of two bucket sizes.
+		/// Level L holds buckets of 2^L samples, for L = minLevel ... getMaxLevel(). Each level is a circular
+		/// history of at least getSize() samples, addressed by the absolute bucket index (sample position >> L).
+		///
+		/// Samples are accumulated into the smallest buckets, which are merged into every larger level as they complete.
+		/// Thus, the newest (less than 2^minLevel) samples are not yet part of the pyramid.
+		///
+		/// Colour must support lerp(const Colour &, float).
+		/// </summary>
+		template<typename T, typename Colour>
+		class MinMaxPyramid
+		{
+		public:
+
+			/// <summary>
+			/// The smallest bucket size is 2^minLevel. Smaller decimations are cheap enough to draw from the samples.
+			/// </summary>
+			static const std::size_t minLevel = 2;
+
+			struct Bucket
+			{
+				T low, high;
+				Colour colour;
+			};
+
+			/// <summary>
+			/// Sets the amount of history to store, and clears it.
+			/// </summary>
+			void resize(std::size_t samples)
+			{
+				size = samples;
+				levels.clear();
+
+				for (std::size_t level = minLevel; (std::size_t(1) << level) <= size; ++level)
+				{
+					// the window can straddle a bucket at both ends
+					levels.emplace_back((size >> level) + 2);
+				}
+
+				clear();
+			}
+
+			void clear() noexcept
+			{
+				written = 0;
+			}
+
+			/// <summary>
+			/// Returns the sample history size, as set by resize()
+			/// </summary>
+			std::size_t getSize() const noexcept
+			{
+				return size;
+			}
+
+			/// <summary>
+			/// The total amount of samples appended, ie. the absolute position of the next sample.
+			/// </summary>
+			std::uint64_t getWritten() const noexcept
+			{
+				return written;
+			}
+
+			/// <summary>
+			/// The absolute position after the newest sample merged into the levels.
+			/// Buckets at or after this position are stale.
+			/// </summary>
+			std::uint64_t getComplete() const noexcept
+			{
+				return written & ~static_cast<std::uint64_t>(minSize - 1);
+			}
+
+			/// <summary>
+			/// Returns the absolute position of the oldest sample in the history.
+			/// </summary>
+			std::uint64_t getOldest() const noexcept
+			{
+				return written - std::min<std::uint64_t>(written, size);
+			}
+
+			/// <summary>
+			/// Returns false if no levels exist (the history is smaller than the smallest bucket).
+			/// </summary>
+			bool hasLevels() const noexcept
+			{
+				return !levels.empty();
+			}
+
+			std::size_t getMaxLevel() const noexcept
+			{
+				return minLevel + levels.size() - 1;
+			}
+
+			/// <summary>
+			/// Returns the bucket at the index (absolute sample position >> level) of the level.
+			/// Only buckets inside the history hold valid data.
+			/// </summary>
+			const Bucket & getBucket(std::size_t level, std::uint64_t index) const noexcept
+			{
+				const auto & buckets = levels[level - minLevel];
+				return buckets[static_cast<std::size_t>(index % buckets.size())];
+			}
+
+			/// <summary>
+			/// Appends a sample and its colour.
+			/// </summary>
+			inline void append(T sample, const Colour & colour) noexcept
+			{
+				if (levels.empty())
+					return;
+
+				const auto position = written & (minSize - 1);
+
+				if (position == 0)
+				{
+					current.low = current.high = sample;
+					current.colour = colour;
+				}
+				else
+				{
+					current.low = std::min(current.low, sample);
+					current.high = std::max(current.high, sample);
+					// running average
+					current.colour = current.colour.lerp(colour, 1.0f / (position + 1));
+				}
+
+				written++;
+
+				if (position == minSize - 1)
+					propagate(written - minSize);
+			}
+
+		private:
+
+			static const std::size_t minSize = std::size_t(1) << minLevel;
+
+			/// <summary>
+			/// Merges the completed smallest bucket starting at the absolute position into all levels.
+			/// </summary>
+			void propagate(std::uint64_t start) noexcept
+			{
+				for (std::size_t i = 0; i < levels.size(); ++i)
+				{
+					const auto level = minLevel + i;
+					auto & buckets = levels[i];
+					auto & bucket = buckets[static_cast<std::size_t>((start >> level) % buckets.size())];
+
+					// position of this child in the parent bucket
+					const auto child = (start & ((std::uint64_t(1) << level) - 1)) >> minLevel;
+
+					if (child == 0)
+					{
+						bucket = current;
+					}
+					else
+					{
+						bucket.low = std::min(bucket.low, current.low);
+						bucket.high = std::max(bucket.high, current.high);
+						bucket.colour = bucket.colour.lerp(current.colour, 1.0f / (child + 1));
+					}
+				}
+			}
+
+			std::vector<std::vector<Bucket>> levels;
+			Bucket current {};
+			std::uint64_t written = 0;
+			std::size_t size = 0;
+		};
+	};
+
+#endif
@@ -38,6 +38,11 @@
 #include "OscilloscopeDSP.inl"
 #include "StreamPreprocessing.h"
 
+#ifdef SIGNALIZER_BENCHMARKS
+#include "SampleColourEvaluators.h"
+#include "../Analysis/Benchmark.h"
+#endif
+
 namespace Signalizer
 {
 	static std::vector<std::string> OperationalModeNames = {"Lissajous", "Polar"};
@@ -57,11 +62,13 @@ namespace Signalizer
 		, processorSpeed(0)
 		, lastFrameTick(0)
 		, lastMousePos()
+		, latency({ "Oscilloscope latency (ms)", "Oscilloscope latency p50 (ms)", "Oscilloscope latency p99 (ms)" })
 		, editor(nullptr)
 		, state()
 		, filters()
 		, triggerState()
 		, medianPos()
+		, bufferLock("bufferLock", "Oscilloscope::bufferLock wait")
 		, isMouseInside(false)
 	{
 		if (!(content = dynamic_cast<OscilloscopeContent *>(params)))
@@ -72,6 +79,8 @@ namespace Signalizer
 		triggerState.preprocessingTrigger = std::make_unique<PreprocessingTrigger>();
 
 		transformBuffer.resize(OscilloscopeContent::LookaheadSize);
+		singleTransformBuffer.resize(OscilloscopeContent::LookaheadSize);
+		singleFFT.setMaxSize(OscilloscopeContent::LookaheadSize);
 		temporaryBuffer.resize(OscilloscopeContent::LookaheadSize);
 
 		mtFlags.firstRun = true;
@@ -288,6 +297,7 @@ namespace Signalizer
 		state.diagnostics = content->diagnostics.getTransformedValue() > 0.5;
 		state.primitiveSize = content->primitiveSize.getTransformedValue();
 		state.triggerMode = cpl::enum_cast<OscilloscopeContent::TriggeringMode>(content->triggerMode.param.getTransformedValue());
+		state.triggerPrecision = content->triggerPrecision.param.getAsTEnum<OscilloscopeContent::TransformPrecision>();
 		state.customTrigger = content->triggerOnCustomFrequency.getNormalizedValue() > 0.5;
 		state.customTriggerFrequency = content->customTriggerFrequency.getTransformedValue();
 		state.colourChannelsByFrequency = content->channelColouring.param.getAsTEnum<OscilloscopeContent::ColourMode>() == OscilloscopeContent::ColourMode::SpectralEnergy;
@@ -363,6 +373,13 @@ namespace Signalizer
 
 	inline bool Oscilloscope::onAsyncAudio(const AudioStream & source, AudioStream::DataType ** buffer, std::size_t numChannels, std::size_t numSamples)
 	{
+		SIGNALIZER_TRACE_THREAD("Async audio");
+		SIGNALIZER_TRACE_ZONE("Oscilloscope::onAsyncAudio");
+
+	#ifdef DEBUG
+		CPL_RUNTIME_ASSERTION(content->systemView.getBlockTimeline().hasStamped(audioStream.getASyncPlayhead().getSteadyClock() + numSamples) && "Block timeline doesn't follow the steady clock of the stream");
+	#endif
+
 		if (state.isSuspended && globalBehaviour.stopProcessingOnSuspend.load(std::memory_order_relaxed))
 			return false;
 
@@ -370,4 +387,156 @@ namespace Signalizer
 		return false;
 	}
 
+#ifdef SIGNALIZER_BENCHMARKS
+	void Oscilloscope::runBenchmarks(Benchmark & suite)
+	{
+		typedef OscilloscopeContent::TriggeringMode TriggeringMode;
+		typedef OscilloscopeContent::ColourBands ColourBands;
+
+		static const char * channelNames[] = { "left", "right", "mid", "side", "separate", "mid+side" };
+
+		struct Colouring { const char * name; ColourBands bands; };
+
+		// the spectral colours are computed on the audio thread regardless of the colouring mode,
+		// which only changes the rendering. the amount of bands is what changes the audio thread's work.
+		static const Colouring colourings[] =
+		{
+			{ "2 bands", ColourBands::Two },
+			{ "3 bands", ColourBands::Three }
+		};
+
+		struct Trigger { const char * name; TriggeringMode mode; };
+
+		static const Trigger triggers[] =
+		{
+			{ "none", TriggeringMode::None },
+			{ "spectral", TriggeringMode::Spectral },
+			{ "window", TriggeringMode::Window },
+			{ "envelope", TriggeringMode::EnvelopeHold },
+			{ "zero-crossing", TriggeringMode::ZeroCrossing }
+		};
+
+		auto set = [](ChoiceParameter & choice, auto value)
+		{
+			choice.param.setTransformedValue(static_cast<double>(value));
+		};
+
+		// the storage is otherwise sized when rendering, without which the audio processing returns early
+		auto update = [this]
+		{
+			MeasuredMutex lock(bufferLock, LockStatistics::Owner::Rendering);
+			handleFlagUpdates();
+			channelData.resizeChannels(2);
+			resizeAudioStorage();
+			channelData.acquireDisplay();
+
+			CPL_RUNTIME_ASSERTION(channelData.front.getSize() > 0 && channelData.back.getSize() > 0 && "Benchmarked oscilloscope has no audio storage");
+		};
+
+		const auto blockSize = suite.getOptions().blockSize;
+		AFloat * block[2] = { suite.getTestChannel(0), suite.getTestChannel(1) };
+
+		set(content->triggerMode, TriggeringMode::None);
+
+		for (std::size_t c = 0; c < static_cast<std::size_t>(OscChannels::End); ++c)
+		{
+			set(content->channelConfiguration, c);
+
+			for (auto & colouring : colourings)
+			{
+				set(content->colourBands, colouring.bands);
+				update();
+
+				MeasuredMutex lock(bufferLock, LockStatistics::Owner::Rendering);
+				const auto variant = std::string(channelNames[c]) + ", " + colouring.name;
+
+				Benchmark::forEachISA(
+					[&](auto isa, const char * isaName)
+					{
+						typedef decltype(isa) ISA;
+						suite.measure("audioProcessing", variant, isaName, blockSize, [&] { audioProcessing<ISA>(block, 2, blockSize, channelData.front); });
+					}
+				);
+			}
+		}
+
+		set(content->channelConfiguration, OscChannels::Left);
+
+		// the trigger processors on their own
+		set(content->triggerMode, TriggeringMode::EnvelopeHold);
+		update();
+
+		Benchmark::forEachISA(
+			[&](auto isa, const char * isaName)
+			{
+				typedef decltype(isa) ISA;
+				MeasuredMutex lock(bufferLock, LockStatistics::Owner::Rendering);
+
+				suite.measure("PeakHoldProcessor", "left", isaName, blockSize,
+					[&]
+					{
+						auto samples = blockSize;
+						executeSamplingWindows<ISA, PeakHoldProcessor<ISA>>(block, 2, samples);
+					}
+				);
+			}
+		);
+
+		set(content->triggerMode, TriggeringMode::ZeroCrossing);
+		update();
+
+		Benchmark::forEachISA(
+			[&](auto isa, const char * isaName)
+			{
+				typedef decltype(isa) ISA;
+				MeasuredMutex lock(bufferLock, LockStatistics::Owner::Rendering);
+
+				suite.measure("ZeroCrossingProcessor", "left", isaName, blockSize,
+					[&]
+					{
+						auto samples = blockSize;
+						executeSamplingWindows<ISA, ZeroCrossingProcessor<ISA>>(block, 2, samples);
+					}
+				);
+			}
+		);
+
+		// the complete audio thread work of each trigger mode
+		for (auto & trigger : triggers)
+		{
+			set(content->triggerMode, trigger.mode);
+			update();
+
+			Benchmark::forEachISA(
+				[&](auto isa, const char * isaName)
+				{
+					typedef decltype(isa) ISA;
+					suite.measure("audioEntryPoint", std::string("left, ") + trigger.name, isaName, blockSize, [&] { audioEntryPoint<ISA>(block, 2, blockSize); });
+				}
+			);
+		}
+
+		if (!suite.isSelected("analyseAndSetupState"))
+			return;
+
+		// the spectral trigger analyses the published audio when rendering
+		set(content->triggerMode, TriggeringMode::Spectral);
+		update();
+		suite.settle();
+
+		MeasuredMutex lock(bufferLock, LockStatistics::Owner::Rendering);
+		handleFlagUpdates();
+		channelData.acquireDisplay();
+
+		Benchmark::forEachISA(
+			[&](auto isa, const char * isaName)
+			{
+				typedef decltype(isa) ISA;
+				suite.measure("analyseAndSetupState", "spectral, left", isaName, OscilloscopeContent::LookaheadSize,
+					[&] { analyseAndSetupState<ISA, SampleColourEvaluator<OscChannels::Left, 0>>(); }
+				);
+			}
+		);
+	}
+#endif
 };
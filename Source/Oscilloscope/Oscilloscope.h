@@ -40,6 +40,9 @@
 	#include <cpl/dsp/SmoothedParameterState.h>
 	#include <utility>
 	#include "ChannelData.h"
+	#include "../Common/SingleFFT.h"
+	#include "../Common/PolyphaseLanczos.h"
+	#include "../Common/Contention.h"
 
 	namespace cpl
 	{
@@ -52,6 +55,7 @@
 	namespace Signalizer
 	{
 		class PreprocessingTrigger;
+		class Benchmark;
 
 		class Oscilloscope final
 			: public cpl::COpenGLView
@@ -60,6 +64,7 @@
 		public:
 
 			friend class PreprocessingTrigger;
+			friend class OfflineAnalysis;
 
 			static const double higherAutoGainBounds;
 			static const double lowerAutoGainBounds;
@@ -67,6 +72,19 @@
 			Oscilloscope(const SharedBehaviour & globalBehaviour, const std::string & nameId, AudioStream & data, ProcessorState * params);
 			virtual ~Oscilloscope();
 
+			/// <summary>
+			/// Statistics of the lock shared by the audio and rendering threads. Safe to call from any thread.
+			/// </summary>
+			const LockStatistics & getLockStatistics() const noexcept { return bufferLock.statistics; }
+
+#ifdef SIGNALIZER_BENCHMARKS
+			/// <summary>
+			/// Times the DSP kernels of the view in each of their variants, see Benchmark.h.
+			/// Only part of the benchmark target.
+			/// </summary>
+			void runBenchmarks(Benchmark & suite);
+#endif
+
 		protected:
 			
 			// Component overrides
@@ -113,6 +131,11 @@
 				template<typename ISA> static void dispatch(Oscilloscope & o) { o.vectorGLRendering<ISA>(); }
 			};
 
+			struct AnalysisDispatcher
+			{
+				template<typename ISA> static void dispatch(Oscilloscope & o) { o.analyseDisplay<ISA>(); }
+			};
+
 			struct AudioDispatcher
 			{
 				template<typename ISA> static void dispatch(Oscilloscope & o, AFloat ** buffer, std::size_t numChannels, std::size_t numSamples) 
@@ -125,6 +148,16 @@
 			template<typename ISA>
 				void vectorGLRendering();
 
+			/// <summary>
+			/// Analyses the displayed window like a rendered frame does, without drawing anything.
+			/// Used by the offline analysis. Same requirements as rendering: bufferLock must be held,
+			/// and the flag updates handled and the display acquired.
+			/// </summary>
+			void analyseDisplay();
+
+			template<typename ISA>
+				void analyseDisplay();
+
 			// vector-accelerated drawing, rendering and processing
 			template<typename ISA, typename Eval>
 				void drawWavePlot(cpl::OpenGLRendering::COpenGLStack &);
@@ -143,8 +176,11 @@
 
 			void resizeAudioStorage();
 
+			/// <summary>
+			/// Updates the peak decay envelope with a block of incoming audio, and publishes the auto-gain.
+			/// </summary>
 			template<typename ISA>
-				void runPeakFilter();
+				void runPeakFilter(AFloat ** buffer, std::size_t numChannels, std::size_t numSamples, OscChannels mode);
 
 			template<typename ISA, typename Eval>
 				void analyseAndSetupState();
@@ -225,6 +261,7 @@
 				EnvelopeModes envelopeMode;
 				SubSampleInterpolation sampleInterpolation;
 				OscilloscopeContent::TriggeringMode triggerMode;
+				OscilloscopeContent::TransformPrecision triggerPrecision;
 				OscilloscopeContent::TimeMode timeMode;
 				OscChannels channelMode;
 
@@ -248,13 +285,22 @@
 			unsigned long long processorSpeed; // clocks / sec
 			juce::Point<float> lastMousePos;
 			long long lastFrameTick, renderCycles;
+			LatencyMeter latency;
 			std::atomic_bool isMouseInside;
 			/// <summary>
 			/// Updates are not guaranteed to be in order
 			/// </summary>
 			std::pair<std::atomic<float>, std::atomic<float>> threadedMousePos;
 			cpl::aligned_vector<std::complex<double>, 32> transformBuffer;
+			cpl::aligned_vector<std::complex<float>, 32> singleTransformBuffer;
+			SingleFFT singleFFT;
 			cpl::aligned_vector<double, 16> temporaryBuffer;
+			PolyphaseLanczos<AFloat, OscilloscopeContent::InterpolationKernelSize> lanczos;
+			/// <summary>
+			/// Contiguous copies of the samples and colours interpolated by the Lanczos renderer.
+			/// </summary>
+			cpl::aligned_vector<AFloat, 32> lanczosSamples;
+			std::vector<ChannelData::PixelType> lanczosColours;
 			const SharedBehaviour & globalBehaviour;
 
 			struct BinRecord
@@ -277,6 +323,19 @@
 				double omega() const noexcept { return index + offset; }
 			};
 
+			/// <summary>
+			/// Transforms the lookahead of the evaluator and searches it for the fundamental.
+			/// The transform buffer is either transformBuffer or singleTransformBuffer, depending on state.triggerPrecision.
+			/// </summary>
+			template<typename ISA, typename Eval, typename T>
+				BinRecord findFundamentalBin(Eval & eval, std::complex<T> * transform, std::size_t transformSize);
+
+			template<typename ISA>
+				void forwardTransform(std::complex<double> * transform, std::size_t size);
+
+			template<typename ISA>
+				void forwardTransform(std::complex<float> * transform, std::size_t size);
+
 			struct TriggerData
 			{ 
 				std::unique_ptr<PreprocessingTrigger> preprocessingTrigger;
@@ -311,7 +370,7 @@
 			std::size_t medianPos;
 			std::array<MedianData, MedianData::FilterSize> medianTriggerFilter;
 
-			cpl::CMutex::Lockable bufferLock;
+			MeasuredLockable bufferLock;
 			ChannelData channelData;
 
 			class DefaultKey;
@@ -321,9 +380,8 @@
 			public:
 
 				typedef ChannelData::AudioBuffer::ProxyView::const_iterator AudioIt;
-				typedef ChannelData::ColourBuffer::ProxyView::const_iterator ColourIt;
 				typedef ChannelData::AudioBuffer::ProxyView::value_type AudioT;
-				typedef ChannelData::ColourBuffer::ProxyView::value_type ColourT;
+				typedef ChannelData::PixelType ColourT;
 
 			};
 
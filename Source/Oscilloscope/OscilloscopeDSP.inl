@@ -41,144 +41,165 @@ namespace Signalizer
 	template<typename ISA, typename Eval>
 	void Oscilloscope::analyseAndSetupState()
 	{
+		SIGNALIZER_TRACE_ZONE("Oscilloscope::analyseAndSetupState");
+
 		calculateFundamentalPeriod<ISA, Eval>();
 		calculateTriggeringOffset<ISA, Eval>();
 
 		resizeAudioStorage();
 
-		if (state.envelopeMode == EnvelopeModes::PeakDecay)
-		{
-			runPeakFilter<ISA>();
-		}
-		else if (state.envelopeMode == EnvelopeModes::None)
+		// the other modes are followed on the audio thread
+		if (state.envelopeMode == EnvelopeModes::None)
 		{
 			shared.autoGainEnvelope.store(1, std::memory_order_release);
 		}
 	}
 
-	template<typename ISA, typename Eval>
-	void Oscilloscope::calculateFundamentalPeriod()
+	template<typename ISA>
+	void Oscilloscope::forwardTransform(std::complex<double> * transform, std::size_t size)
 	{
-#ifdef PHASE_VOCODER
-		auto const TransformSize = OscilloscopeContent::LookaheadSize >> 1;
-#else
-		auto const TransformSize = OscilloscopeContent::LookaheadSize;
-#endif
-
-		if (state.customTrigger)
-		{
-			auto const normalizedFrequency = state.customTriggerFrequency / audioStream.getAudioHistorySamplerate();
-			triggerState.record = BinRecord{ 0, 1, normalizedFrequency * TransformSize};
-
-			auto fundamental = state.customTriggerFrequency;
-
-			triggerState.fundamental = state.customTriggerFrequency;
-			triggerState.cycleSamples = audioStream.getAudioHistorySamplerate() / fundamental;
-		}
-		else if(state.triggerMode == OscilloscopeContent::TriggeringMode::Spectral)
-		{
-			Eval eval(channelData);
+		signaldust::DustFFT_fwdDa(reinterpret_cast<double*>(transform), static_cast<unsigned int>(size));
+	}
 
-			if (!eval.isWellDefined())
-				return;
+	template<typename ISA>
+	void Oscilloscope::forwardTransform(std::complex<float> * transform, std::size_t size)
+	{
+		singleFFT.forward<ISA>(transform, size);
+	}
 
-			// we will try to analyse the points closest to the sync point (latest in time)
-			auto offset = std::max<std::size_t>(std::ceil(state.effectiveWindowSize), OscilloscopeContent::LookaheadSize);
+	template<typename ISA, typename Eval, typename T>
+	Oscilloscope::BinRecord Oscilloscope::findFundamentalBin(Eval & eval, std::complex<T> * transform, std::size_t transformSize)
+	{
+		// we will try to analyse the points closest to the sync point (latest in time)
+		auto offset = std::max<std::size_t>(std::ceil(state.effectiveWindowSize), OscilloscopeContent::LookaheadSize);
 
-			eval.startFrom(-static_cast<cpl::ssize_t>(offset));
+		eval.startFrom(-static_cast<cpl::ssize_t>(offset));
 
-			for (std::size_t i = 0; i < OscilloscopeContent::LookaheadSize; ++i)
-			{
-				transformBuffer[i] = eval.evaluateSampleInc();
-			}
+		for (std::size_t i = 0; i < OscilloscopeContent::LookaheadSize; ++i)
+		{
+			transform[i] = eval.evaluateSampleInc();
+		}
 
 
-			signaldust::DustFFT_fwdDa(reinterpret_cast<double*>(transformBuffer.data()), TransformSize);
+		forwardTransform<ISA>(transform, transformSize);
 #ifdef PHASE_VOCODER
-			signaldust::DustFFT_fwdDa(reinterpret_cast<double*>(transformBuffer.data() + TransformSize), TransformSize);
+		forwardTransform<ISA>(transform + transformSize, transformSize);
 #endif
-			// estimates the true frequency by calculating a bin offset to the current bin w
-			auto quadDelta = [&](auto w) {
+		// estimates the true frequency by calculating a bin offset to the current bin w
+		auto quadDelta = [&](auto w) {
 #if PHASE_VOCODER
-				auto deltaBinOffset = std::arg(transformBuffer[w]) - std::arg(transformBuffer[TransformSize + w]);
+			auto deltaBinOffset = std::arg(transform[w]) - std::arg(transform[transformSize + w]);
 
-				deltaBinOffset -= w * 2 * M_PI;
+			deltaBinOffset -= w * 2 * M_PI;
 
-				while (deltaBinOffset < 2 * M_PI)
-					deltaBinOffset += 2 * M_PI;
+			while (deltaBinOffset < 2 * M_PI)
+				deltaBinOffset += 2 * M_PI;
 
-				while (deltaBinOffset > 2 * M_PI)
-					deltaBinOffset -= 2 * M_PI;
+			while (deltaBinOffset > 2 * M_PI)
+				deltaBinOffset -= 2 * M_PI;
 
-				return deltaBinOffset / (2 * M_PI);
+			return deltaBinOffset / (2 * M_PI);
 #else
-				const auto
-					x0 = transformBuffer[w],
-					x1 = transformBuffer[w + 1],
-					xm1 = transformBuffer[w == 0 ? 1 : w - 1];
+			const auto
+				x0 = transform[w],
+				x1 = transform[w + 1],
+				xm1 = transform[w == 0 ? 1 : w - 1];
 
-				const auto denom = x0 * 2.0 - xm1 - x1;
+			const auto denom = x0 * T(2) - xm1 - x1;
 
-				return (denom.real() + denom.imag()) != 0 ? std::real((xm1 - x1) / denom) : 0;
+			return (denom.real() + denom.imag()) != 0 ? std::real((xm1 - x1) / denom) : 0;
 #endif
-			};
+		};
 
-			const double quarterSemitone = std::pow(2, 0.25 / 12.0) - 1;
-			const double threshold = content->triggerThreshold.getTransformedValue();
-			const double hysteresis = content->triggerHysteresis.getTransformedValue();
-			const auto invHysteresis = 1 - hysteresis;
+		const double quarterSemitone = std::pow(2, 0.25 / 12.0) - 1;
+		const double threshold = content->triggerThreshold.getTransformedValue();
+		const double hysteresis = content->triggerHysteresis.getTransformedValue();
+		const auto invHysteresis = 1 - hysteresis;
 
-			BinRecord max{ 1, std::max(threshold * TransformSize, std::abs(transformBuffer[1])), quadDelta(1) };
+		BinRecord max{ 1, std::max<double>(threshold * transformSize, std::abs(transform[1])), quadDelta(1) };
 
-			for (std::size_t i = 2; i < (TransformSize >> 1); ++i)
-			{
-				BinRecord current{ i, std::abs(transformBuffer[i]) };
+		for (std::size_t i = 2; i < (transformSize >> 1); ++i)
+		{
+			BinRecord current{ i, std::abs(transform[i]) };
 
-				// candidate must be vastly better
-				if (invHysteresis * current.value > max.value * 2)
+			// candidate must be vastly better
+			if (invHysteresis * current.value > max.value * 2)
+			{
+				// weird parabolas
+				if (max.omega() > 0)
 				{
-					// weird parabolas
-					if (max.omega() > 0)
-					{
-						// check if it is somewhat harmonically related, in which case we discard the candidate
-						current.offset = quadDelta(i);
+					// check if it is somewhat harmonically related, in which case we discard the candidate
+					current.offset = quadDelta(i);
 
-						// harmonic relationship
-						auto factor = current.omega() / max.omega();
+					// harmonic relationship
+					auto factor = current.omega() / max.omega();
 
-						auto sensivity = current.value / max.value;
+					auto sensivity = current.value / max.value;
 
-						// shortcut if the value is 20 times bigger
-						if (invHysteresis * sensivity > 20)
-						{
-							max = current;
-							continue;
-						}
+					// shortcut if the value is 20 times bigger
+					if (invHysteresis * sensivity > 20)
+					{
+						max = current;
+						continue;
+					}
 
-						// the same value, just a better estimate, from another bin
-						// TODO: fix this case by polynomially interpolate the value as well
-						if (std::abs(1 - factor) < invHysteresis * quarterSemitone)
-						{
-							max = current;
-							continue;
-						}
+					// the same value, just a better estimate, from another bin
+					// TODO: fix this case by polynomially interpolate the value as well
+					if (std::abs(1 - factor) < invHysteresis * quarterSemitone)
+					{
+						max = current;
+						continue;
+					}
 
-						auto multipleDeviation = std::abs(factor - std::floor(factor + 0.5));
+					auto multipleDeviation = std::abs(factor - std::floor(factor + 0.5));
 
-						// check if the harmonic series is more than half a semi-tone away, in which case we take the candidate
-						if (invHysteresis * std::abs(multipleDeviation) > quarterSemitone)
-						{
-							max = current;
-						}
-					}
-					else
+					// check if the harmonic series is more than half a semi-tone away, in which case we take the candidate
+					if (invHysteresis * std::abs(multipleDeviation) > quarterSemitone)
 					{
 						max = current;
-						max.offset = quadDelta(max.index);
 					}
-
 				}
+				else
+				{
+					max = current;
+					max.offset = quadDelta(max.index);
+				}
+
 			}
+		}
+
+		return max;
+	}
+
+	template<typename ISA, typename Eval>
+	void Oscilloscope::calculateFundamentalPeriod()
+	{
+#ifdef PHASE_VOCODER
+		auto const TransformSize = OscilloscopeContent::LookaheadSize >> 1;
+#else
+		auto const TransformSize = OscilloscopeContent::LookaheadSize;
+#endif
+
+		if (state.customTrigger)
+		{
+			auto const normalizedFrequency = state.customTriggerFrequency / audioStream.getAudioHistorySamplerate();
+			triggerState.record = BinRecord{ 0, 1, normalizedFrequency * TransformSize};
+
+			auto fundamental = state.customTriggerFrequency;
+
+			triggerState.fundamental = state.customTriggerFrequency;
+			triggerState.cycleSamples = audioStream.getAudioHistorySamplerate() / fundamental;
+		}
+		else if(state.triggerMode == OscilloscopeContent::TriggeringMode::Spectral)
+		{
+			Eval eval(channelData);
+
+			if (!eval.isWellDefined())
+				return;
+
+			auto max = state.triggerPrecision == OscilloscopeContent::TransformPrecision::Single
+				? findFundamentalBin<ISA>(eval, singleTransformBuffer.data(), TransformSize)
+				: findFundamentalBin<ISA>(eval, transformBuffer.data(), TransformSize);
 
 			// copy old filter
 			auto localMedian = medianTriggerFilter;
@@ -320,14 +341,21 @@ namespace Signalizer
 			//requiredSampleBufferSize = static_cast<std::size_t>(0.5 + triggerState.cycleSamples + std::ceil(state.effectiveWindowSize) * 2) + OscilloscopeContent::LookaheadSize;
 			requiredSampleBufferSize = static_cast<std::size_t>(std::ceil(state.effectiveWindowSize + 1));
 		}
-		channelData.front.resizeStorage(requiredSampleBufferSize, std::max(requiredSampleBufferSize, audioStream.getAudioHistoryCapacity()));
-		channelData.back.resizeStorage(requiredSampleBufferSize, std::max(requiredSampleBufferSize, audioStream.getAudioHistoryCapacity()));
+		// windows published in the back buffer trail the newest audio by up to a window, plus the time until they're rendered
+		std::size_t headroom = 0;
+
+		if (state.triggerMode == OscilloscopeContent::TriggeringMode::EnvelopeHold || state.triggerMode == OscilloscopeContent::TriggeringMode::ZeroCrossing)
+			headroom = requiredSampleBufferSize + static_cast<std::size_t>(audioStream.getAudioHistorySamplerate() * OscilloscopeContent::PublishedWindowLatency);
+
+		channelData.resizeStorage(requiredSampleBufferSize, headroom, audioStream.getAudioHistoryCapacity());
 	}
 
 
 	template<typename ISA, class Analyzer>
 	void Oscilloscope::executeSamplingWindows(AFloat ** buffer, std::size_t numChannels, std::size_t & numSamples)
 	{
+		SIGNALIZER_TRACE_ZONE("Oscilloscope::executeSamplingWindows");
+
 		Analyzer ana(buffer, numChannels, numSamples, audioStream.getASyncPlayhead().getSteadyClock(), *triggerState.preprocessingTrigger);
 
 		auto mode = content->channelConfiguration.param.getAsTEnum<OscChannels>();
@@ -401,7 +429,8 @@ namespace Signalizer
 	template<typename ISA>
 	void Oscilloscope::audioEntryPoint(AFloat ** buffer, std::size_t numChannels, std::size_t numSamples)
 	{
-		cpl::CMutex scopedLock(bufferLock);
+		SIGNALIZER_TRACE_ZONE("Oscilloscope::audioEntryPoint");
+		MeasuredMutex scopedLock(bufferLock, LockStatistics::Owner::AsyncAudio);
 
 		// TODO: dynamically determine size
 		AFloat * localBuffers[2];
@@ -411,12 +440,15 @@ namespace Signalizer
 		for (std::size_t c = 0; c < numChannels; ++c)
 			localBuffers[c] = buffer[c];
 
-		triggerState.preprocessingTrigger->update(audioStream.getASyncPlayhead().getSteadyClock());
+		const auto steadyClock = audioStream.getASyncPlayhead().getSteadyClock();
+
+		triggerState.preprocessingTrigger->update(steadyClock);
 		preprocessAudio<ISA>(localBuffers, numChannels, numSamples);
 
 		if (state.triggerMode != OscilloscopeContent::TriggeringMode::EnvelopeHold && state.triggerMode != OscilloscopeContent::TriggeringMode::ZeroCrossing)
 		{
 			audioProcessing<ISA>(localBuffers, numChannels, numSamples, channelData.front);
+			channelData.publishFront(steadyClock + numSamples);
 		}
 		else
 		{
@@ -427,24 +459,30 @@ namespace Signalizer
 	template<typename ISA>
 		void Oscilloscope::audioProcessing(AFloat ** buffer, std::size_t numChannels, std::size_t numSamples, ChannelData::Buffer & target)
 		{
+			SIGNALIZER_TRACE_ZONE("Oscilloscope::audioProcessing");
+
 			if (numSamples == 0 || numChannels == 0)
 				return;
 
 			using namespace cpl::simd;
 			typedef AFloat T;
+			typedef typename ISA::V V;
 
 			auto const sampleRate = audioStream.getAudioHistorySamplerate();
+			const std::size_t bands = content->colourBands.param.getAsTEnum<OscilloscopeContent::ColourBands>() == OscilloscopeContent::ColourBands::Two ? 2 : 3;
 
 			channelData.resizeChannels(numChannels);
-			channelData.tuneColourSmoothing(content->colourSmoothing.getTransformedValue(), sampleRate);
-			channelData.tuneCrossOver(300, 3000, sampleRate);
-
+			channelData.tuneColouring({
+				content->lowCrossover.getTransformedValue(),
+				content->highCrossover.getTransformedValue(),
+				content->colourSmoothing.getTransformedValue(),
+				sampleRate,
+				bands
+			});
 
 			if (target.channels[0].audioData.getSize() < 1)
 				return;
 
-			auto colourSmoothPole = channelData.smoothFilterPole;
-
 			// (division by zero is well-defined)
 			const auto envelopeCoeff = std::exp(-1.0 / (content->envelopeWindow.getNormalizedValue() * audioStream.getAudioHistorySamplerate()));
 			T filterEnv[2] = { filters.envelope[0], filters.envelope[1] };
@@ -454,19 +492,16 @@ namespace Signalizer
 				return std::array<float, 3> {static_cast<AFloat>(colourParam.r.getValue()), static_cast<AFloat>(colourParam.g.getValue()), static_cast<AFloat>(colourParam.b.getValue())};
 			};
 
-			auto filterStates = [=](const auto & bands, auto & states)
-			{
-				for (std::size_t i = 0; i < ChannelData::Bands; ++i)
-				{
-					auto const input = bands[i] * bands[i];
-					states[i] = input + colourSmoothPole * (states[i] - input); // can also rectify
-				}
+			typedef decltype(colourArray(content->lowColour)) BandColour;
 
+			// energies of unused bands are zero
+			const BandColour colours[ChannelData::Bands] = {
+				colourArray(content->lowColour),
+				bands == 2 ? colourArray(content->highColour) : colourArray(content->midColour),
+				bands == 2 ? BandColour{} : colourArray(content->highColour)
 			};
 
-			decltype(colourArray(content->lowColour)) colours[] = { colourArray(content->lowColour), colourArray(content->midColour), colourArray(content->highColour) };
-
-			auto accumulateColour = [&colours](const auto & state, ChannelData::PixelType key, float blend)
+			auto accumulateColour = [&colours](const T * state, ChannelData::PixelType key, float blend)
 			{
 				typedef ChannelData::PixelType::ComponentType C;
 				ChannelData::PixelType ret;
@@ -491,6 +526,7 @@ namespace Signalizer
 			};
 
 			using fs = FilterStates;
+			using feeds = ChannelData::FilterStates;
 
 			auto mode = content->channelConfiguration.param.getAsTEnum<OscChannels>();
 
@@ -505,33 +541,13 @@ namespace Signalizer
 					firstColour(content->primaryColour.getAsJuceColour()),
 					secondColour(content->secondaryColour.getAsJuceColour());
 
-				auto sideSignal = [](const auto & left, const auto & right)
-				{
-					unq_typeof(left) ret;
-					for (std::size_t i = 0; i < ChannelData::Bands; ++i)
-						ret[i] = left[i] - right[i];
-					return ret;
-				};
-
-				auto midSignal = [](const auto & left, const auto & right)
-				{
-					unq_typeof(left) ret;
-					for (std::size_t i = 0; i < ChannelData::Bands; ++i)
-						ret[i] = left[i] + right[i];
-					return ret;
-				};
-
-				auto
-					leftSmoothState = channelData.filterStates.channels[fs::Left].smoothFilters,
-					rightSmoothState = channelData.filterStates.channels[fs::Right].smoothFilters,
-					midSmoothState = channelData.filterStates.midSideSmoothsFilters[0],
-					sideSmoothState = channelData.filterStates.midSideSmoothsFilters[1];
+				auto & splitter = channelData.filterStates.stereo;
 
 				auto &&
-					lw = target.channels[fs::Left].colourData.createWriter(),
-					rw = target.channels[fs::Right].colourData.createWriter(),
-					mw = target.midSideColour[0].createWriter(),
-					sw = target.midSideColour[1].createWriter();
+					lw = target.channels[fs::Left].colourData.entries.createWriter(),
+					rw = target.channels[fs::Right].colourData.entries.createWriter(),
+					mw = target.midSideColour[0].entries.createWriter(),
+					sw = target.midSideColour[1].entries.createWriter();
 
 				std::size_t offset = 0;
 
@@ -604,37 +620,49 @@ namespace Signalizer
 
 				}
 
-				for (std::size_t n = 0; n < numSamples; ++n)
+				// only analyse the feeds displayed in the channel configuration
+				std::size_t firstFeed = feeds::Left, lastFeed = feeds::Side + 1;
+
+				switch (mode)
 				{
+				case OscChannels::Left: firstFeed = feeds::Left; lastFeed = feeds::Left + 1; break;
+				case OscChannels::Right: firstFeed = feeds::Right; lastFeed = feeds::Right + 1; break;
+				case OscChannels::Mid: firstFeed = feeds::Mid; lastFeed = feeds::Mid + 1; break;
+				case OscChannels::Side: firstFeed = feeds::Side; lastFeed = feeds::Side + 1; break;
+				case OscChannels::Separate: firstFeed = feeds::Left; lastFeed = feeds::Right + 1; break;
+				case OscChannels::MidSide: firstFeed = feeds::Mid; lastFeed = feeds::Side + 1; break;
+				}
 
-					auto & lN = channelData.filterStates.channels[fs::Left].network;
-					auto & rN = channelData.filterStates.channels[fs::Right].network;
+				const ChannelData::PixelType keys[] = { firstColour, secondColour, firstColour, secondColour };
 
-					const auto left = buffer[fs::Left][n], right = buffer[fs::Right][n];
+				auto colourOf = [&](std::size_t feed)
+				{
+					// the other tracks still need entries to stay aligned, so just give them the static colour
+					return feed >= firstFeed && feed < lastFeed ? accumulateColour(splitter.getEnergies(feed), keys[feed], blend) : keys[feed];
+				};
 
-					// split signal into bands:
-					auto leftBands = rN.process(left, channelData.networkCoeffs);
-					auto rightBands = lN.process(right, channelData.networkCoeffs);
+				// colours are only stored at multiples of ColourDecimation, see ChannelData::ColourTrack
+				auto phase = static_cast<std::size_t>(target.written & (ChannelData::ColourDecimation - 1));
 
-					filterStates(leftBands, leftSmoothState);
-					filterStates(rightBands, rightSmoothState);
+				for (std::size_t n = 0; n < numSamples; ++n)
+				{
+					const auto left = buffer[fs::Left][n], right = buffer[fs::Right][n];
 
-					// magnitude doesn't matter for these, as we normalize the data anyway -
-					filterStates(midSignal(leftBands, rightBands), midSmoothState);
-					filterStates(sideSignal(leftBands, rightBands), sideSmoothState);
+					// split all feeds into bands at once.
+					// magnitude doesn't matter for mid and side, as we normalize the data anyway
+					const T inputs[] = { left, right, left + right, left - right };
+					splitter.process<V>(inputs, firstFeed, lastFeed);
 
-					lw.setHeadAndAdvance(accumulateColour(leftSmoothState, firstColour, blend));
-					rw.setHeadAndAdvance(accumulateColour(rightSmoothState, secondColour, blend));
-					mw.setHeadAndAdvance(accumulateColour(midSmoothState, firstColour, blend));
-					sw.setHeadAndAdvance(accumulateColour(sideSmoothState, secondColour, blend));
+					if (phase == 0)
+					{
+						lw.setHeadAndAdvance(colourOf(feeds::Left));
+						rw.setHeadAndAdvance(colourOf(feeds::Right));
+						mw.setHeadAndAdvance(colourOf(feeds::Mid));
+						sw.setHeadAndAdvance(colourOf(feeds::Side));
+					}
 
+					phase = (phase + 1) & (ChannelData::ColourDecimation - 1);
 				}
-
-				channelData.filterStates.channels[fs::Left].smoothFilters = leftSmoothState;
-				channelData.filterStates.channels[fs::Right].smoothFilters = rightSmoothState;
-				channelData.filterStates.midSideSmoothsFilters[0] = midSmoothState;
-				channelData.filterStates.midSideSmoothsFilters[1] = sideSmoothState;
-
 			}
 			else if (numChannels == 1)
 			{
@@ -642,8 +670,9 @@ namespace Signalizer
 					firstColour(content->primaryColour.getAsJuceColour());
 
 				filterEnv[1] = 0;
-				auto && lw = target.channels[fs::Left].colourData.createWriter();
-				auto leftSmoothState = channelData.filterStates.channels[fs::Left].smoothFilters;
+				auto && lw = target.channels[fs::Left].colourData.entries.createWriter();
+				auto & splitter = channelData.filterStates.mono;
+				auto phase = static_cast<std::size_t>(target.written & (ChannelData::ColourDecimation - 1));
 
 				for (std::size_t n = 0; n < numSamples; n++)
 				{
@@ -655,14 +684,14 @@ namespace Signalizer
 					// get peak sample
 
 					// split signal into bands:
-					auto leftBands = channelData.filterStates.channels[fs::Left].network.process(left, channelData.networkCoeffs);
-
-					filterStates(leftBands, leftSmoothState);
-					lw.setHeadAndAdvance(accumulateColour(leftSmoothState, firstColour, blend));
-				}
+					const T inputs[] = { left };
+					splitter.process<V>(inputs);
 
-				channelData.filterStates.channels[fs::Left].smoothFilters = leftSmoothState;
+					if (phase == 0)
+						lw.setHeadAndAdvance(accumulateColour(splitter.getEnergies(0), firstColour, blend));
 
+					phase = (phase + 1) & (ChannelData::ColourDecimation - 1);
+				}
 			}
 			// store calculated envelope
 			if (state.envelopeMode == EnvelopeModes::RMS)
@@ -677,23 +706,29 @@ namespace Signalizer
 
 				shared.autoGainEnvelope.store(currentEnvelope, std::memory_order_release);
 			}
+			else if (state.envelopeMode == EnvelopeModes::PeakDecay)
+			{
+				runPeakFilter<ISA>(buffer, numChannels, numSamples, mode);
+			}
 
 			// save audio data
 			for(std::size_t c = 0; c < target.channels.size(); ++c)
 				target.channels[c].audioData.createWriter().copyIntoHead(buffer[c], numSamples);
 
+			target.advance(numSamples);
+
 			state.transportPosition = audioStream.getASyncPlayhead().getPositionInSamples() + numSamples;
 
 		}
 
 	template<typename ISA>
-		void Oscilloscope::runPeakFilter()
+		void Oscilloscope::runPeakFilter(AFloat ** buffer, std::size_t numChannels, std::size_t numSamples, OscChannels mode)
 		{
 			// there is a number of optimisations we can do here, mostly that we actually don't care about
 			// timing, we are only interested in the current largest value in the set.
 			using namespace cpl;
 			using namespace cpl::simd;
-			using cpl::simd::load;
+			using cpl::simd::loadu;
 
 			typedef typename ISA::V V;
 
@@ -706,147 +741,111 @@ namespace Signalizer
 
 			auto const vHalf = consts<V>::half;
 
-			if (state.channelMode <= OscChannels::OffsetForMono)
-			{
-				auto && view = channelData.front.channels[0].audioData.createProxyView();
-
-				std::size_t numSamples = view.size();
-
-				const auto * leftBuffer = view.begin();
+			if (numSamples == 0 || numChannels == 0)
+				return;
 
-				auto stop = numSamples - (numSamples & (loopIncrement - 1));
-				if (stop <= 0)
-					stop = 0;
+			const auto * leftBuffer = buffer[0];
+			const auto * rightBuffer = buffer[numChannels > 1 ? 1 : 0];
 
-				// since this runs in every frame, we need to scale the coefficient by how often this function runs
-				// (and the amount of samples)
-				double power = numSamples * (avgFps.getAverage() / juce::Time::getHighResolutionTicksPerSecond());
-				double coeff = std::pow(std::exp(-static_cast<double>(loopIncrement) / (content->envelopeWindow.getNormalizedValue() * audioStream.getAudioHistorySamplerate())), power);
+			auto const stop = numSamples - (numSamples & (loopIncrement - 1));
 
-				if (state.channelMode == OscChannels::Left)
+			switch (mode)
+			{
+			case OscChannels::Left:
+				for (std::size_t i = 0; i < stop; i += loopIncrement)
 				{
-					for (std::size_t i = 0; i < stop; i += loopIncrement)
-					{
-						auto const vLInput = load<V>(leftBuffer + i);
-						vLMax = max(vand(vLInput, vSign), vLMax);
-					}
+					auto const vLInput = loadu<V>(leftBuffer + i);
+					vLMax = max(vand(vLInput, vSign), vLMax);
 				}
-				else
+				break;
+			case OscChannels::Right:
+				for (std::size_t i = 0; i < stop; i += loopIncrement)
 				{
-					if (channelData.front.channels.size() < 2)
-					{
-						shared.autoGainEnvelope.store(1, std::memory_order_release);
-						return;
-					}
-
-					auto && rightView = channelData.front.channels[1].audioData.createProxyView();
-					const auto * rightBuffer = rightView.begin();
-
-					switch (state.channelMode)
-					{
-					case OscChannels::Right:
-
-						for (std::size_t i = 0; i < stop; i += loopIncrement)
-						{
-							auto const vLInput = load<V>(rightBuffer + i);
-							vLMax = max(vand(vLInput, vSign), vLMax);
-						}
-						break;
-					case OscChannels::Mid:
-						for (std::size_t i = 0; i < stop; i += loopIncrement)
-						{
-							auto const vInput = load<V>(leftBuffer + i) + load<V>(rightBuffer + i);
-							vLMax = max(vand(vInput * vHalf, vSign), vLMax);
-						}
-						break;
-					case OscChannels::Side:
-
-						for (std::size_t i = 0; i < stop; i += loopIncrement)
-						{
-							auto const vInput = load<V>(leftBuffer + i) - load<V>(rightBuffer + i);
-							vLMax = max(vand(vInput * vHalf, vSign), vLMax);
-						}
-						break;
-					}
+					auto const vLInput = loadu<V>(rightBuffer + i);
+					vLMax = max(vand(vLInput, vSign), vLMax);
 				}
-
-				vRMax = vLMax;
-
-				// TODO: remainder?
-
-				suitable_container<V> lmax = vLMax, rmax = vRMax;
-
-				double highestLeft = *std::max_element(lmax.begin(), lmax.end());
-				double highestRight = *std::max_element(rmax.begin(), rmax.end());
-
-				filters.envelope[0] = std::max(filters.envelope[0] * coeff, highestLeft  * highestLeft);
-				filters.envelope[1] = std::max(filters.envelope[1] * coeff, highestRight * highestRight);
-
-				shared.autoGainEnvelope.store(1.0 / std::max(std::sqrt(filters.envelope[0]), std::sqrt(filters.envelope[1])), std::memory_order_release);
-
-			}
-			else
-			{
-				if (channelData.front.channels.size() < 2)
+				break;
+			case OscChannels::Mid:
+				for (std::size_t i = 0; i < stop; i += loopIncrement)
 				{
-					shared.autoGainEnvelope.store(1, std::memory_order_release);
-					return;
+					auto const vInput = loadu<V>(leftBuffer + i) + loadu<V>(rightBuffer + i);
+					vLMax = max(vand(vInput * vHalf, vSign), vLMax);
 				}
+				break;
+			case OscChannels::Side:
+				for (std::size_t i = 0; i < stop; i += loopIncrement)
+				{
+					auto const vInput = loadu<V>(leftBuffer + i) - loadu<V>(rightBuffer + i);
+					vLMax = max(vand(vInput * vHalf, vSign), vLMax);
+				}
+				break;
+			case OscChannels::Separate:
+				for (std::size_t i = 0; i < stop; i += loopIncrement)
+				{
+					auto const vLInput = loadu<V>(leftBuffer + i);
+					vLMax = max(vand(vLInput, vSign), vLMax);
+					auto const vRInput = loadu<V>(rightBuffer + i);
+					vRMax = max(vand(vRInput, vSign), vRMax);
+				}
+				break;
+			case OscChannels::MidSide:
+				for (std::size_t i = 0; i < stop; i += loopIncrement)
+				{
+					auto const vLInput = loadu<V>(leftBuffer + i);
+					auto const vRInput = loadu<V>(rightBuffer + i);
 
-				ChannelData::AudioBuffer::ProxyView views[2] = { channelData.front.channels[0].audioData.createProxyView(), channelData.front.channels[1].audioData.createProxyView() };
+					auto const a = vLInput + vRInput;
+					auto const b = vLInput - vRInput;
 
-				std::size_t numSamples = views[0].size();
+					vLMax = max(vand(a * vHalf, vSign), vLMax);
+					vRMax = max(vand(b * vHalf, vSign), vRMax);
+				}
+				break;
+			default:
+				break;
+			}
 
-				const auto * leftBuffer = views[0].begin();
-				const auto * rightBuffer = views[1].begin();
+			suitable_container<V> lmax = vLMax, rmax = vRMax;
 
-				auto stop = numSamples - (numSamples & (loopIncrement - 1));
-				if (stop <= 0)
-					stop = 0;
+			double highestLeft = *std::max_element(lmax.begin(), lmax.end());
+			double highestRight = *std::max_element(rmax.begin(), rmax.end());
 
-				// since this runs in every frame, we need to scale the coefficient by how often this function runs
-				// (and the amount of samples)
-				double power = numSamples * (avgFps.getAverage() / juce::Time::getHighResolutionTicksPerSecond());
-				double coeff = std::pow(std::exp(-static_cast<double>(loopIncrement) / (content->envelopeWindow.getNormalizedValue() * audioStream.getAudioHistorySamplerate())), power);
+			// remainder
+			for (std::size_t i = stop; i < numSamples; ++i)
+			{
+				const double left = leftBuffer[i], right = rightBuffer[i];
 
-				switch (state.channelMode)
+				switch (mode)
 				{
+				case OscChannels::Left: highestLeft = std::max(highestLeft, std::abs(left)); break;
+				case OscChannels::Right: highestLeft = std::max(highestLeft, std::abs(right)); break;
+				case OscChannels::Mid: highestLeft = std::max(highestLeft, std::abs(0.5 * (left + right))); break;
+				case OscChannels::Side: highestLeft = std::max(highestLeft, std::abs(0.5 * (left - right))); break;
 				case OscChannels::Separate:
-					for (std::size_t i = 0; i < stop; i += loopIncrement)
-					{
-						auto const vLInput = load<V>(leftBuffer + i);
-						vLMax = max(vand(vLInput, vSign), vLMax);
-						auto const vRInput = load<V>(rightBuffer + i);
-						vRMax = max(vand(vRInput, vSign), vRMax);
-					}
+					highestLeft = std::max(highestLeft, std::abs(left));
+					highestRight = std::max(highestRight, std::abs(right));
 					break;
 				case OscChannels::MidSide:
-					for (std::size_t i = 0; i < stop; i += loopIncrement)
-					{
-						auto const vLInput = load<V>(leftBuffer + i);
-						auto const vRInput = load<V>(rightBuffer + i);
-
-						auto const a = vLInput + vRInput;
-						auto const b = vLInput - vRInput;
-
-						vLMax = max(vand(a * vHalf, vSign), vLMax);
-						vRMax = max(vand(b * vHalf, vSign), vRMax);
-					}
+					highestLeft = std::max(highestLeft, std::abs(0.5 * (left + right)));
+					highestRight = std::max(highestRight, std::abs(0.5 * (left - right)));
+					break;
+				default:
 					break;
 				}
+			}
 
-				// TODO: remainder?
-
-				suitable_container<V> lmax = vLMax, rmax = vRMax;
-
-				double highestLeft = *std::max_element(lmax.begin(), lmax.end());
-				double highestRight = *std::max_element(rmax.begin(), rmax.end());
+			if (mode <= OscChannels::OffsetForMono)
+				highestRight = highestLeft;
 
-				filters.envelope[0] = std::max(filters.envelope[0] * coeff, highestLeft  * highestLeft);
-				filters.envelope[1] = std::max(filters.envelope[1] * coeff, highestRight * highestRight);
+			// this used to run on the whole displayed window for every frame, decaying by the window size times the frame time.
+			// running for every block instead, the same decay rate is the window size times the block time.
+			// (the vector width was part of the pole as well, so it is kept for presets to look the same)
+			const double power = channelData.displayedSamples * (numSamples / audioStream.getAudioHistorySamplerate());
+			const double coeff = std::pow(std::exp(-static_cast<double>(loopIncrement) / (content->envelopeWindow.getNormalizedValue() * audioStream.getAudioHistorySamplerate())), power);
 
-				shared.autoGainEnvelope.store(1.0 / std::max(std::sqrt(filters.envelope[0]), std::sqrt(filters.envelope[1])), std::memory_order_release);
+			filters.envelope[0] = std::max(filters.envelope[0] * coeff, highestLeft  * highestLeft);
+			filters.envelope[1] = std::max(filters.envelope[1] * coeff, highestRight * highestRight);
 
-			}
+			shared.autoGainEnvelope.store(1.0 / std::max(std::sqrt(filters.envelope[0]), std::sqrt(filters.envelope[1])), std::memory_order_release);
 		}
 };
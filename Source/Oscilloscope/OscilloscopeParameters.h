@@ -44,6 +44,10 @@
 
 			static constexpr std::size_t LookaheadSize = 8192;
 			static constexpr std::size_t InterpolationKernelSize = 10;
+			/// <summary>
+			/// Seconds a window published by the triggers can wait to be rendered, before being overwritten.
+			/// </summary>
+			static constexpr double PublishedWindowLatency = 0.25;
 
 			enum class TriggeringMode
 			{
@@ -65,6 +69,19 @@
 				Static, SpectralEnergy
 			};
 
+			enum class TransformPrecision
+			{
+				Double, Single
+			};
+
+			/// <summary>
+			/// Amount of frequency bands for spectral colouring. Two bands use the low and high colours.
+			/// </summary>
+			enum class ColourBands
+			{
+				Three, Two
+			};
+
 			template<typename ParameterView>
 			class WindowSizeTransformatter : public AudioHistoryTransformatter<ParameterView>
 			{
@@ -414,6 +431,10 @@
 					, kfreqColourBlend(&parentValue.frequencyColouringBlend)
 					, ktriggerHysteresis(&parentValue.triggerHysteresis)
 					, ktriggerThreshold(&parentValue.triggerThreshold)
+					, ktriggerPrecision(&parentValue.triggerPrecision.param)
+					, klowCrossover(&parentValue.lowCrossover)
+					, khighCrossover(&parentValue.highCrossover)
+					, kcolourBands(&parentValue.colourBands.param)
 
 					, editorSerializer(
 						*this,
@@ -498,6 +519,10 @@
 					kfreqColourBlend.bSetTitle("Colour blend");
 					ktriggerHysteresis.bSetTitle("Hysteresis");
 					ktriggerThreshold.bSetTitle("Trigger thrshld");
+					ktriggerPrecision.bSetTitle("Trigger precision");
+					klowCrossover.bSetTitle("Low crossover");
+					khighCrossover.bSetTitle("High crossover");
+					kcolourBands.bSetTitle("Colour bands");
 					// buttons n controls
 
 					kantiAlias.setSingleText("Antialias");
@@ -532,6 +557,7 @@
 					kpctForDivision.bSetDescription("The minimum amount of free space that triggers a recursed frequency grid division; smaller values draw more frequency divisions.");
 					kchannelConfiguration.bSetDescription("Select how the audio channels are interpreted.");
 					ktriggerMode.bSetDescription("Select a mode for triggering waveforms - i.e. syncing to frequency content, time or transition information");
+					ktriggerPrecision.bSetDescription("Select the floating point precision of the fourier transform used for spectral triggering; single precision is faster.");
 					ktriggerPhaseOffset.bSetDescription("A custom +/- full-circle offset for the phase on triggering");
 					ktimeMode.bSetDescription("Specifies the working units of the time display");
 					kdotSamples.bSetDescription("Marks sample positions when drawing subsampled interpolated lines");
@@ -548,6 +574,9 @@
 					ktrackerColour.bSetDescription("Colour of the cursor tracker");
 					ktriggerHysteresis.bSetDescription("The hysteresis of the triggering function defines an opaque measure of how resistant the trigger is to change");
 					ktriggerThreshold.bSetDescription("The triggering function will not consider any candidates below the threshold");
+					klowCrossover.bSetDescription("The frequency separating the low band from the mid band (or the high band, when using two bands)");
+					khighCrossover.bSetDescription("The frequency separating the mid band from the high band");
+					kcolourBands.bSetDescription("The amount of frequency bands used for spectral colouring; two bands are split at the low crossover");
 				}
 
 				void initUI()
@@ -592,6 +621,8 @@
 							section->addControl(&kcustomFrequency, 0);
 							section->addControl(&ktriggerOnCustomFrequency, 1);
 
+							section->addControl(&ktriggerPrecision, 0);
+
 							page->addSection(section, "Spatial");
 						}
 					}
@@ -630,6 +661,10 @@
 							section->addControl(&kmidColour, 0);
 							section->addControl(&khighColour, 1);
 
+							section->addControl(&klowCrossover, 0);
+							section->addControl(&khighCrossover, 1);
+							section->addControl(&kcolourBands, 0);
+
 							page->addSection(section, "Spectral colouring");
 						}
 					}
@@ -679,6 +714,10 @@
 					archive << kfreqColourBlend;
 					archive << ktriggerHysteresis;
 					archive << ktriggerThreshold;
+					archive << ktriggerPrecision;
+					archive << klowCrossover;
+					archive << khighCrossover;
+					archive << kcolourBands;
 				}
 
 				void deserializeEditorSettings(cpl::CSerializer::Archiver & builder, cpl::Version version)
@@ -729,6 +768,14 @@
 						builder >> ktriggerThreshold;
 					}
 
+					if (version >= cpl::Version(0, 3, 3))
+					{
+						builder >> ktriggerPrecision;
+						builder >> klowCrossover;
+						builder >> khighCrossover;
+						builder >> kcolourBands;
+					}
+
 				}
 
 
@@ -769,10 +816,10 @@
 				cpl::CValueInputControl kcustomFrequency;
 				cpl::CValueKnobSlider
 					kwindow, kgain, kprimitiveSize, kenvelopeSmooth, kpctForDivision, ktriggerPhaseOffset, kcolourSmoothingTime, kfreqColourBlend,
-					ktriggerHysteresis, ktriggerThreshold;
+					ktriggerHysteresis, ktriggerThreshold, klowCrossover, khighCrossover;
 				cpl::CColourControl kprimaryColour, ksecondaryColour, kgraphColour, kbackgroundColour, klowColour, kmidColour, khighColour, ktrackerColour;
 				cpl::CTransformWidget ktransform;
-				cpl::CValueComboBox kenvelopeMode, ksubSampleInterpolationMode, kchannelConfiguration, ktriggerMode, ktimeMode, kchannelColouring;
+				cpl::CValueComboBox kenvelopeMode, ksubSampleInterpolationMode, kchannelConfiguration, ktriggerMode, ktimeMode, kchannelColouring, ktriggerPrecision, kcolourBands;
 				cpl::CPresetWidget kpresets;
 
 				OscilloscopeContent & parent;
@@ -796,9 +843,11 @@
 				, customTriggerRange(5, 48000)
 				, colourSmoothRange(0.001, 1000)
 				, triggerThresholdRange(0, 4)
+				, crossoverRange(20, 20000)
 				, msFormatter("ms")
 				, degreeFormatter("degs")
 				, ptsFormatter("pts")
+				, hzFormatter("Hz")
 				, customTriggerFormatter(system.getAudioStream())
 
 				, autoGain("AutoGain")
@@ -814,6 +863,7 @@
 				, triggerPhaseOffset("TrgPhase", phaseRange, degreeFormatter)
 				, triggerMode("TrgMode")
 				, timeMode("TimeMode")
+				, triggerPrecision("TrgPrec")
 				, dotSamples("DotSmps", boolRange, boolFormatter)
 				, triggerOnCustomFrequency("CustomTrg", boolRange, boolFormatter)
 				, customTriggerFrequency("TrgFreq", customTriggerRange, customTriggerFormatter)
@@ -824,6 +874,9 @@
 				, frequencyColouringBlend("FColBlend", unityRange, pctFormatter)
 				, triggerHysteresis("TrgHstrs", unityRange, pctFormatter)
 				, triggerThreshold("TrgThrhold", triggerThresholdRange, dbFormatter)
+				, lowCrossover("LowXOver", crossoverRange, hzFormatter)
+				, highCrossover("HighXOver", crossoverRange, hzFormatter)
+				, colourBands("ColBands")
 
 				, colourBehaviour()
 				, primaryColour(colourBehaviour, "Prim.")
@@ -849,6 +902,8 @@
 				triggerMode.fmt.setValues({ "None", "Spectral", "Window", "Envelope" , "Zero-crossing"});
 				timeMode.fmt.setValues({ "Time", "Cycles", "Beats" });
 				channelColouring.fmt.setValues({ "Static", "Spectral energy" });
+				triggerPrecision.fmt.setValues({ "Double", "Single" });
+				colourBands.fmt.setValues({ "3", "2" });
 
 				// order matters
 				auto singleParameters = {
@@ -874,7 +929,11 @@
 					&cursorTracker,
 					&frequencyColouringBlend,
 					&triggerHysteresis,
-					&triggerThreshold
+					&triggerThreshold,
+					&triggerPrecision.param,
+					&lowCrossover,
+					&highCrossover,
+					&colourBands.param
 				};
 
 				for (auto sparam : singleParameters)
@@ -896,6 +955,11 @@
 
 				parameterSet.seal();
 				audioHistoryTransformatter.initialize(windowSize.getParameterView());
+
+				// the fixed crossovers of earlier versions
+				lowCrossover.setTransformedValue(300);
+				highCrossover.setTransformedValue(3000);
+
 				timeMode.param.getParameterView().addListener(this);
 			}
 
@@ -958,6 +1022,10 @@
 				archive << frequencyColouringBlend;
 				archive << triggerHysteresis;
 				archive << triggerThreshold;
+				archive << triggerPrecision.param;
+				archive << lowCrossover;
+				archive << highCrossover;
+				archive << colourBands.param;
 			}
 
 			virtual void deserialize(cpl::CSerializer::Builder & builder, cpl::Version version) override
@@ -1006,6 +1074,14 @@
 					builder >> triggerHysteresis;
 					builder >> triggerThreshold;
 				}
+
+				if (version >= cpl::Version(0, 3, 3))
+				{
+					builder >> triggerPrecision.param;
+					builder >> lowCrossover;
+					builder >> highCrossover;
+					builder >> colourBands.param;
+				}
 			}
 
 			WindowSizeTransformatter<ParameterSet::ParameterView> audioHistoryTransformatter;
@@ -1016,7 +1092,8 @@
 			cpl::UnitFormatter<double>
 				msFormatter,
 				degreeFormatter,
-				ptsFormatter;
+				ptsFormatter,
+				hzFormatter;
 
 			cpl::PercentageFormatter<double>
 				pctFormatter;
@@ -1027,7 +1104,7 @@
 			cpl::BasicFormatter<double> basicFormatter;
 			cpl::BooleanRange<double> boolRange;
 
-			cpl::ExponentialRange<double> dbRange, colourSmoothRange;
+			cpl::ExponentialRange<double> dbRange, colourSmoothRange, crossoverRange;
 
 			cpl::LinearRange<double>
 				ptsRange,
@@ -1062,7 +1139,12 @@
 				cursorTracker,
 				frequencyColouringBlend,
 				triggerHysteresis,
-				triggerThreshold;
+				triggerThreshold,
+				/// <summary>
+				/// Crossover frequencies of the spectral colouring bands.
+				/// </summary>
+				lowCrossover,
+				highCrossover;
 
 			std::vector<cpl::ParameterValue<ParameterSet::ParameterView>> viewOffsets;
 
@@ -1072,7 +1154,15 @@
 				subSampleInterpolation,
 				triggerMode,
 				timeMode,
-				channelColouring;
+				channelColouring,
+				/// <summary>
+				/// The floating point precision of the spectral trigger's fourier transform, see TransformPrecision.
+				/// </summary>
+				triggerPrecision,
+				/// <summary>
+				/// See ColourBands.
+				/// </summary>
+				colourBands;
 
 			cpl::ParameterColourValue<ParameterSet::ParameterView>::SharedBehaviour colourBehaviour;
 
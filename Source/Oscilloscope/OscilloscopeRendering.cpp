@@ -100,6 +100,22 @@ namespace Signalizer
 				triggerState.sampleOffset);
 			g.drawSingleLineText(textbuf.get(), 10, 20);
 
+			char latencyText[100];
+			sprintf_s(latencyText, "latency: %.1f ms (p50: %.1f ms, p99: %.1f ms)", latency.getLatest(), latency.getPercentile(0.5), latency.getPercentile(0.99));
+			g.drawSingleLineText(latencyText, 10, 40);
+
+			if (state.triggerMode == OscilloscopeContent::TriggeringMode::EnvelopeHold || state.triggerMode == OscilloscopeContent::TriggeringMode::ZeroCrossing)
+			{
+				char triggerText[100];
+				sprintf_s(triggerText, "triggers: %llu dropped, %llu coalesced",
+					static_cast<unsigned long long>(triggerState.preprocessingTrigger->getDroppedTriggers()),
+					static_cast<unsigned long long>(triggerState.preprocessingTrigger->getCoalescedTriggers()));
+				g.drawSingleLineText(triggerText, 10, 60);
+			}
+
+			g.drawSingleLineText(bufferLock.statistics.describe(LockStatistics::Owner::AsyncAudio), 10, 80);
+			g.drawSingleLineText(bufferLock.statistics.describe(LockStatistics::Owner::Rendering), 10, 100);
+
 		}
 
 		auto bounds = getLocalBounds().toFloat();
@@ -237,6 +253,44 @@ namespace Signalizer
 		cpl::simd::dynamic_isa_dispatch<float, RenderingDispatcher>(*this);
 	}
 
+	void Oscilloscope::analyseDisplay()
+	{
+		cpl::simd::dynamic_isa_dispatch<float, AnalysisDispatcher>(*this);
+	}
+
+	template<typename ISA>
+		void Oscilloscope::analyseDisplay()
+		{
+			// see checkAndInformInvalidCombinations()
+			if (state.timeMode == OscilloscopeContent::TimeMode::Cycles && state.triggerMode != OscilloscopeContent::TriggeringMode::Spectral)
+				return;
+
+			if (channelData.front.channels.size() == 0 || channelData.filterStates.channels.size() == 0)
+				return;
+
+			auto mode = state.channelMode;
+
+			if (mode > OscChannels::OffsetForMono && channelData.front.channels.size() < 2)
+				mode = OscChannels::Left;
+
+			// the same evaluators as vectorGLRendering() analyses with
+			switch (mode)
+			{
+			default: case OscChannels::Left: case OscChannels::Separate:
+				analyseAndSetupState<ISA, SampleColourEvaluator<OscChannels::Left, 0>>();
+				break;
+			case OscChannels::Right:
+				analyseAndSetupState<ISA, SampleColourEvaluator<OscChannels::Right, 0>>();
+				break;
+			case OscChannels::Mid: case OscChannels::MidSide:
+				analyseAndSetupState<ISA, SampleColourEvaluator<OscChannels::Mid, 0>>();
+				break;
+			case OscChannels::Side:
+				analyseAndSetupState<ISA, SampleColourEvaluator<OscChannels::Side, 0>>();
+				break;
+			}
+		}
+
 	bool Oscilloscope::checkAndInformInvalidCombinations()
 	{
 		if (state.timeMode == OscilloscopeContent::TimeMode::Cycles && state.triggerMode != OscilloscopeContent::TriggeringMode::Spectral)
@@ -258,13 +312,18 @@ namespace Signalizer
 	template<typename ISA>
 		void Oscilloscope::vectorGLRendering()
 		{
+			SIGNALIZER_TRACE_THREAD("Rendering");
+			SIGNALIZER_TRACE_ZONE("Oscilloscope::render");
+
             auto cStart = cpl::Misc::ClockCounter();
             CPL_DEBUGCHECKGL();
             
 			{
-                cpl::CMutex lock(bufferLock);
+                MeasuredMutex lock(bufferLock, LockStatistics::Owner::Rendering);
                 
                 handleFlagUpdates();
+                // the window to render in this frame
+                channelData.acquireDisplay();
                 
                 juce::OpenGLHelpers::clear(state.colourBackground);
                 
@@ -348,6 +407,8 @@ namespace Signalizer
 				}
 			);
 
+			latency.frameDrawn(content->systemView.getBlockTimeline(), channelData.display.clock);
+
 			auto tickNow = juce::Time::getHighResolutionTicks();
 			avgFps.setNext(tickNow - lastFrameTick);
 			lastFrameTick = tickNow;
@@ -533,6 +594,7 @@ namespace Signalizer
 	template<typename ISA, typename Evaluator>
 		void Oscilloscope::drawWavePlot(cpl::OpenGLRendering::COpenGLStack & openGLStack)
 		{
+			SIGNALIZER_TRACE_ZONE("Oscilloscope::drawWavePlot");
 
 			typedef cpl::OpenGLRendering::PrimitiveDrawer<1024> Renderer;
 
@@ -684,6 +746,68 @@ namespace Signalizer
 				dotSamples(0);
 			}
 
+			const auto samplesPerPixel = 1.0 / pixelsPerSample;
+
+			// with many samples per pixel, draw the ranges of decimated buckets instead, so the cost follows the display width.
+			if (state.sampleInterpolation != SubSampleInterpolation::None && samplesPerPixel >= (1 << ChannelData::LevelPyramid::minLevel))
+			{
+				renderSampleSpace(
+					[&] (Evaluator & evaluator, Renderer & drawer)
+					{
+						const auto & levels = evaluator.getLevels();
+
+						if (!levels.hasLevels())
+							return;
+
+						// 1 - 2 buckets per pixel
+						const auto level = std::min<std::size_t>(levels.getMaxLevel(), static_cast<std::size_t>(std::log2(samplesPerPixel)));
+						const auto bucketSize = std::int64_t(1) << level;
+
+						// absolute sample position of x = 0; the evaluator started bufferOffset samples behind the end of the window
+						const auto origin = static_cast<std::int64_t>(levels.getWritten()) - evaluator.getWindowDistance() - bufferOffset;
+
+						// only visit buckets inside the view (x = offset + (i - 1) * sampleDisplacement)
+						const auto firstVisible = static_cast<std::int64_t>(std::floor((left - offset) / sampleDisplacement));
+						const auto lastVisible = static_cast<std::int64_t>(std::ceil((right - offset) / sampleDisplacement)) + 2;
+
+						const auto first = std::max({ origin + std::max<std::int64_t>(0, firstVisible), static_cast<std::int64_t>(levels.getOldest()) });
+						const auto last = std::min({ origin + std::min<std::int64_t>(static_cast<std::int64_t>(endCondition), lastVisible), static_cast<std::int64_t>(levels.getComplete()) });
+
+						if (first >= last)
+							return;
+
+						if (!state.colourChannelsByFrequency)
+							drawer.addColour(evaluator.getDefaultKey());
+
+						const auto centre = 0.5 * (bucketSize - 1) - origin;
+
+						for (auto index = first / bucketSize; index * bucketSize < last; ++index)
+						{
+							const auto & bucket = levels.getBucket(level, static_cast<std::uint64_t>(index));
+							const auto x = static_cast<GLfloat>(index * bucketSize + centre);
+
+							if (state.colourChannelsByFrequency)
+								drawer.addColour(bucket.colour);
+
+							// alternate the direction, so the strip doesn't cross itself between buckets
+							if (index & 1)
+							{
+								drawer.addVertex(x, bucket.high, 0);
+								drawer.addVertex(x, bucket.low, 0);
+							}
+							else
+							{
+								drawer.addVertex(x, bucket.low, 0);
+								drawer.addVertex(x, bucket.high, 0);
+							}
+						}
+					},
+					GL_LINE_STRIP
+				);
+
+				return;
+			}
+
 			// TODO: Add scaled rendering (getAttachedContext()->getRenderingScale())
 			switch (interpolation)
 			{
@@ -772,8 +896,8 @@ namespace Signalizer
 				case SubSampleInterpolation::Lanczos:
 				{
 
+					typedef typename ISA::V V;
 					auto const KernelSize = OscilloscopeContent::InterpolationKernelSize;
-					auto const KernelBufferSize = KernelSize * 2 + 1;
 
 					double samplePos = 0;
 
@@ -803,69 +927,56 @@ namespace Signalizer
 					// adjust for left
 					double inc = horizontalDelta / (oglc->getRenderingScale() * (getWidth() - 1));
 					double unitSpacePos = left;
-					double samplesPerPixel = 1.0 / (pixelsPerSample);
 
 					samplePos += -unitSpacePos / inc * samplesPerPixel;
-					double currentSample = std::floor(samplePos);
+					const auto firstSample = static_cast<cpl::ssize_t>(std::floor(samplePos));
 
 					Evaluator eval(channelData);
 
 					if (!eval.isWellDefined())
 						return;
 
-					eval.startFrom(-static_cast<cpl::ssize_t>(std::floor(samplePos)) - (int)KernelSize, 2 - KernelBufferSize - static_cast<cpl::ssize_t>(std::floor(samplePos)));
+					// copy the samples spanned by the view (and the kernel) into a contiguous window,
+					// starting KernelSize samples before the first sample.
+					const auto numVertices = static_cast<std::size_t>((right + inc - left) / inc) + 2;
+					const double firstPosition = KernelSize + (firstSample - samplePos);
+					const auto numSamples = static_cast<std::size_t>(std::ceil(firstPosition + numVertices * samplesPerPixel)) + lanczos.getStride() + 1;
 
-					AFloat kernel[KernelBufferSize];
+					lanczosSamples.resize(numSamples);
+					lanczosColours.resize(numSamples);
 
-					typename Evaluator::ColourT currentColour, nextColour;
+					eval.startFrom(-firstSample - static_cast<cpl::ssize_t>(KernelSize));
 
-					auto get = [&]() {
-						auto data = eval.evaluate();
+					for (std::size_t i = 0; i < numSamples; ++i)
+					{
+						const auto data = eval.evaluate();
+						lanczosSamples[i] = data.first;
+						lanczosColours[i] = data.second;
 						eval.inc();
-						currentColour = nextColour;
-						nextColour = data.second;
-
-						return data.first;
-					};
-
-					auto insert = [&] (auto val) {
-						std::rotate(kernel, kernel + 1, kernel + KernelBufferSize);
-						kernel[KernelBufferSize - 1] = val;
-					};
-
-					std::for_each(std::begin(kernel), std::end(kernel), [&](auto & f) { f = get(); });
+					}
 
 					{
 						cpl::OpenGLRendering::PrimitiveDrawer<1024> drawer(openGLStack, GL_LINE_STRIP);
 						if (!state.colourChannelsByFrequency)
 							drawer.addColour(eval.getDefaultKey());
-						else
-							drawer.addColour(currentColour);
 
-						do
-						{
-							auto delta = currentSample - samplePos;
+						double position = firstPosition;
 
-							while (delta > 1)
-							{
-								samplePos += 1;
-								delta -= 1;
-								insert(get());
-							}
-
-							const auto interpolatedValue = cpl::dsp::lanczosFilter<double>(kernel, KernelBufferSize, (KernelSize) + delta, KernelSize);
+						for (std::size_t v = 0; v < numVertices && unitSpacePos < (right + inc); ++v)
+						{
+							const auto interpolatedValue = lanczos.interpolate<V>(lanczosSamples.data(), position);
 
 							if (state.colourChannelsByFrequency)
 							{
-								drawer.addColour(currentColour.lerp(nextColour, delta));
+								const auto index = static_cast<std::size_t>(position);
+								drawer.addColour(lanczosColours[index].lerp(lanczosColours[index + 1], static_cast<float>(position - index)));
 							}
 
 							drawer.addVertex(unitSpacePos, interpolatedValue, 0);
-							currentSample += samplesPerPixel;
 
+							position += samplesPerPixel;
 							unitSpacePos += inc;
-
-						} while (unitSpacePos < (right + inc));
+						}
 					}
 
 
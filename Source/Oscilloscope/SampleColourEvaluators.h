@@ -61,15 +61,31 @@
 
 				SimpleChannelEvaluator(ChannelData & data)
 					: DefaultKey(data, ColourIndex)
-					, audioView(data.front.channels.at(ChannelIndex).audioData.createProxyView())
-					, colourView(data.front.channels.at(ChannelIndex).colourData.createProxyView())
+					, audioView(data.display.buffer->channels.at(ChannelIndex).audioData.createProxyView())
+					, colours(data.display.buffer->channels.at(ChannelIndex).colourData, data.display.buffer->written)
+					, levels(data.display.buffer->channels.at(ChannelIndex).levels)
+					, windowDistance(static_cast<cpl::ssize_t>(data.display.distance))
+					, written(static_cast<std::int64_t>(data.display.buffer->written))
 				{
 
 				}
 
+				const ChannelData::LevelPyramid & getLevels() const noexcept
+				{
+					return levels;
+				}
+
+				/// <summary>
+				/// The amount of samples the end of the displayed window is behind the newest sample.
+				/// </summary>
+				cpl::ssize_t getWindowDistance() const noexcept
+				{
+					return windowDistance;
+				}
+
 				inline bool isWellDefined() const noexcept
 				{
-					return audioView.size() > 0 && colourView.size() > 0;
+					return audioView.size() > 0 && colours.size() > 0;
 				}
 
 				void startFrom(cpl::ssize_t offset)
@@ -79,6 +95,10 @@
 
 				void startFrom(cpl::ssize_t audioOffset, cpl::ssize_t colourOffset)
 				{
+					// offsets are relative to the end of the displayed window
+					audioOffset -= windowDistance;
+					colourOffset -= windowDistance;
+
 					audioPointer = audioView.begin() + audioView.cursorPosition() + audioOffset;
 
 					while (audioPointer < audioView.begin())
@@ -87,38 +107,23 @@
 					while (audioPointer >= audioView.end())
 						audioPointer -= audioView.size();
 
-					colourPointer = colourView.begin() + colourView.cursorPosition() + colourOffset;
-
-					while (colourPointer < colourView.begin())
-						colourPointer += colourView.size();
-
-					while (colourPointer >= colourView.end())
-						colourPointer -= colourView.size();
-
+					// the cursor is the position of the next sample
+					colours.seek(written + colourOffset);
 				}
 
 				inline void inc() noexcept
 				{
-					audioPointer++, colourPointer++;
+					audioPointer++;
 
 					if (audioPointer == audioView.end())
 						audioPointer -= audioView.size();
 
-					if (colourPointer == colourView.end())
-						colourPointer -= colourView.size();
-				}
-
-				inline std::pair<std::ptrdiff_t, std::ptrdiff_t> distance() const noexcept
-				{
-					return std::make_pair(
-						std::distance<AudioIt>(audioPointer, audioView.begin()),
-						std::distance<ColourIt>(colourPointer, colourView.begin())
-					);
+					colours.inc();
 				}
 
 				inline std::pair<AudioT, ColourT> evaluate() const noexcept
 				{
-					return { *audioPointer, *colourPointer };
+					return { *audioPointer, colours.evaluate() };
 				}
 
 				AudioT evaluateSample() const noexcept
@@ -128,7 +133,7 @@
 
 				ColourT evaluateColour() const noexcept
 				{
-					return *colourPointer;
+					return colours.evaluate();
 				}
 
 				AudioT evaluateSampleInc() noexcept
@@ -143,11 +148,8 @@
 
 				ColourT evaluateColourInc() noexcept
 				{
-					auto ret = *colourPointer++;
-
-					if (colourPointer == colourView.end())
-						colourPointer -= colourView.size();
-
+					auto ret = colours.evaluate();
+					colours.inc();
 					return ret;
 				}
 
@@ -156,10 +158,12 @@
 				juce::Colour defaultKey;
 
 				ChannelData::AudioBuffer::ProxyView audioView;
-				ChannelData::ColourBuffer::ProxyView colourView;
+				ChannelData::ColourTrack::Reader colours;
+				const ChannelData::LevelPyramid & levels;
+				const cpl::ssize_t windowDistance;
+				const std::int64_t written;
 
 				AudioIt audioPointer {};
-				ColourIt colourPointer {};
 			};
 
 		template<std::size_t ChannelIndex, std::size_t ColourIndex, typename BinaryFunction>
@@ -169,16 +173,32 @@
 
 				MidSideEvaluatorBase(ChannelData & data)
 					: DefaultKey(data, ColourIndex)
-					, audioViewLeft(data.front.channels.at(0).audioData.createProxyView())
-					, audioViewRight(data.front.channels.at(1).audioData.createProxyView())
-					, colourView(data.front.midSideColour[ChannelIndex].createProxyView())
+					, audioViewLeft(data.display.buffer->channels.at(0).audioData.createProxyView())
+					, audioViewRight(data.display.buffer->channels.at(1).audioData.createProxyView())
+					, colours(data.display.buffer->midSideColour[ChannelIndex], data.display.buffer->written)
+					, levels(data.display.buffer->midSideLevels[ChannelIndex])
+					, windowDistance(static_cast<cpl::ssize_t>(data.display.distance))
+					, written(static_cast<std::int64_t>(data.display.buffer->written))
 				{
 
 				}
 
+				const ChannelData::LevelPyramid & getLevels() const noexcept
+				{
+					return levels;
+				}
+
+				/// <summary>
+				/// The amount of samples the end of the displayed window is behind the newest sample.
+				/// </summary>
+				cpl::ssize_t getWindowDistance() const noexcept
+				{
+					return windowDistance;
+				}
+
 				inline bool isWellDefined() const noexcept
 				{
-					return audioViewLeft.size() > 0 && audioViewRight.size() > 0 && audioViewLeft.size() == audioViewRight.size() && colourView.size() > 0;
+					return audioViewLeft.size() > 0 && audioViewRight.size() > 0 && audioViewLeft.size() == audioViewRight.size() && colours.size() > 0;
 				}
 
 				void startFrom(cpl::ssize_t offset)
@@ -188,6 +208,10 @@
 
 				void startFrom(cpl::ssize_t audioOffset, cpl::ssize_t colourOffset)
 				{
+					// offsets are relative to the end of the displayed window
+					audioOffset -= windowDistance;
+					colourOffset -= windowDistance;
+
 					audioOffset += audioViewLeft.cursorPosition();
 					audioPointerLeft = audioViewLeft.begin() + audioOffset;
 					audioPointerRight = audioViewRight.begin() + audioOffset;
@@ -205,19 +229,13 @@
 						audioPointerRight -= audioViewLeft.size();
 					}
 
-					colourPointer = colourView.begin() + colourView.cursorPosition() + colourOffset;
-
-					while (colourPointer < colourView.begin())
-						colourPointer += colourView.size();
-
-					while (colourPointer >= colourView.end())
-						colourPointer -= colourView.size();
-
+					// the cursor is the position of the next sample
+					colours.seek(written + colourOffset);
 				}
 
 				inline void inc() noexcept
 				{
-					audioPointerLeft++, audioPointerRight++, colourPointer++;
+					audioPointerLeft++, audioPointerRight++;
 
 					if (audioPointerLeft == audioViewLeft.end())
 					{
@@ -225,16 +243,7 @@
 						audioPointerRight -= audioViewLeft.size();
 					}
 
-					if (colourPointer == colourView.end())
-						colourPointer -= colourView.size();
-				}
-
-				inline std::pair<std::ptrdiff_t, std::ptrdiff_t> distance() const noexcept
-				{
-					return std::make_pair(
-						std::distance<AudioIt>(audioPointerLeft, audioViewLeft.begin()),
-						std::distance<ColourIt>(colourPointer, colourView.begin())
-					);
+					colours.inc();
 				}
 
 				inline std::pair<AudioT, ColourT> evaluate() const noexcept
@@ -249,7 +258,7 @@
 
 				ColourT evaluateColour() const noexcept
 				{
-					return *colourPointer;
+					return colours.evaluate();
 				}
 
 				AudioT evaluateSampleInc() noexcept
@@ -269,21 +278,20 @@
 
 				ColourT evaluateColourInc() noexcept
 				{
-					auto ret = *colourPointer++;
-
-					if (colourPointer == colourView.end())
-						colourPointer -= colourView.size();
-
+					auto ret = colours.evaluate();
+					colours.inc();
 					return ret;
 				}
 
 			private:
 
 				ChannelData::AudioBuffer::ProxyView audioViewLeft, audioViewRight;
-				ChannelData::ColourBuffer::ProxyView colourView;
+				ChannelData::ColourTrack::Reader colours;
+				const ChannelData::LevelPyramid & levels;
+				const cpl::ssize_t windowDistance;
+				const std::int64_t written;
 
 				AudioIt audioPointerLeft {}, audioPointerRight {};
-				ColourIt colourPointer{};
 			};
 
 		template<>
@@ -33,7 +33,7 @@
 
 	#include "Signalizer.h"
 	#include "Oscilloscope.h"
-	#include <queue>
+	#include "TriggerQueue.h"
 
 	namespace Signalizer
 	{
@@ -48,10 +48,28 @@
 				triggerType = triggerMode;
 				windowChanged = std::ceil(newWindowSize) != std::ceil(windowSize);
 				windowSize = newWindowSize;
+				// triggers closer than this are shown in the same window anyway
+				peaks.setSpacing(static_cast<std::uint64_t>(std::ceil(windowSize) / 2));
 				hysteresis = newHysteresis;
 				threshold = valueThreshold;
 			}
 
+			/// <summary>
+			/// The amount of triggers lost because too many were pending.
+			/// </summary>
+			std::uint64_t getDroppedTriggers() const noexcept
+			{
+				return peaks.getDropped();
+			}
+
+			/// <summary>
+			/// The amount of triggers merged into a preceding trigger, being closer than half a window.
+			/// </summary>
+			std::uint64_t getCoalescedTriggers() const noexcept
+			{
+				return peaks.getCoalesced();
+			}
+
 			void update(std::uint64_t currentSteadyClock)
 			{
 				steadyClock = currentSteadyClock;
@@ -104,7 +122,7 @@
 
 				if (ceilingSize == 0 && peaks.size())
 				{
-					std::queue<std::uint64_t>().swap(peaks);
+					peaks.clear();
 				}
 
 				while (numSamples != 0)
@@ -193,7 +211,7 @@
 
 						auto cappedSize = std::min<std::size_t>(bufferedSamples, std::ceil(amount + 1));
 						// 1
-						o.channelData.swapBuffers(cappedSize, -(cpl::ssize_t)bufferedSamples);
+						o.channelData.publishBack(cappedSize, -(cpl::ssize_t)bufferedSamples, steadyClock);
 						// 2
 						bufferedSamples -= std::min<std::uint64_t>(bufferedSamples, cappedSize);
 						// 3
@@ -219,7 +237,7 @@
 			std::uint64_t currentPeak, bufferedSamples;
 			std::uint64_t frontOrigin;
 			std::uint64_t steadyClock;
-			std::queue<std::uint64_t> peaks;
+			TriggerQueue peaks;
 			bool isWorkingOnPeak;
 
 
@@ -260,7 +278,7 @@
 			const std::uint64_t steadyClock;
 			std::uint64_t crossOrigin;
 			PreprocessingTrigger & outsideState;
-			std::queue<std::uint64_t> & peaks;
+			TriggerQueue & peaks;
 			bool isPeakHolding;
 			const double threshold, hysteresis;
 			double state;
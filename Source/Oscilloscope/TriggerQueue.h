@@ -0,0 +1,131 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:TriggerQueue.h
+
+		Fixed capacity queue of trigger positions for the oscilloscope.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_TRIGGERQUEUE_H
+	#define SIGNALIZER_TRIGGERQUEUE_H
+
+	#include <array>
+	#include <atomic>
+	#include <cstdint>
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// A first-in first-out ring of trigger positions (in steady clock samples), that never allocates.
+		///
+		/// Overflow policy: Triggers closer than the spacing to the newest queued trigger are coalesced into it,
+		/// as they would show nearly the same window. If the ring is full anyway, the new trigger is dropped,
+		/// as the oldest may be the one currently being processed.
+		///
+		/// Counters are atomic, so they can be read from any thread.
+		/// </summary>
+		class TriggerQueue
+		{
+		public:
+
+			static const std::size_t capacity = 512;
+
+			/// <summary>
+			/// Sets the minimum distance between queued triggers, usually half a window.
+			/// </summary>
+			void setSpacing(std::uint64_t samples) noexcept
+			{
+				spacing = samples;
+			}
+
+			void push(std::uint64_t position) noexcept
+			{
+				if (count > 0 && position - back() < spacing)
+				{
+					coalesced.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+
+				if (count == capacity)
+				{
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+
+				events[(head + count) % capacity] = position;
+				count++;
+			}
+
+			std::uint64_t front() const noexcept
+			{
+				return events[head];
+			}
+
+			std::uint64_t back() const noexcept
+			{
+				return events[(head + count - 1) % capacity];
+			}
+
+			void pop() noexcept
+			{
+				head = (head + 1) % capacity;
+				count--;
+			}
+
+			std::size_t size() const noexcept
+			{
+				return count;
+			}
+
+			void clear() noexcept
+			{
+				head = count = 0;
+			}
+
+			/// <summary>
+			/// The total amount of triggers lost because the queue was full.
+			/// </summary>
+			std::uint64_t getDropped() const noexcept
+			{
+				return dropped.load(std::memory_order_relaxed);
+			}
+
+			/// <summary>
+			/// The total amount of triggers merged into a preceding trigger.
+			/// </summary>
+			std::uint64_t getCoalesced() const noexcept
+			{
+				return coalesced.load(std::memory_order_relaxed);
+			}
+
+		private:
+
+			std::array<std::uint64_t, capacity> events;
+			std::size_t head = 0, count = 0;
+			std::uint64_t spacing = 0;
+			std::atomic<std::uint64_t> dropped { 0 }, coalesced { 0 };
+		};
+	};
+
+#endif
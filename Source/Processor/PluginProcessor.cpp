@@ -52,7 +52,7 @@ namespace Signalizer
 		{
 			parameterMap.insert({
 				ParameterCreationList[i].first,
-				ParameterCreationList[i].second(parameterMap.numParams(), false, { stream, *this })
+				ParameterCreationList[i].second(parameterMap.numParams(), false, { stream, *this, blockTimeline })
 			});
 		}
 
@@ -119,6 +119,11 @@ namespace Signalizer
 		info.storeAudioHistory = true;
 
 		stream.initializeInfo(info);
+		// the steady clock of the stream restarts with it
+		blockTimeline.reset();
+
+		// the audio thread can't allocate its trace buffer
+		SIGNALIZER_TRACE_RESERVE();
 	}
 
 	void AudioProcessor::releaseResources()
@@ -127,6 +132,8 @@ namespace Signalizer
 
 	void AudioProcessor::processBlock(juce::AudioSampleBuffer& buffer, juce::MidiBuffer& midiMessages)
 	{
+		SIGNALIZER_TRACE_REALTIME_THREAD("Audio");
+		SIGNALIZER_TRACE_ZONE("AudioProcessor::processBlock");
 
 		if (nChannels != buffer.getNumChannels())
 		{
@@ -134,7 +141,7 @@ namespace Signalizer
 			CPL_BREAKIFDEBUGGED();
 		}
 		// stream will take it from here.
-
+		blockTimeline.stamp(static_cast<std::size_t>(buffer.getNumSamples()));
 
 		if(auto ph = getPlayHead())
 			stream.processIncomingRTAudio(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples(), *ph);
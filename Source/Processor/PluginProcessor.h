@@ -49,6 +49,8 @@
 			, ParameterSet::AutomatedProcessor
 		{
 			friend class MainEditor;
+			friend class OfflineAnalysis;
+			friend class BenchmarkHost;
 
 		public:
 
@@ -112,6 +114,10 @@
 			//==============================================================================
 			JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioProcessor)
 			Signalizer::AudioStream stream;
+			/// <summary>
+			/// Stamped with every block passed to the stream, for measuring the latency of the views.
+			/// </summary>
+			BlockTimeline blockTimeline;
 			int nChannels;
 			ParameterMap parameterMap;
 			DecoupledStateObject<MainEditor> dsoEditor;
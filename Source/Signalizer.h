@@ -4,5 +4,6 @@
 #include "version.h"
 #include "Common/CommonSignalizer.h"
 #include "Common/SharedBehaviour.h"
+#include "Common/Tracing.h"
 
 #endif
\ No newline at end of file
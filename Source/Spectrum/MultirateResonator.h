@@ -0,0 +1,455 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:MultirateResonator.h
+
+		A bank of complex resonators split into octave bands, where each band
+		runs at the lowest sample rate that still represents its frequencies.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_MULTIRATERESONATOR_H
+	#define SIGNALIZER_MULTIRATERESONATOR_H
+
+	#include <cpl/Common.h>
+	#include <cpl/dsp/CComplexResonator.h>
+	#include <cpl/simd.h>
+	#include "../Common/WorkerPool.h"
+	#include <algorithm>
+	#include <array>
+	#include <cmath>
+	#include <cstdint>
+	#include <vector>
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Decimates a signal by two, through a symmetric half-band FIR filter.
+		/// Every second coefficient of a half-band filter is zero, so only the odd taps are evaluated.
+		/// </summary>
+		template<typename T>
+		class HalfbandDecimator
+		{
+		public:
+
+			/// <summary>
+			/// The filter has 4 * oddTaps - 1 taps, and a delay of 2 * oddTaps - 1 input samples.
+			/// </summary>
+			static const std::size_t oddTaps = 6;
+			static const std::size_t halfLength = 2 * oddTaps - 1;
+
+			HalfbandDecimator()
+			{
+				const double pi = cpl::simd::consts<double>::pi;
+
+				for (std::size_t i = 0; i < oddTaps; ++i)
+				{
+					const double k = 2.0 * i + 1;
+					// blackman window, spanning the whole filter
+					const double x = 0.5 + k / (2 * (halfLength + 1));
+					const double window = 0.42 - 0.5 * std::cos(2 * pi * x) + 0.08 * std::cos(4 * pi * x);
+					coefficients[i] = static_cast<T>(std::sin(pi * k / 2) / (pi * k) * window);
+				}
+
+				reset();
+			}
+
+			void reset() noexcept
+			{
+				std::fill(history.begin(), history.end(), T(0));
+				phase = 0;
+			}
+
+			/// <summary>
+			/// Decimates numSamples of input into output, returning the number of output samples (numSamples / 2, +- 1).
+			/// Output must be able to hold numSamples / 2 + 1 samples.
+			/// Not real-time safe, if numSamples is larger than any previous call.
+			/// </summary>
+			std::size_t process(const T * input, std::size_t numSamples, T * output)
+			{
+				const std::size_t historySize = 2 * halfLength;
+				line.resize(historySize + numSamples);
+
+				std::copy(history.begin(), history.end(), line.begin());
+				std::copy(input, input + numSamples, line.begin() + historySize);
+
+				std::size_t produced = 0;
+
+				// the first output sample is the one with the right parity
+				for (std::size_t i = phase; i < numSamples; i += 2)
+				{
+					// centre of the filter, for the newest sample at historySize + i
+					const T * centre = line.data() + i + halfLength;
+					T sum = T(0.5) * centre[0];
+
+					for (std::size_t t = 0; t < oddTaps; ++t)
+					{
+						const std::size_t k = 2 * t + 1;
+						sum += coefficients[t] * (centre[k] + centre[-static_cast<std::ptrdiff_t>(k)]);
+					}
+
+					output[produced++] = sum;
+				}
+
+				phase = (phase + numSamples) & 1;
+				std::copy(line.end() - historySize, line.end(), history.begin());
+
+				return produced;
+			}
+
+		private:
+
+			std::array<T, oddTaps> coefficients;
+			std::array<T, 2 * halfLength> history;
+			std::vector<T> line;
+			std::size_t phase;
+		};
+
+		/// <summary>
+		/// Drop-in for cpl::dsp::CComplexResonator, splitting the filters into octave bands.
+		/// Band b runs at samplerate / 2^b, fed by a cascade of b half-band decimators, so the cost
+		/// of low frequency resonators is divided by their decimation.
+		///
+		/// The window size of each band is scaled likewise, so the time/frequency resolution of each
+		/// filter is unchanged. States are recombined into the original filter order.
+		///
+		/// Each band is further partitioned into contiguous ranges of filters, that are resonated
+		/// in parallel on a WorkerPool (see setConcurrency()). All partitions are joined before
+		/// the resonate functions return.
+		/// </summary>
+		template<typename T, std::size_t Channels>
+		class MultirateResonator : public cpl::CMutex::Lockable
+		{
+		public:
+
+			typedef cpl::dsp::CComplexResonator<T, Channels> Resonator;
+
+			static const std::size_t maxBands = 8;
+			static const std::size_t maxConcurrency = 8;
+
+			/// <summary>
+			/// Frequencies are assigned to the most decimated band, where they're below this fraction of the band's samplerate.
+			/// The half-band decimators are flat to about 0.2 of their input rate, so aliases of these are well attenuated.
+			/// </summary>
+			static constexpr double maxBandFrequency = 0.2;
+
+			/// <summary>
+			/// Bands aren't decimated below this window size, to keep the resonators' windows meaningful.
+			/// </summary>
+			static const std::size_t minBandWindow = 64;
+
+			/// <summary>
+			/// Bands are only partitioned further, as long as each partition has at least this many filters.
+			/// </summary>
+			static const std::size_t minPartitionFilters = 32;
+
+			MultirateResonator() : numBands(1), numFilters(0), windowSize(0), sampleRate(0), windowBandwidth(0) {}
+
+			template<typename Factor>
+			void setWindowSize(Factor factor, std::size_t size)
+			{
+				cpl::CMutex lock(*this);
+				windowSize = size;
+
+				for (std::size_t p = 0; p < partitions.size(); ++p)
+					partitions[p].resonator.setWindowSize(factor, std::max<std::size_t>(1, size >> (p / maxConcurrency)));
+			}
+
+			void setFreeQ(bool toggle)
+			{
+				for (auto & partition : partitions)
+					partition.resonator.setFreeQ(toggle);
+			}
+
+			/// <summary>
+			/// Sets the amount of threads resonating partitions of the filters, where 1 resonates everything on the calling thread.
+			/// Starts and stops threads, and remaps the filters - don't call this from any real-time thread.
+			/// </summary>
+			void setConcurrency(std::size_t concurrency)
+			{
+				cpl::CMutex lock(*this);
+
+				concurrency = std::max<std::size_t>(1, std::min(concurrency, maxConcurrency));
+
+				if (concurrency == workers.getConcurrency())
+					return;
+
+				workers.setConcurrency(concurrency);
+
+				if (numFilters)
+					distribute();
+			}
+
+			std::size_t getConcurrency() const noexcept
+			{
+				return workers.getConcurrency();
+			}
+
+			/// <summary>
+			/// Maps the filters to the frequencies in Hz, distributing them to the bands.
+			/// Frequencies above the nyquist frequency are negative frequencies (for complex input).
+			/// </summary>
+			template<class Vector>
+			void mapSystemHz(const Vector & frequencies, std::size_t size, double newWindowBandwidth, double newSampleRate)
+			{
+				cpl::CMutex lock(*this);
+
+				numFilters = size;
+				sampleRate = newSampleRate;
+				windowBandwidth = newWindowBandwidth;
+				mappedFrequencies.assign(&frequencies[0], &frequencies[0] + size);
+
+				distribute();
+			}
+
+			void resetState()
+			{
+				cpl::CMutex lock(*this);
+
+				for (auto & partition : partitions)
+					partition.resonator.resetState();
+
+				for (auto & band : bands)
+				{
+					for (auto & decimator : band.decimators)
+						decimator.reset();
+				}
+			}
+
+			std::size_t getNumFilters() const noexcept
+			{
+				return numFilters;
+			}
+
+			template<typename V>
+			void resonateReal(T ** buffers, std::size_t numChannels, std::size_t numSamples)
+			{
+				resonate(buffers, numChannels, numSamples,
+					[=](Resonator & resonator, T ** data, std::size_t samples) { resonator.template resonateReal<V>(data, numChannels, samples); }
+				);
+			}
+
+			template<typename V>
+			void resonateComplex(T ** buffers, std::size_t numSamples)
+			{
+				// the real and imaginary parts are decimated separately
+				resonate(buffers, 2, numSamples,
+					[](Resonator & resonator, T ** data, std::size_t samples) { resonator.template resonateComplex<V>(data, samples); }
+				);
+			}
+
+			/// <summary>
+			/// Equivalent to CComplexResonator::getWholeWindowedState, with the states of all bands in the original order.
+			/// </summary>
+			template<typename V, typename Window>
+			void getWholeWindowedState(Window window, T * output, std::size_t numChannels, std::size_t size)
+			{
+				cpl::CMutex lock(*this);
+
+				const std::size_t filters = std::min(size, numFilters);
+
+				for (auto p : activePartitions)
+				{
+					auto & partition = partitions[p];
+					const std::size_t partitionFilters = partition.indices.size();
+
+					partition.resonator.template getWholeWindowedState<V>(window, partitionState.data(), numChannels, partitionFilters);
+
+					// channels are stored after each other, as complex pairs
+					for (std::size_t c = 0; c < numChannels; ++c)
+					{
+						const T * source = partitionState.data() + c * partitionFilters * 2;
+						T * destination = output + c * filters * 2;
+
+						for (std::size_t i = 0; i < partitionFilters; ++i)
+						{
+							const auto index = partition.indices[i];
+							if (index >= filters)
+								continue;
+
+							destination[index * 2] = source[i * 2];
+							destination[index * 2 + 1] = source[i * 2 + 1];
+						}
+					}
+				}
+			}
+
+		private:
+
+			/// <summary>
+			/// Assigns the mapped frequencies to bands, and the bands' filters to contiguous partitions.
+			/// </summary>
+			void distribute()
+			{
+				for (auto & band : bands)
+				{
+					band.frequencies.clear();
+					band.indices.clear();
+					// bands may become active again
+					for (auto & decimator : band.decimators)
+						decimator.reset();
+				}
+
+				// deepest band, that still has a large enough window
+				std::size_t deepest = 0;
+				while (deepest + 1 < maxBands && (windowSize >> (deepest + 1)) >= minBandWindow)
+					deepest++;
+
+				numBands = 1;
+
+				for (std::size_t i = 0; i < numFilters; ++i)
+				{
+					const double hz = mappedFrequencies[i];
+					const double magnitude = hz > sampleRate * 0.5 ? sampleRate - hz : hz;
+
+					std::size_t b = 0;
+					while (b < deepest && std::abs(magnitude) < maxBandFrequency * (sampleRate / (std::size_t(2) << b)))
+						b++;
+
+					// negative frequencies wrap around the band's sample rate
+					const double bandRate = sampleRate / (std::size_t(1) << b);
+					const double bandHz = hz > sampleRate * 0.5 ? hz - sampleRate + bandRate : hz;
+
+					bands[b].frequencies.push_back(static_cast<T>(bandHz));
+					bands[b].indices.push_back(static_cast<std::uint32_t>(i));
+					numBands = std::max(numBands, b + 1);
+				}
+
+				activePartitions.clear();
+				std::size_t largestPartition = 0;
+				const std::size_t concurrency = workers.getConcurrency();
+
+				for (std::size_t b = 0; b < numBands; ++b)
+				{
+					auto & band = bands[b];
+					const std::size_t bandFilters = band.indices.size();
+
+					if (!bandFilters)
+						continue;
+
+					const std::size_t numPartitions = std::max<std::size_t>(1, std::min(concurrency, bandFilters / minPartitionFilters));
+					const std::size_t perPartition = (bandFilters + numPartitions - 1) / numPartitions;
+
+					for (std::size_t n = 0; n < numPartitions; ++n)
+					{
+						const std::size_t begin = n * perPartition;
+						const std::size_t end = std::min(bandFilters, begin + perPartition);
+
+						if (begin >= end)
+							break;
+
+						const std::size_t p = b * maxConcurrency + n;
+						auto & partition = partitions[p];
+
+						partition.band = b;
+						partition.indices.assign(band.indices.begin() + begin, band.indices.begin() + end);
+						partition.frequencies.assign(band.frequencies.begin() + begin, band.frequencies.begin() + end);
+						partition.resonator.mapSystemHz(partition.frequencies, partition.frequencies.size(), windowBandwidth, sampleRate / (std::size_t(1) << b));
+
+						activePartitions.push_back(p);
+						largestPartition = std::max(largestPartition, end - begin);
+					}
+				}
+
+				partitionState.resize(largestPartition * 2 * Channels);
+			}
+
+			template<class ResonateFunction>
+			void resonate(T ** buffers, std::size_t numChannels, std::size_t numSamples, ResonateFunction resonatePartition)
+			{
+				cpl::CMutex lock(*this);
+
+				if (numChannels > Channels)
+					return;
+
+				// produce the decimated signals of every band first, so all partitions can run independently.
+				T * signals[maxBands][Channels];
+				std::size_t lengths[maxBands];
+
+				for (std::size_t c = 0; c < numChannels; ++c)
+					signals[0][c] = buffers[c];
+
+				lengths[0] = numSamples;
+
+				for (std::size_t b = 1; b < numBands; ++b)
+				{
+					auto & band = bands[b];
+					std::size_t produced = 0;
+
+					for (std::size_t c = 0; c < numChannels; ++c)
+					{
+						band.signal[c].resize(lengths[b - 1] / 2 + 1);
+						produced = band.decimators[c].process(signals[b - 1][c], lengths[b - 1], band.signal[c].data());
+						signals[b][c] = band.signal[c].data();
+					}
+
+					lengths[b] = produced;
+				}
+
+				auto job = [&](std::size_t i)
+				{
+					auto & partition = partitions[activePartitions[i]];
+					const auto b = partition.band;
+
+					if (lengths[b])
+						resonatePartition(partition.resonator, signals[b], lengths[b]);
+				};
+
+				workers.parallelFor(activePartitions.size(), job);
+			}
+
+			struct Band
+			{
+				std::vector<T> frequencies;
+				/// <summary>
+				/// The index of each filter of this band, in the whole bank.
+				/// </summary>
+				std::vector<std::uint32_t> indices;
+				/// <summary>
+				/// The decimators producing this band's signal from the previous band's.
+				/// </summary>
+				std::array<HalfbandDecimator<T>, Channels> decimators;
+				std::array<std::vector<T>, Channels> signal;
+			};
+
+			/// <summary>
+			/// A contiguous range of filters of a band. Partition p belongs to band p / maxConcurrency.
+			/// </summary>
+			struct Partition
+			{
+				Resonator resonator;
+				std::vector<T> frequencies;
+				std::vector<std::uint32_t> indices;
+				std::size_t band = 0;
+			};
+
+			std::array<Band, maxBands> bands;
+			std::array<Partition, maxBands * maxConcurrency> partitions;
+			std::vector<std::size_t> activePartitions;
+			std::vector<T> partitionState, mappedFrequencies;
+			WorkerPool workers;
+			std::size_t numBands, numFilters, windowSize;
+			double sampleRate, windowBandwidth;
+		};
+	};
+#endif
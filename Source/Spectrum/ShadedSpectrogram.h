@@ -0,0 +1,302 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:ShadedSpectrogram.h
+
+		A circular spectrogram storing levels in a half float texture, coloured
+		through a gradient by a fragment shader.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_SHADEDSPECTROGRAM_H
+	#define SIGNALIZER_SHADEDSPECTROGRAM_H
+
+	#include <cpl/Common.h>
+	#include "../Common/ColumnUploadBuffer.h"
+	#include <cstdint>
+	#include <cstring>
+	#include <memory>
+	#include <vector>
+
+	#ifndef GL_RED
+		#define GL_RED 0x1903
+	#endif
+	#ifndef GL_R16F
+		#define GL_R16F 0x822D
+	#endif
+	#ifndef GL_HALF_FLOAT
+		#define GL_HALF_FLOAT 0x140B
+	#endif
+	#ifndef GL_TEXTURE0
+		#define GL_TEXTURE0 0x84C0
+	#endif
+	#ifndef GL_TEXTURE1
+		#define GL_TEXTURE1 0x84C1
+	#endif
+	#ifndef GL_CLAMP_TO_EDGE
+		#define GL_CLAMP_TO_EDGE 0x812F
+	#endif
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Colour spectrum image, where each pixel is the level in decibels.
+		/// Levels are mapped to the dynamic range and coloured through a gradient when drawn,
+		/// so changes to these apply to the whole history.
+		/// All functions except resize(), clear(), addColumn() and setGradient() must be called with the OpenGL context active.
+		/// </summary>
+		class ShadedSpectrogram
+		{
+		public:
+
+			typedef cpl::GraphicsND::UPixel<cpl::GraphicsND::ComponentOrder::OpenGL> Pixel;
+
+			/// <summary>
+			/// The level of pixels without any content.
+			/// </summary>
+			static constexpr float silence = -1000.0f;
+
+			/// <summary>
+			/// Resizes and clears the image.
+			/// </summary>
+			void resize(std::size_t newWidth, std::size_t newHeight)
+			{
+				columns.resize(newWidth, newHeight);
+				halfColumn.resize(newHeight);
+				textureIsAllocated = false;
+				clear();
+			}
+
+			std::size_t getWidth() const noexcept { return columns.getWidth(); }
+			std::size_t getHeight() const noexcept { return columns.getHeight(); }
+
+			void clear()
+			{
+				columns.fill(toHalf(silence));
+			}
+
+			/// <summary>
+			/// Sets a column to the levels (of getHeight() size) in decibels.
+			/// </summary>
+			void addColumn(std::size_t column, const float * levels)
+			{
+				for (std::size_t i = 0; i < halfColumn.size(); ++i)
+					halfColumn[i] = toHalf(levels[i]);
+
+				columns.addColumn(column, halfColumn.data());
+			}
+
+			/// <summary>
+			/// Sets the colour gradient, evenly sampled from the lowest to the highest level.
+			/// </summary>
+			void setGradient(const Pixel * colours, std::size_t size)
+			{
+				if (gradient.size() == size && std::memcmp(gradient.data(), colours, size * sizeof(Pixel)) == 0)
+					return;
+
+				gradient.assign(colours, colours + size);
+				gradientChanged = true;
+			}
+
+			/// <summary>
+			/// Uploads pending changes, and draws the image over the viewport. The column at offset is drawn leftmost.
+			/// </summary>
+			void render(juce::OpenGLContext & context, std::size_t offset, float lowDbs, float highDbs)
+			{
+				auto const width = getWidth(), height = getHeight();
+
+				if (!width || !height || gradient.empty())
+					return;
+
+				if (!program && !createProgram(context))
+					return;
+
+				auto & gl = context.extensions;
+
+				if (!levelTexture)
+				{
+					glGenTextures(1, &levelTexture);
+					glGenTextures(1, &gradientTexture);
+					textureIsAllocated = false;
+					gradientChanged = true;
+				}
+
+				gl.glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D, gradientTexture);
+
+				if (gradientChanged)
+				{
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+					glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(gradient.size()), 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, gradient.data());
+					gradientChanged = false;
+				}
+
+				gl.glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, levelTexture);
+
+				if (!textureIsAllocated)
+				{
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+					// horizontally repeated, so the circular offset can wrap around
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+					glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, GL_RED, GL_HALF_FLOAT, nullptr);
+					// the staged image is the complete history, so upload all of it
+					columns.invalidate();
+					textureIsAllocated = true;
+				}
+
+				columns.upload(context, GL_RED, GL_HALF_FLOAT);
+
+				// a degenerate range would divide by zero
+				auto range = highDbs - lowDbs;
+				if (range == 0)
+					range = 1e-3f;
+
+				program->use();
+				levels->set(0);
+				colours->set(1);
+				offsetUniform->set(static_cast<GLfloat>(double(offset) / width));
+				lowUniform->set(lowDbs);
+				rangeRecipUniform->set(1.0f / range);
+
+				glBegin(GL_QUADS);
+				glVertex2f(-1.0f, -1.0f);
+				glVertex2f(1.0f, -1.0f);
+				glVertex2f(1.0f, 1.0f);
+				glVertex2f(-1.0f, 1.0f);
+				glEnd();
+
+				gl.glUseProgram(0);
+				glBindTexture(GL_TEXTURE_2D, 0);
+				gl.glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D, 0);
+				gl.glActiveTexture(GL_TEXTURE0);
+			}
+
+			/// <summary>
+			/// Releases all OpenGL objects. Call before the context is destroyed.
+			/// </summary>
+			void release(juce::OpenGLContext & context)
+			{
+				columns.release(context);
+
+				// uniforms refer to the program
+				for (auto uniform : { &levels, &colours, &offsetUniform, &lowUniform, &rangeRecipUniform })
+					uniform->reset();
+
+				program = nullptr;
+
+				if (levelTexture)
+				{
+					glDeleteTextures(1, &levelTexture);
+					glDeleteTextures(1, &gradientTexture);
+					levelTexture = gradientTexture = 0;
+				}
+
+				textureIsAllocated = false;
+				gradientChanged = true;
+			}
+
+			/// <summary>
+			/// Converts a float to IEEE-754 binary16, rounded to nearest. Denormals are flushed to zero.
+			/// </summary>
+			static std::uint16_t toHalf(float value) noexcept
+			{
+				std::uint32_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+
+				const std::uint32_t sign = (bits >> 16) & 0x8000;
+				const std::int32_t exponent = static_cast<std::int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+				const std::uint32_t mantissa = bits & 0x7FFFFF;
+
+				if (exponent <= 0)
+					return static_cast<std::uint16_t>(sign);
+				if (exponent >= 31)
+					return static_cast<std::uint16_t>(sign | 0x7C00);
+
+				// a rounding carry out of the mantissa correctly increments the exponent
+				return static_cast<std::uint16_t>(sign | ((static_cast<std::uint32_t>(exponent) << 10) + ((mantissa + 0x1000) >> 13)));
+			}
+
+		private:
+
+			bool createProgram(juce::OpenGLContext & context)
+			{
+				static const char * vertexShader =
+					"varying vec2 position;\n"
+					"void main()\n"
+					"{\n"
+					"	position = gl_Vertex.xy * 0.5 + 0.5;\n"
+					"	gl_Position = vec4(gl_Vertex.xy, 0.0, 1.0);\n"
+					"}\n";
+
+				static const char * fragmentShader =
+					"uniform sampler2D levels;\n"
+					"uniform sampler2D colours;\n"
+					"uniform float offset;\n"
+					"uniform float lowDbs;\n"
+					"uniform float rangeRecip;\n"
+					"varying vec2 position;\n"
+					"void main()\n"
+					"{\n"
+					"	float level = texture2D(levels, vec2(position.x + offset, position.y)).r;\n"
+					"	float intensity = clamp((level - lowDbs) * rangeRecip, 0.0, 1.0);\n"
+					"	gl_FragColor = texture2D(colours, vec2(intensity, 0.5));\n"
+					"}\n";
+
+				std::unique_ptr<juce::OpenGLShaderProgram> newProgram(new juce::OpenGLShaderProgram(context));
+
+				if (!newProgram->addVertexShader(vertexShader) || !newProgram->addFragmentShader(fragmentShader) || !newProgram->link())
+				{
+					CPL_BREAKIFDEBUGGED();
+					return false;
+				}
+
+				program = std::move(newProgram);
+				levels.reset(new juce::OpenGLShaderProgram::Uniform(*program, "levels"));
+				colours.reset(new juce::OpenGLShaderProgram::Uniform(*program, "colours"));
+				offsetUniform.reset(new juce::OpenGLShaderProgram::Uniform(*program, "offset"));
+				lowUniform.reset(new juce::OpenGLShaderProgram::Uniform(*program, "lowDbs"));
+				rangeRecipUniform.reset(new juce::OpenGLShaderProgram::Uniform(*program, "rangeRecip"));
+
+				return true;
+			}
+
+			typedef std::unique_ptr<juce::OpenGLShaderProgram::Uniform> UniformPtr;
+
+			ColumnUploadBuffer<std::uint16_t> columns;
+			std::vector<std::uint16_t> halfColumn;
+			std::vector<Pixel> gradient;
+			std::unique_ptr<juce::OpenGLShaderProgram> program;
+			UniformPtr levels, colours, offsetUniform, lowUniform, rangeRecipUniform;
+			GLuint levelTexture = 0, gradientTexture = 0;
+			bool textureIsAllocated = false, gradientChanged = true;
+		};
+	};
+#endif
@@ -45,13 +45,15 @@ namespace Signalizer
 		, audioStream(stream)
 		, processorSpeed(0)
 		, lastFrameTick(0)
+		, latency({ "Spectrum latency (ms)", "Spectrum latency p50 (ms)", "Spectrum latency p99 (ms)" })
+		, drawnClock(0)
 		, lastMousePos()
 		, state()
 		, framePixelPosition()
 		, frequencyGraph({ 0, 1 }, { 0, 1 }, 1, 10)
 		, complexFrequencyGraph({ 0, 1 }, { 0, 1 }, 1, 10)
 		, flags()
-		, droppedAudioFrames()
+		, deferredFallbacks(0)
 		, audioThreadUsage()
 		, relayWidth()
 		, relayHeight()
@@ -62,6 +64,7 @@ namespace Signalizer
 		, framesPerUpdate()
 		, laggedFPS()
 		, isMouseInside(false)
+		, audioResource("audioResource", "Spectrum::audioResource wait")
 	{
 		setOpaque(true);
 		if (!(content = dynamic_cast<SpectrumContent *>(processorState)))
@@ -77,6 +80,8 @@ namespace Signalizer
 
 		state.viewRect = { 0.0, 1.0 }; // default full-view
 		state.sampleRate = 0;
+		state.precision = SpectrumContent::TransformPrecision::Double;
+		state.colourMapping = SpectrumContent::ColourMapping::Processor;
 		state.newWindowSize.store(cpl::Math::round<std::size_t>(content->windowSize.getTransformedValue()), std::memory_order_release);
 
 		oldViewRect = state.viewRect;
@@ -118,10 +123,6 @@ namespace Signalizer
 	{
 		content->getParameterSet().removeRTListener(this, true);
 		detachFromSource();
-#pragma message cwarn("Fix this as well.")
-		SFrameBuffer::FrameVector * frame;
-		while (sfbuf.frameQueue.popElement(frame))
-			delete frame;
 
 		notifyDestruction();
 	}
@@ -408,7 +409,7 @@ namespace Signalizer
 
 	void Spectrum::handleFlagUpdates()
 	{
-		cpl::CMutex audioLock;
+		MeasuredMutex audioLock(LockStatistics::Owner::Rendering);
 		if (flags.internalFlagHandlerRunning)
 			CPL_RUNTIME_EXCEPTION("Function is NOT reentrant!");
 
@@ -442,7 +443,7 @@ namespace Signalizer
 		{
 			state.colourOne[i] = content->lines[i].colourOne.getAsJuceColour();
 			state.colourTwo[i] = content->lines[i].colourTwo.getAsJuceColour();
-			lineGraphs[i].filter.setDecayAsFraction(content->lines[i].decay.getTransformedValue(), 0.1);
+			lineGraphs[i].decay.store(content->lines[i].decay.getTransformedValue(), std::memory_order_relaxed);
 		}
 
 		if (state.algo.load(std::memory_order_relaxed) != SpectrumContent::TransformAlgorithm::FFT)
@@ -458,6 +459,7 @@ namespace Signalizer
 		}
 
 
+		state.colourMapping = content->colourMapping.param.getAsTEnum<SpectrumContent::ColourMapping>();
 		state.primitiveSize = content->primitiveSize.getTransformedValue();
 		state.alphaFloodFill = content->floodFillAlpha.getTransformedValue();
 
@@ -473,6 +475,25 @@ namespace Signalizer
 			flags.viewChanged = true;
 		}
 
+		auto newPrecision = content->precision.param.getAsTEnum<SpectrumContent::TransformPrecision>();
+
+		if (newPrecision != state.precision)
+		{
+			// changes the layout of the audio memory
+			audioLock.acquire(audioResource);
+			state.precision = newPrecision;
+			flags.resetStateBuffers = true;
+		}
+
+		const auto resonatorConcurrency = std::size_t(1) << static_cast<std::size_t>(content->resonatorThreads.param.getTransformedValue());
+
+		if (resonatorConcurrency != cresonator.getConcurrency())
+		{
+			// starts/stops threads and remaps the resonators, so audio processing must be halted.
+			audioLock.acquire(audioResource);
+			cresonator.setConcurrency(resonatorConcurrency);
+		}
+
 		if (flags.audioStreamChanged.cas())
 		{
 			audioLock.acquire(audioResource);
@@ -543,6 +564,16 @@ namespace Signalizer
 			// separating real and imaginary transforms)
 			audioMemory.resize((bufSize + 1) * sizeof(std::complex<double>));
 			windowKernel.resize(bufSize);
+			singleWindowKernel.resize(bufSize);
+			singleFFT.setMaxSize(bufSize);
+
+			// e^(-i * 2 * pi * k / N) for k = 0 ... N / 4
+			realTransformTwiddles.resize(bufSize / 4 + 1);
+			for (std::size_t k = 0; k < realTransformTwiddles.size(); ++k)
+			{
+				realTransformTwiddles[k] = std::polar<fftType>(1, -cpl::simd::consts<fftType>::tau * k / bufSize);
+			}
+
 			flags.windowKernelChange = true;
 		}
 
@@ -561,8 +592,22 @@ namespace Signalizer
 				lineGraphs[i].resize(numFilters); lineGraphs[i].zero();
 			}
 
-			slopeMap.resize(numFilters);
+			lineGraphExchange.forEach(
+				[&](LineGraphResults & results)
+				{
+					for (auto & line : results)
+						line.assign(numFilters, UComplex());
+					results.tracker = TrackedPeak();
+				}
+			);
+
+			slopeMap.resize(paddedFilterSize(numFilters));
+			primaryMagnitudes.resize(paddedFilterSize(numFilters));
+			secondaryMagnitudes.resize(paddedFilterSize(numFilters));
 			workingMemory.resize(numFilters * 2 * sizeof(std::complex<double>));
+			frameInterpolationSpace.resize(numFilters);
+			// the rendering thread is the consumer, and the producer is halted through the audio lock.
+			sfbuf.resizePool(numFilters);
 
 			columnUpdate.resize(getHeight());
 			// avoid doing it twice.
@@ -626,8 +671,12 @@ namespace Signalizer
 			remapFrequencies = true;
 			flags.frequencyGraphChange = true;
 
-			if(state.displayMode == SpectrumContent::DisplayMode::ColourSpectrum && oldViewRect != state.viewRect)
+			if (state.displayMode == SpectrumContent::DisplayMode::ColourSpectrum && oldViewRect != state.viewRect)
+			{
 				oglImage.freeLinearVerticalTranslation(oldViewRect, state.viewRect);
+				// the history of the shaded spectrogram can't be translated
+				shadedSpectrogram.clear();
+			}
 
 			oldViewRect = state.viewRect;
 
@@ -699,6 +748,16 @@ namespace Signalizer
 			}
 			remapResonator = true;
 			flags.slopeMapChanged = true;
+			flags.binMappingChanged = true;
+		}
+
+		if (state.binPolation != binMapping.interpolation || getFFTSpace<std::complex<double>>() != binMapping.fftSize)
+			flags.binMappingChanged = true;
+
+		if (flags.binMappingChanged.cas())
+		{
+			audioLock.acquire(audioResource);
+			rebuildBinMapping();
 		}
 
 		if (flags.slopeMapChanged.cas())
@@ -713,7 +772,9 @@ namespace Signalizer
 
 		if (flags.windowKernelChange.cas())
 		{
+			audioLock.acquire(audioResource);
 			windowScale = content->dspWin.generateWindow<fftType>(windowKernel, getWindowSize());
+			singleWindowKernel.assign(windowKernel.begin(), windowKernel.end());
 			remapResonator = true;
 		}
 
@@ -744,6 +805,14 @@ namespace Signalizer
 			cresonator.resetState();
 			for (std::size_t i = 0; i < SpectrumContent::LineGraphs::LineEnd; ++i)
 				lineGraphs[i].zero();
+			lineGraphExchange.forEach(
+				[](LineGraphResults & results)
+				{
+					for (auto & line : results)
+						std::fill(line.begin(), line.end(), UComplex());
+					results.tracker = TrackedPeak();
+				}
+			);
 			std::memset(audioMemory.data(), 0, audioMemory.size() /* * sizeof(char) */);
 			std::memset(workingMemory.data(), 0, workingMemory.size() /* * sizeof(char) */);
 		}
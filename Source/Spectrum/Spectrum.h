@@ -43,7 +43,13 @@
 	#include <cpl/lib/LockFreeQueue.h>
 	#include <cpl/lib/BlockingLockFreeQueue.h>
 	#include <vector>
+	#include <cstdint>
 	#include "SpectrumParameters.h"
+	#include "../Common/SingleFFT.h"
+	#include "../Common/ColumnUploadBuffer.h"
+	#include "../Common/Contention.h"
+	#include "ShadedSpectrogram.h"
+	#include "MultirateResonator.h"
 	#include <cpl/dsp/SmoothedParameterState.h>
 
 	namespace cpl
@@ -58,6 +64,7 @@
 
 	namespace Signalizer
 	{
+		class Benchmark;
 
 		class Spectrum final
 		:
@@ -65,6 +72,7 @@
 			protected AudioStream::Listener,
 			private ParameterSet::RTListener
 		{
+			friend class OfflineAnalysis;
 
 		public:
 
@@ -72,22 +80,135 @@
 			typedef AudioStream::DataType fpoint;
 			typedef double fftType;
 
+			/// <summary>
+			/// A peak of the raw transform, found by the async audio thread for the frequency tracker.
+			/// </summary>
+			struct TrackedPeak
+			{
+				/// <summary>
+				/// The interpolated position of the peak, as a fraction of the nyquist frequency.
+				/// </summary>
+				double fraction = 0;
+				/// <summary>
+				/// The interpolated magnitude of the peak, without any slope applied.
+				/// </summary>
+				double dBs = 0;
+				/// <summary>
+				/// Whether the transform was searched at all.
+				/// </summary>
+				bool found = false;
+			};
+
 			class SFrameBuffer
 			{
 			public:
 
 				typedef cpl::aligned_vector < UComplex, 32 > FrameVector;
 
+				/// <summary>
+				/// The maximum amount of frames that can be in flight between the audio and the rendering thread.
+				/// </summary>
+				static const std::size_t poolDepth = 256;
+
 				SFrameBuffer()
-					: sampleBufferSize(), sampleCounter(), currentCounter(), frameQueue(10, 1000)
+					: sampleBufferSize(), sampleCounter(), currentCounter(), droppedFrames(), maxQueueDepth()
+					, frameQueue(poolDepth, poolDepth), freeFrames(poolDepth, poolDepth)
+				{
+
+				}
+
+				/// <summary>
+				/// Reallocates every frame in the pool to hold frameSize elements, and returns all frames to the free list.
+				/// Any frames in transit are discarded.
+				/// Not thread safe: Both the producer and consumer must be halted.
+				/// </summary>
+				void resizePool(std::size_t frameSize)
 				{
+					FrameVector * frame;
+					while (frameQueue.popElement(frame));
+					while (freeFrames.popElement(frame));
+
+					framePool.resize(poolDepth);
+					frameClocks.resize(poolDepth);
 
+					for (auto & f : framePool)
+					{
+						f.resize(frameSize);
+						freeFrames.pushElement<true>(&f);
+					}
 				}
+
+				/// <summary>
+				/// Returns a free frame from the pool, or nullptr if all frames are in transit.
+				/// The returned frame must be handed back through either pushFrame or releaseFrame.
+				/// Safe to call from the producer.
+				/// </summary>
+				FrameVector * acquireFrame() noexcept
+				{
+					FrameVector * frame;
+					if (freeFrames.popElement(frame))
+						return frame;
+
+					droppedFrames.fetch_add(1, std::memory_order_relaxed);
+					return nullptr;
+				}
+
+				/// <summary>
+				/// Queues the frame for the consumer, along with the steady clock of the stream after the newest sample
+				/// in the frame. Safe to call from the producer.
+				/// </summary>
+				void pushFrame(FrameVector * frame, std::uint64_t clock)
+				{
+					frameClocks[frame - framePool.data()] = clock;
+					frameQueue.pushElement<true>(frame);
+
+					// sampled by the producer, so the depth is seen right before the consumer drains the queue
+					const auto depth = frameQueue.enqueuededElements();
+
+					if (depth > maxQueueDepth.load(std::memory_order_relaxed))
+						maxQueueDepth.store(depth, std::memory_order_relaxed);
+
+					SIGNALIZER_TRACE_COUNTER("Spectrum frame queue depth", static_cast<double>(depth));
+				}
+
+				/// <summary>
+				/// The clock the frame was pushed with. Safe to call from the consumer, for frames it popped.
+				/// </summary>
+				std::uint64_t getClock(const FrameVector * frame) const noexcept
+				{
+					return frameClocks[frame - framePool.data()];
+				}
+
+				/// <summary>
+				/// Returns a frame to the pool. Safe to call from the consumer.
+				/// </summary>
+				void releaseFrame(FrameVector * frame)
+				{
+					freeFrames.pushElement<true>(frame);
+				}
+
 				std::size_t sampleBufferSize;
 				std::size_t currentCounter;
 				std::uint64_t sampleCounter;
+				/// <summary>
+				/// Amount of frames the producer had to discard because the pool was exhausted.
+				/// </summary>
+				std::atomic<std::uint64_t> droppedFrames;
+				/// <summary>
+				/// The most frames queued at once.
+				/// </summary>
+				std::atomic<std::size_t> maxQueueDepth;
 
 				cpl::CLockFreeQueue<FrameVector *> frameQueue;
+
+			private:
+
+				cpl::CLockFreeQueue<FrameVector *> freeFrames;
+				std::vector<FrameVector> framePool;
+				/// <summary>
+				/// The clock of each frame in the pool, handed over by the queue along with the frame.
+				/// </summary>
+				std::vector<std::uint64_t> frameClocks;
 			};
 
 
@@ -143,6 +264,33 @@
 			std::size_t getWindowSize() const noexcept;
 			void setWindowSize(std::size_t size);
 
+			/// <summary>
+			/// Counters for attributing stutter to contention between the audio and rendering threads.
+			/// </summary>
+			struct Statistics
+			{
+				LockStatistics::Snapshot audioResource[static_cast<std::size_t>(LockStatistics::Owner::End)];
+				/// <summary>
+				/// Transforms made of the audio history alone, because the stream had deferred samples.
+				/// </summary>
+				std::uint64_t deferredFallbacks;
+				std::uint64_t droppedAudioFrames;
+				std::size_t queueDepth, maxQueueDepth;
+			};
+
+			/// <summary>
+			/// Safe to call from any thread.
+			/// </summary>
+			Statistics getStatistics() const noexcept;
+
+#ifdef SIGNALIZER_BENCHMARKS
+			/// <summary>
+			/// Times the DSP kernels of the view in each of their variants, see Benchmark.h.
+			/// Only part of the benchmark target.
+			/// </summary>
+			void runBenchmarks(Benchmark & suite);
+#endif
+
 		protected:
 
 			struct RenderingDispatcher
@@ -150,6 +298,11 @@
 				template<typename ISA> static void dispatch(Spectrum & c) { c.vectorGLRendering<ISA>(); }
 			};
 
+			struct FrameDispatcher
+			{
+				template<typename ISA> static void dispatch(Spectrum & c, bool & processed) { processed = c.processNextSpectrumFrame<ISA>(); }
+			};
+
 			struct AudioDispatcher
 			{
 				template<typename ISA> static void dispatch(Spectrum & c, AFloat ** buffer, std::size_t numChannels, std::size_t numSamples)
@@ -186,14 +339,15 @@
 			/// Runs the transform (of any kind) results through potential post filters and other features, before displaying it.
 			/// The transform will be rendered into filterResults after this.
 			/// </summary>
-			template<class InVector>
+			template<typename ISA, class InVector>
 				void postProcessTransform(const InVector & transform, std::size_t size);
 
 			/// <summary>
 			/// Post processes the transform that will be interpreted according to what's selected.
 			/// Needs exclusive access to audioResource.
 			/// </summary>
-			void postProcessStdTransform();
+			template<typename ISA>
+				void postProcessStdTransform();
 
 			/// <summary>
 			/// Call this when something affects the view scaling, view size, mapping of frequencies, display modes etc.
@@ -210,6 +364,12 @@
 			/// </summary>
 			bool prepareTransform(const AudioStream::AudioBufferAccess & audio);
 
+			/// <summary>
+			/// See prepareTransform(). T is the scalar type of the transform, as given by state.precision.
+			/// </summary>
+			template<typename T>
+				bool prepareTypedTransform(const AudioStream::AudioBufferAccess & audio);
+
 			/// <summary>
 			/// For some transform algorithms, it may be a no-op, but for others (like FFTs) that may need zero-padding
 			/// or windowing, this is done here.
@@ -220,18 +380,77 @@
 			/// </summary>
 			bool prepareTransform(const AudioStream::AudioBufferAccess & audio, fpoint ** preliminaryAudio, std::size_t numChannels, std::size_t numSamples);
 
+			/// <summary>
+			/// See prepareTransform(). T is the scalar type of the transform, as given by state.precision.
+			/// </summary>
+			template<typename T>
+				bool prepareTypedTransform(const AudioStream::AudioBufferAccess & audio, fpoint ** preliminaryAudio, std::size_t numChannels, std::size_t numSamples);
+
 			/// <summary>
 			/// Again, some algorithms may not need this, but this ensures the transform is done after this call.
 			///
 			/// Call prepareTransform(), then doTransform(), then mapToLinearSpace()
 			/// Needs exclusive access to audioResource.
 			/// </summary>
-			void doTransform();
+			template<typename ISA>
+				void doTransform();
+
+			/// <summary>
+			/// Combines a half-size complex transform of packed real samples into the first M + 1 bins of
+			/// the real transform of size 2 * M. See isRealTransform().
+			/// </summary>
+			template<typename T>
+				void unpackRealTransform(std::complex<T> * transform, std::size_t M);
+
+			/// <summary>
+			/// The FFT part of mapToLinearSpace(). T is the scalar type of the transform, as given by state.precision.
+			/// </summary>
+			template<typename T>
+				void mapFFTToLinearSpace(std::size_t numPoints, std::size_t numFilters);
+
+			/// <summary>
+			/// Recomputes binMapping from the current mapped frequencies, transform size, channel configuration
+			/// and interpolation. Allocates, so only call this from handleFlagUpdates() while holding audioResource.
+			/// </summary>
+			void rebuildBinMapping();
+
+			/// <summary>
+			/// Applies the rows [firstRow, firstRow + rows) of binMapping to the transform csf,
+			/// scaling and writing the results to out.
+			/// </summary>
+			template<typename T>
+				void applyBinMapping(const std::complex<T> * csf, std::complex<T> * out, T invSize, std::size_t firstRow, std::size_t rows) const noexcept;
+
+			/// <summary>
+			/// Returns the window kernel of the scalar type T.
+			/// </summary>
+			template<typename T>
+				const T * getWindowKernel() const noexcept;
+
+			/// <summary>
+			/// Returns whether the current channel configuration only needs a real transform.
+			/// If so, prepareTransform() packs the real input as half as many complex samples,
+			/// and doTransform() unpacks the result into the first N / 2 + 1 bins of the audio memory.
+			/// </summary>
+			bool isRealTransform() const noexcept;
 
 			/// <summary>
 			/// internally used for now.
 			/// </summary>
-			bool processNextSpectrumFrame();
+			template<typename ISA>
+				bool processNextSpectrumFrame();
+
+			/// <summary>
+			/// Applies the decay of the line graphs to their filters, running at the update rate (in hertz).
+			/// Only called by the thread running the filters: the async audio thread in line graph mode, otherwise the rendering thread.
+			/// </summary>
+			void updateLineGraphFilters(fpoint updateRate);
+
+			/// <summary>
+			/// processNextSpectrumFrame() for the instruction set of this processor. Used by the offline analysis,
+			/// which consumes colour spectrum frames without rendering them.
+			/// </summary>
+			bool processNextFrame();
 
 			void calculateSpectrumColourRatios();
 		private:
@@ -315,8 +534,11 @@
 			/// for mode = phase
 			/// 	newVals[n * 2 + 0] = mag
 			/// 	newVals[n * 2 + 1] = phase cancellation(with 1 being totally cancelled)
+			///
+			/// The input is first deinterleaved into primaryMagnitudes and secondaryMagnitudes, after which
+			/// the peak filters and the logarithmic mapping is run in vectors of ISA.
 			/// </summary>
-			template<class V2>
+			template<typename ISA, class V2>
 				void mapAndTransformDFTFilters(SpectrumChannels type, const V2 & newVals, std::size_t size, double lowerFraction, double upperFraction, float clip);
 
 			/// <summary>
@@ -367,7 +589,28 @@
 				void resonatingDispatch(float ** buffer, std::size_t numChannels, std::size_t numSamples);
 
 			template<typename ISA>
-				void addAudioFrame();
+				void addAudioFrame(std::uint64_t clock);
+
+			/// <summary>
+			/// Maps and post processes the current transform into the line graphs, and publishes the results to the renderer.
+			/// clock is the steady clock of the stream after the newest sample in the transform.
+			/// Needs exclusive access to audioResource.
+			/// </summary>
+			template<typename ISA>
+				void addLineGraphFrame(std::uint64_t clock);
+
+			/// <summary>
+			/// Searches the raw transform for the peak nearest to trackerFraction, for the frequency tracker.
+			/// T is the scalar type of the transform, as given by state.precision.
+			/// Call after doTransform(), but before mapToLinearSpace(). Needs exclusive access to audioResource.
+			/// </summary>
+			template<typename T>
+				void findTrackedPeak(const std::complex<T> * source, TrackedPeak & result);
+
+			/// <summary>
+			/// Returns the latest processed results of a line graph, from the view of the rendering thread.
+			/// </summary>
+			const cpl::aligned_vector<UComplex, 32> & getLineGraphResults(std::size_t lineGraph) const noexcept;
 
 			/// <summary>
 			/// Copies the state from the complex resonator into the output buffer.
@@ -420,9 +663,18 @@
 				/// </summary>
 				std::atomic<SpectrumContent::TransformAlgorithm> algo;
 				/// <summary>
+				/// The precision of fourier transforms, and thus the layout of the audio and working memory.
+				/// Only changed while holding audioResource.
+				/// </summary>
+				SpectrumContent::TransformPrecision precision;
+				/// <summary>
+				/// Whether the colour spectrum is coloured on the CPU (oglImage) or in a shader (shadedSpectrogram).
+				/// </summary>
+				SpectrumContent::ColourMapping colourMapping;
+				/// <summary>
 				/// How the incoming data is interpreted, channel-wise.
 				/// </summary>
-				SpectrumChannels configuration;
+				SpectrumChannels configuration = SpectrumChannels::Left;
 
 				SpectrumContent::ViewScaling viewScale;
 
@@ -551,6 +803,10 @@
 					/// Set this to recalculate the slopes
 					/// </summary>
 					slopeMapChanged,
+					/// <summary>
+					/// Set this to rebuild the bin to pixel mapping of fourier transforms
+					/// </summary>
+					binMappingChanged,
 					mouseMove;
 			} flags;
 
@@ -572,6 +828,11 @@
 			juce::Point<float> lastMousePos;
 			std::vector<std::unique_ptr<juce::OpenGLTexture>> textures;
 			long long lastFrameTick, renderCycles;
+			LatencyMeter latency;
+			/// <summary>
+			/// The steady clock of the stream after the newest sample drawn, see LatencyMeter.
+			/// </summary>
+			std::uint64_t drawnClock;
 			bool wasResized;
 			cpl::Utility::Bounds<double> oldViewRect;
 			std::atomic_bool hasMainThreadInitializedAudioStreamDependenant;
@@ -597,6 +858,16 @@
 					x, y;
 			} cmouse;
 
+			/// <summary>
+			/// The horizontal mouse position of the frequency tracker as a fraction of the width,
+			/// published by the renderer for the async audio thread. See findTrackedPeak().
+			/// </summary>
+			std::atomic<double> trackerFraction { 0 };
+			/// <summary>
+			/// The fraction of the width on each side of the mouse, that the frequency tracker searches for peaks.
+			/// </summary>
+			static constexpr double trackerSearchFraction = 0.03;
+
 			/// <summary>
 			/// see cpl::dsp::windowScale
 			/// </summary>
@@ -608,10 +879,31 @@
 			std::size_t relayWidth, relayHeight;
 			int framePixelPosition;
 			double oldWindowSize;
-			int droppedAudioFrames;
+			/// <summary>
+			/// See Statistics::deferredFallbacks.
+			/// </summary>
+			std::atomic<std::uint64_t> deferredFallbacks;
 			double framesPerUpdate;
 			cpl::CPeakFilter<double> fpuFilter;
 			std::vector<cpl::GraphicsND::UPixel<cpl::GraphicsND::ComponentOrder::OpenGL>> columnUpdate;
+			/// <summary>
+			/// Columns of the colour spectrum produced since the last frame, uploaded to oglImage in one go.
+			/// </summary>
+			ColumnUploadBuffer<cpl::GraphicsND::UPixel<cpl::GraphicsND::ComponentOrder::OpenGL>> columnUploads;
+			/// <summary>
+			/// The colour spectrum for SpectrumContent::ColourMapping::GraphicsCard, and a column of levels in decibels for it.
+			/// </summary>
+			ShadedSpectrogram shadedSpectrogram;
+			std::vector<float> levelColumn;
+
+			/// <summary>
+			/// Vectorized post processing works on whole vectors, so arrays indexed by filters are padded
+			/// to a multiple of the widest vector.
+			/// </summary>
+			static std::size_t paddedFilterSize(std::size_t numFilters) noexcept
+			{
+				return (numFilters + 7) & ~std::size_t(7);
+			}
 
 			struct LineGraphDesc
 			{
@@ -620,9 +912,16 @@
 				/// </summary>
 				cpl::CPeakFilter<fpoint> filter;
 				/// <summary>
-				/// The'raw' formatted state output of the mapped transform algorithms.
+				/// The decay of the filter, see cpl::CPeakFilter::setDecayAsFraction(). Set by handleFlagUpdates(),
+				/// and applied by the thread running the filter, see updateLineGraphFilters().
 				/// </summary>
-				cpl::aligned_vector<UComplex, 32> states;
+				std::atomic<double> decay { 0 };
+				/// <summary>
+				/// The peak filtered magnitudes of the mapped transform algorithms, as separate arrays of
+				/// paddedFilterSize() size. For dual-channel configurations these are the left and right magnitudes,
+				/// for SpectrumChannels::Phase the magnitude and the filtered phase cancellation.
+				/// </summary>
+				cpl::aligned_vector<fpoint, 32> primaryStates, secondaryStates;
 				/// <summary>
 				/// The decay/peak-filtered and scaled outputs of the transforms,
 				/// with each element corrosponding to a complex output pixel of getAxisPoints() size.
@@ -632,26 +931,100 @@
 
 				void resize(std::size_t n)
 				{
-					states.resize(n); results.resize(n);
+					primaryStates.resize(paddedFilterSize(n)); secondaryStates.resize(paddedFilterSize(n)); results.resize(n);
 				}
 
 				void zero() {
-					std::memset(states.data(), 0, states.size() * sizeof(UComplex));
+					std::memset(primaryStates.data(), 0, primaryStates.size() * sizeof(fpoint));
+					std::memset(secondaryStates.data(), 0, secondaryStates.size() * sizeof(fpoint));
 					std::memset(results.data(), 0, results.size() * sizeof(UComplex));
 				}
 			};
+			struct LineGraphResults : std::array<cpl::aligned_vector<UComplex, 32>, SpectrumContent::LineGraphs::LineEnd>
+			{
+				/// <summary>
+				/// The steady clock of the stream after the newest sample in the transform.
+				/// </summary>
+				std::uint64_t clock = 0;
+				/// <summary>
+				/// The peak of the raw transform for the frequency tracker, see findTrackedPeak().
+				/// </summary>
+				TrackedPeak tracker;
+			};
 			// dsp objects
 			std::array<LineGraphDesc, SpectrumContent::LineGraphs::LineEnd> lineGraphs;
 			/// <summary>
-			/// The complex resonator used for iir spectrums
+			/// In line graph mode, the async audio thread processes the line graphs and publishes the results
+			/// through this, while the renderer picks up the latest results.
+			/// Resized in displayReordered
+			/// </summary>
+			ConcurrentTripleBuffer<LineGraphResults> lineGraphExchange;
+			/// <summary>
+			/// The complex resonators used for iir spectrums, running at decimated rates for lower frequencies
 			/// </summary>
-			cpl::dsp::CComplexResonator<fpoint, 2> cresonator;
+			MultirateResonator<fpoint, 2> cresonator;
 			/// <summary>
 			/// An array, of numFilters size, with each element being the frequency for the filter of
 			/// the corresponding logical display pixel unit.
 			/// </summary>
 			std::vector<fpoint> mappedFrequencies;
 			/// <summary>
+			/// The mapping of fourier bins to display pixels, as a sparse matrix of interpolation weights.
+			/// Pixels spanning several bins instead select the largest bin within a range.
+			/// Only depends on the view and transform size, so it is cached and rebuilt in handleFlagUpdates().
+			/// </summary>
+			struct BinMapping
+			{
+				/// <summary>
+				/// Pixels with a non-zero count select the bin with the largest magnitude of
+				/// first + n * step, for n = 0 ... count - 1, or the fallback if all are zero.
+				/// </summary>
+				struct PeakRange
+				{
+					std::int32_t first, step;
+					std::uint32_t count, fallback;
+				};
+
+				/// <summary>
+				/// Compressed sparse rows: the weights and bin indices of row r are in [rowOffsets[r], rowOffsets[r + 1])
+				/// </summary>
+				std::vector<std::uint32_t> rowOffsets, columns;
+				cpl::aligned_vector<fpoint, 32> weights;
+				std::vector<PeakRange> peaks;
+
+				std::size_t fftSize = 0, numPoints = 0;
+				SpectrumContent::BinInterpolation interpolation = SpectrumContent::BinInterpolation::None;
+				SpectrumChannels configuration = SpectrumChannels::Left;
+
+				void clear()
+				{
+					rowOffsets.clear(); columns.clear(); weights.clear(); peaks.clear();
+					rowOffsets.push_back(0);
+				}
+
+				/// <summary>
+				/// Appends an interpolated row, where the terms are added through addTerm()
+				/// </summary>
+				void beginRow()
+				{
+					peaks.push_back({ 0, 0, 0, 0 });
+					rowOffsets.push_back(rowOffsets.back());
+				}
+
+				void addTerm(std::size_t column, double weight)
+				{
+					columns.push_back(static_cast<std::uint32_t>(column));
+					weights.push_back(static_cast<fpoint>(weight));
+					rowOffsets.back()++;
+				}
+
+				void addPeakRow(PeakRange range)
+				{
+					peaks.push_back(range);
+					rowOffsets.push_back(rowOffsets.back());
+				}
+			} binMapping;
+			/// <summary>
 			/// The connected, incoming stream of data.
 			/// </summary>
 			AudioStream & audioStream;
@@ -733,13 +1106,37 @@
 			/// The time-domain representation of the dsp-window applied to fourier transforms.
 			/// </summary>
 			cpl::aligned_vector<double, 32> windowKernel;
+			/// <summary>
+			/// Single precision copy of the window kernel, for TransformPrecision::Single.
+			/// </summary>
+			cpl::aligned_vector<float, 32> singleWindowKernel;
+			/// <summary>
+			/// Single precision transform, for TransformPrecision::Single.
+			/// Resized together with the audio memory.
+			/// </summary>
+			SingleFFT singleFFT;
+			/// <summary>
+			/// The twiddle factors used for unpacking a real transform of the size of the fft space.
+			/// Resized together with the audio memory.
+			/// </summary>
+			cpl::aligned_vector<std::complex<fftType>, 32> realTransformTwiddles;
 
 			cpl::aligned_vector<fpoint, 32> slopeMap;
 			/// <summary>
+			/// Deinterleaved magnitudes of the transform being post processed, see mapAndTransformDFTFilters().
+			/// Of paddedFilterSize() size.
+			/// </summary>
+			cpl::aligned_vector<fpoint, 32> primaryMagnitudes, secondaryMagnitudes;
+			/// <summary>
+			/// Scratch space for resampling spectrum frames of a different size than the current amount of filters.
+			/// Only used by the rendering thread.
+			/// </summary>
+			cpl::aligned_vector<std::complex<fpoint>, 32> frameInterpolationSpace;
+			/// <summary>
 			/// All audio processing not done in the audio thread (not real-time, async audio) must acquire this lock.
 			/// Notice, you must always acquire this lock before accessing the audio buffers (should you intend to).
 			/// </summary>
-			cpl::CMutex::Lockable audioResource;
+			MeasuredLockable audioResource;
 
 			SFrameBuffer sfbuf;
 		};
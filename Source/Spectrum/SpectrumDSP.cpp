@@ -28,11 +28,17 @@
 *************************************************************************************/
 
 #include "Spectrum.h"
+#include "SpectrumPostProcessing.inl"
 #include <cpl/ffts.h>
 #include <cpl/system/SysStats.h>
 #include <cpl/lib/LockFreeDataQueue.h>
 #include <cpl/stdext.h>
 
+#ifdef SIGNALIZER_BENCHMARKS
+#include "../Analysis/Benchmark.h"
+#include <cstring>
+#endif
+
 namespace Signalizer
 {
 
@@ -108,7 +114,20 @@ namespace Signalizer
 
 
 
-	bool Spectrum::prepareTransform(const AudioStream::AudioBufferAccess & audio)
+	template<>
+	const double * Spectrum::getWindowKernel<double>() const noexcept
+	{
+		return windowKernel.data();
+	}
+
+	template<>
+	const float * Spectrum::getWindowKernel<float>() const noexcept
+	{
+		return singleWindowKernel.data();
+	}
+
+	template<typename T>
+	bool Spectrum::prepareTypedTransform(const AudioStream::AudioBufferAccess & audio)
 	{
 		if (audio.getNumChannels() < 2)
 			return false;
@@ -138,7 +157,10 @@ namespace Signalizer
 			{
 			case SpectrumContent::TransformAlgorithm::FFT:
 			{
-				auto buffer = getAudioMemory<std::complex<fftType>>();
+				auto buffer = getAudioMemory<std::complex<T>>();
+				// mono configurations are packed as real samples, see isRealTransform()
+				auto real = getAudioMemory<T>();
+				auto kernel = getWindowKernel<T>();
 				std::size_t channel = 1;
 				std::size_t i = 0;
 
@@ -160,7 +182,7 @@ namespace Signalizer
 
 							while (range--)
 							{
-								buffer[i] = *it++ * windowKernel[i];
+								real[i] = *it++ * kernel[i];
 								i++;
 							}
 
@@ -190,7 +212,7 @@ namespace Signalizer
 
 							while (range--)
 							{
-								buffer[i] =	(*left++ + *right++) * windowKernel[i] * 0.5f;
+								real[i] = (*left++ + *right++) * kernel[i] * 0.5f;
 								i++;
 							}
 							offset = 0;
@@ -218,7 +240,7 @@ namespace Signalizer
 
 							while (range--)
 							{
-								buffer[i] = (*left++ - *right++) * windowKernel[i] * 0.5f;
+								real[i] = (*left++ - *right++) * kernel[i] * 0.5f;
 								i++;
 							}
 
@@ -247,10 +269,10 @@ namespace Signalizer
 
 							while (range--)
 							{
-								buffer[i] = std::complex<fftType>
+								buffer[i] = std::complex<T>
 								(
-									(*left + *right) * windowKernel[i] * 0.5f,
-									(*left - *right) * windowKernel[i] * 0.5f
+									(*left + *right) * kernel[i] * 0.5f,
+									(*left - *right) * kernel[i] * 0.5f
 								);
 								left++;
 								right++;
@@ -284,10 +306,10 @@ namespace Signalizer
 
 							while (range--)
 							{
-								buffer[i] = std::complex<fftType>
+								buffer[i] = std::complex<T>
 								{
-									*left++ * windowKernel[i],
-									*right++ * windowKernel[i]
+									*left++ * kernel[i],
+									*right++ * kernel[i]
 								};
 								i++;
 							}
@@ -302,10 +324,15 @@ namespace Signalizer
 				}
 				}
 				//zero-pad until buffer is filled
-
-				for (size_t pad = i; pad < fullSize; ++pad)
+				if (isRealTransform())
+				{
+					for (size_t pad = i; pad < fullSize; ++pad)
+						real[pad] = 0;
+				}
+				else
 				{
-					buffer[pad] = (fftType)0;
+					for (size_t pad = i; pad < fullSize; ++pad)
+						buffer[pad] = 0;
 				}
 
 				break;
@@ -316,7 +343,8 @@ namespace Signalizer
 		return true;
 	}
 
-	bool Spectrum::prepareTransform(const AudioStream::AudioBufferAccess & audio, Spectrum::fpoint ** preliminaryAudio, std::size_t numChannels, std::size_t numSamples)
+	template<typename T>
+	bool Spectrum::prepareTypedTransform(const AudioStream::AudioBufferAccess & audio, Spectrum::fpoint ** preliminaryAudio, std::size_t numChannels, std::size_t numSamples)
 	{
 
 		auto size = getWindowSize(); // the size of the transform, containing samples
@@ -343,7 +371,10 @@ namespace Signalizer
 			{
 			case SpectrumContent::TransformAlgorithm::FFT:
 			{
-				auto buffer = getAudioMemory<std::complex<fftType>>();
+				auto buffer = getAudioMemory<std::complex<T>>();
+				// mono configurations are packed as real samples, see isRealTransform()
+				auto real = getAudioMemory<T>();
+				auto kernel = getWindowKernel<T>();
 				std::size_t channel = 1;
 				std::size_t i = 0;
 				std::size_t stop = std::min(numSamples, size);
@@ -375,7 +406,7 @@ namespace Signalizer
 
 							while (range-- && i < sizeToStopAt)
 							{
-								buffer[i] = *it++ * windowKernel[i];
+								real[i] = *it++ * kernel[i];
 								i++;
 							}
 
@@ -392,7 +423,7 @@ namespace Signalizer
 					// process preliminary
 					for (std::size_t k = 0; k < stop; ++i, k++)
 					{
-						buffer[i] = preliminaryAudio[channel][k] * windowKernel[i];
+						real[i] = preliminaryAudio[channel][k] * kernel[i];
 					}
 
 
@@ -414,7 +445,7 @@ namespace Signalizer
 
 							while (range-- && i < sizeToStopAt)
 							{
-								buffer[i] = (*left++ + *right++) * windowKernel[i] * 0.5f;
+								real[i] = (*left++ + *right++) * kernel[i] * 0.5f;
 								i++;
 							}
 
@@ -429,7 +460,7 @@ namespace Signalizer
 
 					for (std::size_t k = 0; k < stop; ++i, k++)
 					{
-						buffer[i] = (preliminaryAudio[0][k] + preliminaryAudio[1][k]) * windowKernel[i] * (fftType)0.5;
+						real[i] = (preliminaryAudio[0][k] + preliminaryAudio[1][k]) * kernel[i] * (T)0.5;
 					}
 
 					break;
@@ -450,7 +481,7 @@ namespace Signalizer
 
 							while (range-- && i < sizeToStopAt)
 							{
-								buffer[i] = (*left++ - *right++) * windowKernel[i] * (fftType)0.5;
+								real[i] = (*left++ - *right++) * kernel[i] * (T)0.5;
 								i++;
 							}
 
@@ -465,7 +496,7 @@ namespace Signalizer
 
 					for (std::size_t k = 0; k < stop; ++i, k++)
 					{
-						buffer[i] = (preliminaryAudio[0][k] - preliminaryAudio[1][k]) * windowKernel[i] * (fftType)0.5;
+						real[i] = (preliminaryAudio[0][k] - preliminaryAudio[1][k]) * kernel[i] * (T)0.5;
 					}
 
 					break;
@@ -486,10 +517,10 @@ namespace Signalizer
 
 							while (range-- && i < sizeToStopAt)
 							{
-								buffer[i] = std::complex<fftType>
+								buffer[i] = std::complex<T>
 								(
-									(*left + *right) * windowKernel[i] * (fftType)0.5,
-									(*left - *right) * windowKernel[i] * (fftType)0.5
+									(*left + *right) * kernel[i] * (T)0.5,
+									(*left - *right) * kernel[i] * (T)0.5
 								);
 								left++;
 								right++;
@@ -507,10 +538,10 @@ namespace Signalizer
 
 					for (std::size_t k = 0; k < stop; ++i, k++)
 					{
-						buffer[i] = std::complex<fftType>
+						buffer[i] = std::complex<T>
 						(
-							(preliminaryAudio[0][k] + preliminaryAudio[1][k]) * windowKernel[i] * (fftType)0.5,
-							(preliminaryAudio[0][k] - preliminaryAudio[1][k]) * windowKernel[i] * (fftType)0.5
+							(preliminaryAudio[0][k] + preliminaryAudio[1][k]) * kernel[i] * (T)0.5,
+							(preliminaryAudio[0][k] - preliminaryAudio[1][k]) * kernel[i] * (T)0.5
 						);
 					}
 
@@ -535,10 +566,10 @@ namespace Signalizer
 
 							while (range-- && i < sizeToStopAt)
 							{
-								buffer[i] = std::complex<fftType>
+								buffer[i] = std::complex<T>
 								{
-									*left++ * windowKernel[i],
-									*right++ * windowKernel[i]
+									*left++ * kernel[i],
+									*right++ * kernel[i]
 								};
 								i++;
 							}
@@ -554,10 +585,10 @@ namespace Signalizer
 
 					for (std::size_t k = 0; k < stop; ++i, k++)
 					{
-						buffer[i] = std::complex<fftType>
+						buffer[i] = std::complex<T>
 						(
-							preliminaryAudio[0][k] * windowKernel[i],
-							preliminaryAudio[1][k] * windowKernel[i]
+							preliminaryAudio[0][k] * kernel[i],
+							preliminaryAudio[1][k] * kernel[i]
 						);
 					}
 
@@ -565,9 +596,15 @@ namespace Signalizer
 				}
 				}
 				//zero-pad until buffer is filled
-				for (size_t pad = i; pad < fullSize; ++pad)
+				if (isRealTransform())
 				{
-					buffer[pad] = 0;
+					for (size_t pad = i; pad < fullSize; ++pad)
+						real[pad] = 0;
+				}
+				else
+				{
+					for (size_t pad = i; pad < fullSize; ++pad)
+						buffer[pad] = 0;
 				}
 
 				break;
@@ -578,207 +615,484 @@ namespace Signalizer
 		return true;
 	}
 
-	void Spectrum::doTransform()
+	bool Spectrum::prepareTransform(const AudioStream::AudioBufferAccess & audio)
 	{
-		CPL_RUNTIME_ASSERTION(audioResource.refCountForThisThread() > 0 && "Thread processing audio transforms doesn't own lock");
+		SIGNALIZER_TRACE_ZONE("Spectrum::prepareTransform");
 
-		switch (state.algo.load(std::memory_order_acquire))
-		{
-			case SpectrumContent::TransformAlgorithm::FFT:
-			{
-				auto const numSamples = getFFTSpace<std::complex<double>>();
-				if(numSamples != 0)
-					signaldust::DustFFT_fwdDa(getAudioMemory<double>(), static_cast<unsigned int>(numSamples));
+		if (state.precision == SpectrumContent::TransformPrecision::Single)
+			return prepareTypedTransform<float>(audio);
 
-				break;
-			}
-		}
+		return prepareTypedTransform<double>(audio);
 	}
 
+	bool Spectrum::prepareTransform(const AudioStream::AudioBufferAccess & audio, Spectrum::fpoint ** preliminaryAudio, std::size_t numChannels, std::size_t numSamples)
+	{
+		SIGNALIZER_TRACE_ZONE("Spectrum::prepareTransform");
 
+		if (state.precision == SpectrumContent::TransformPrecision::Single)
+			return prepareTypedTransform<float>(audio, preliminaryAudio, numChannels, numSamples);
 
-	template<class V2>
-		void Spectrum::mapAndTransformDFTFilters(SpectrumChannels type, const V2 & newVals, std::size_t size, double lowDbs, double highDbs, float clip)
-		{
-			double lowerFraction = cpl::Math::dbToFraction<double>(lowDbs);
-			double upperFraction = cpl::Math::dbToFraction<double>(highDbs);
-
-			auto deltaYRecip = static_cast<fpoint>(1.0 / log(upperFraction / lowerFraction));
-			auto minFracRecip = static_cast<fpoint>(1.0 / lowerFraction);
-			auto halfRecip = fpoint(0.5);
+		return prepareTypedTransform<double>(audio, preliminaryAudio, numChannels, numSamples);
+	}
 
-			fpoint lowerClip = (fpoint)clip;
+	bool Spectrum::isRealTransform() const noexcept
+	{
+		switch (state.configuration)
+		{
+		case SpectrumChannels::Left:
+		case SpectrumChannels::Right:
+		case SpectrumChannels::Merge:
+		case SpectrumChannels::Side:
+			return true;
+		default:
+			return false;
+		}
+	}
 
-			switch (type)
-			{
-			case SpectrumChannels::Left:
-			case SpectrumChannels::Merge:
-			case SpectrumChannels::Right:
-			case SpectrumChannels::Side:
-			case SpectrumChannels::Complex:
+	template<typename T>
+		void Spectrum::unpackRealTransform(std::complex<T> * z, std::size_t M)
+		{
+			// split the transform of the even and odd samples, and combine them
+			// into the first N / 2 + 1 bins of the real transform:
+			// E[k] = (Z[k] + Z*[M - k]) / 2, O[k] = -i * (Z[k] - Z*[M - k]) / 2
+			// X[k] = E[k] + W^k * O[k], X[M - k] = (E[k] - W^k * O[k])*
+			const T half = 0.5;
+			auto const dc = z[0];
+			z[0] = dc.real() + dc.imag();
+			z[M] = dc.real() - dc.imag();
+
+			for (std::size_t k = 1; k <= (M >> 1); ++k)
 			{
+				auto const zk = z[k];
+				auto const zmk = std::conj(z[M - k]);
 
-				for (cpl::Types::fint_t i = 0; i < size; ++i)
-				{
-
-					auto newReal = newVals[i * 2];
-					auto newImag = newVals[i * 2 + 1];
-					// mag = abs(cmplx)
-					auto magnitude = sqrt(newReal * newReal + newImag * newImag);
+				auto const even = half * (zk + zmk);
+				auto const odd = std::complex<T>(0, -half) * (zk - zmk);
+				auto const twiddled = std::complex<T>(realTransformTwiddles[k]) * odd;
 
+				z[k] = even + twiddled;
+				z[M - k] = std::conj(even - twiddled);
+			}
 
-					for (std::size_t k = 0; k < lineGraphs.size(); ++k)
-					{
-						lineGraphs[k].states[i].magnitude *= lineGraphs[k].filter.pole;
-
-						if (magnitude > lineGraphs[k].states[i].magnitude)
-						{
-							lineGraphs[k].states[i].magnitude = (fpoint)magnitude;
-						}
+			// the upper half mirrors the lower half for real signals. interpolation filters
+			// may read a couple of bins past the nyquist bin, so mirror those.
+			auto const guard = std::min<std::size_t>(8, M - 1);
+			for (std::size_t k = 1; k <= guard; ++k)
+			{
+				z[M + k] = std::conj(z[M - k]);
+			}
+		}
 
-						auto deltaX = slopeMap[i] * lineGraphs[k].states[i].magnitude * minFracRecip;
-						// deltaX mostly zero here - add simd check
-						auto result = deltaX > 0 ? std::log(deltaX) * deltaYRecip : lowerClip;
-						lineGraphs[k].results[i].magnitude = (fpoint)result;
-						lineGraphs[k].results[i].phase = 0;
-					}
+	template<typename ISA>
+		void Spectrum::doTransform()
+		{
+			CPL_RUNTIME_ASSERTION(audioResource.refCountForThisThread() > 0 && "Thread processing audio transforms doesn't own lock");
+			SIGNALIZER_TRACE_ZONE("Spectrum::doTransform");
 
-				}
-				break;
-			}
-			case SpectrumChannels::Separate:
-			case SpectrumChannels::MidSide:
+			switch (state.algo.load(std::memory_order_acquire))
 			{
-
-				for (cpl::Types::fint_t i = 0; i < size; ++i)
+				case SpectrumContent::TransformAlgorithm::FFT:
 				{
+					auto const numSamples = getFFTSpace<std::complex<double>>();
+					auto const isSingle = state.precision == SpectrumContent::TransformPrecision::Single;
 
-					auto lreal = newVals[i * 2];
-					auto rreal = newVals[i * 2 + size * 2];
-					auto limag = newVals[i * 2 + 1];
-					auto rimag = newVals[i * 2 + size * 2 + 1];
-					// mag = abs(cmplx)
-					auto lmag = sqrt(lreal * lreal + limag * limag);
-					auto rmag = sqrt(rreal * rreal + rimag * rimag);
+					if (!isRealTransform())
+					{
+						if (numSamples == 0)
+							break;
 
-					for (std::size_t k = 0; k < lineGraphs.size(); ++k)
+						if (isSingle)
+							singleFFT.forward<ISA>(getAudioMemory<std::complex<float>>(), numSamples);
+						else
+							signaldust::DustFFT_fwdDa(getAudioMemory<double>(), static_cast<unsigned int>(numSamples));
+					}
+					else if (numSamples >= 2)
 					{
-						lineGraphs[k].states[i].leftMagnitude *= lineGraphs[k].filter.pole;
-						lineGraphs[k].states[i].rightMagnitude *= lineGraphs[k].filter.pole;
+						// N real samples are packed as z[n] = x[2n] + i * x[2n + 1], so we only need
+						// a complex transform of half the size.
+						auto const M = numSamples >> 1;
 
-						if (lmag > lineGraphs[k].states[i].leftMagnitude)
+						if (isSingle)
 						{
-							lineGraphs[k].states[i].leftMagnitude = (fpoint)lmag;
+							singleFFT.forward<ISA>(getAudioMemory<std::complex<float>>(), M);
+							unpackRealTransform(getAudioMemory<std::complex<float>>(), M);
 						}
-						if (rmag > lineGraphs[k].states[i].rightMagnitude)
+						else
 						{
-							lineGraphs[k].states[i].rightMagnitude = (fpoint)rmag;
+							signaldust::DustFFT_fwdDa(getAudioMemory<double>(), static_cast<unsigned int>(M));
+							unpackRealTransform(getAudioMemory<std::complex<double>>(), M);
 						}
-						// log10(y / _min) / log10(_max / _min);
-						auto deltaLX = slopeMap[i] * lineGraphs[k].states[i].leftMagnitude * minFracRecip;
-						auto deltaRX = slopeMap[i] * lineGraphs[k].states[i].rightMagnitude * minFracRecip;
-						// deltaX mostly zero here - add simd check
-						auto lResult = deltaLX > 0 ? std::log(deltaLX) * deltaYRecip : lowerClip;
-						auto rResult = deltaRX > 0 ? std::log(deltaRX) * deltaYRecip : lowerClip;
-						lineGraphs[k].results[i].leftMagnitude = (fpoint)lResult;
-						lineGraphs[k].results[i].rightMagnitude = (fpoint)rResult;
 					}
+
+					break;
 				}
-				break;
 			}
-			case SpectrumChannels::Phase:
-			{
-				fpoint phaseFilters[SpectrumContent::LineGraphs::LineEnd];
+		}
 
-				for (std::size_t k = 0; k < lineGraphs.size(); ++k)
-					phaseFilters[k] = std::pow(lineGraphs[k].filter.pole, 0.3);
 
-				for (cpl::Types::fint_t i = 0; i < size; ++i)
-				{
 
-					auto mag = newVals[i * 2];
-					auto phase = newVals[i * 2 + 1];
-					// mag = abs(cmplx)
+	template<typename ISA>
+	void Spectrum::postProcessStdTransform()
+	{
+		if (state.algo.load(std::memory_order_acquire) != SpectrumContent::TransformAlgorithm::FFT)
+			postProcessTransform<ISA>(getWorkingMemory<fpoint>(), getNumFilters());
+		else if (state.precision == SpectrumContent::TransformPrecision::Single)
+			postProcessTransform<ISA>(getWorkingMemory<float>(), getNumFilters());
+		else
+			postProcessTransform<ISA>(getWorkingMemory<fftType>(), getNumFilters());
+	}
 
-					mag *= halfRecip;
+	template<typename T>
+		void Spectrum::findTrackedPeak(const std::complex<T> * source, TrackedPeak & result)
+		{
+			CPL_RUNTIME_ASSERTION(audioResource.refCountForThisThread() > 0 && "Thread processing audio transforms doesn't own lock");
 
-					for (std::size_t k = 0; k < lineGraphs.size(); ++k)
-					{
-						lineGraphs[k].states[i].magnitude *= lineGraphs[k].filter.pole;
+			const cpl::ssize_t N = getFFTSpace<std::complex<fftType>>();
+			const cpl::ssize_t points = getNumFilters();
 
-						if (mag > lineGraphs[k].states[i].magnitude)
-						{
-							lineGraphs[k].states[i].magnitude = (fpoint)mag;
-						}
-						phase *= mag;
+			if (N < 2 || points < 1)
+				return;
 
-						lineGraphs[k].states[i].phase = phase + phaseFilters[k] * (lineGraphs[k].states[i].phase - phase);
+			const auto sampleRate = getSampleRate();
+			const auto mouseFraction = trackerFraction.load(std::memory_order_relaxed);
 
+			auto lowerBound = cpl::Math::round<cpl::ssize_t>(points * (mouseFraction - trackerSearchFraction));
+			lowerBound = cpl::Math::round<cpl::ssize_t>((N * mappedFrequencies[cpl::Math::confineTo(lowerBound, 0, points - 1)] / sampleRate));
+			auto higherBound = cpl::Math::round<cpl::ssize_t>(points * (mouseFraction + trackerSearchFraction));
+			higherBound = cpl::Math::round<cpl::ssize_t>((N * mappedFrequencies[cpl::Math::confineTo(higherBound, 0, points - 1)] / sampleRate));
 
-						// log10(y / _min) / log10(_max / _min);
-						// deltaX mostly zero here - add simd check
-						auto deltaX = slopeMap[i] * lineGraphs[k].states[i].magnitude * minFracRecip;
-						auto deltaY = slopeMap[i] * lineGraphs[k].states[i].phase * minFracRecip;
-						// deltaX mostly zero here - add simd check
-						auto result = deltaX > 0 ? std::log(deltaX) * deltaYRecip : lowerClip;
-						lineGraphs[k].results[i].magnitude = (fpoint)result;
-						lineGraphs[k].results[i].phase = (fpoint)(deltaY > 0 ? std::log(deltaY) * deltaYRecip : lowerClip);
-					}
+			lowerBound = cpl::Math::confineTo(lowerBound, 0, N);
+			higherBound = cpl::Math::confineTo(higherBound, lowerBound, N);
+
+			auto const invSize = windowScale / (getWindowSize() * 0.5);
+
+			auto peak = std::max_element(source + lowerBound, source + higherBound + 1,
+				[](const auto & left, const auto & right) { return cpl::Math::square(left) < cpl::Math::square(right); });
+
+			// scan for continuously rising peaks at boundaries
+			if (peak == source + lowerBound && lowerBound != 0)
+			{
+				while (true)
+				{
+					auto nextPeak = peak - 1;
+					if (nextPeak == source)
+						break;
+					else if (cpl::Math::square(*nextPeak) < cpl::Math::square(*peak))
+						break;
+					else
+						peak = nextPeak;
 				}
-				break;
 			}
-			};
+			else if (peak == source + (higherBound - 1))
+			{
+				while (true)
+				{
+					auto nextPeak = peak + 1;
+					if (nextPeak == source + N)
+						break;
+					else if (cpl::Math::square(*nextPeak) < cpl::Math::square(*peak))
+						break;
+					else
+						peak = nextPeak;
+				}
+			}
+
+			auto peakOffset = std::distance(source, peak);
+
+			// interpolate using a parabolic fit
+			// https://ccrma.stanford.edu/~jos/parshl/Peak_Detection_Steps_3.html
+			// jos suggests doing the fit in logarithmic domain, it tends to create nans and infs we wouldn't have got otherwise -
+			// explaning the various isnormal() checks
+			auto alpha = 20 * std::log10(std::abs(source[peakOffset == 0 ? 0 : peakOffset - 1]) * invSize);
+			auto beta = 20 * std::log10(std::abs(source[peakOffset]) * invSize);
+			auto gamma = 20 * std::log10(std::abs(source[peakOffset == N ? peakOffset : peakOffset + 1]) * invSize);
+
+			auto phi = 0.5 * (alpha - gamma) / (alpha - 2 * beta + gamma);
 
+			result.fraction = 2 * (peakOffset + (std::isnormal(phi) ? phi : 0)) / double(N);
 
+			result.dBs = beta - 0.25*(alpha - gamma) * phi;
+			if (!std::isnormal(result.dBs))
+				result.dBs = 20 * std::log10(std::abs(source[peakOffset]) / (N * 0.5));
+
+			result.found = true;
 		}
 
-	template<class InVector>
-		void Spectrum::postProcessTransform(const InVector & transform, std::size_t size)
+	template<typename ISA>
+	void Spectrum::addLineGraphFrame(std::uint64_t clock)
+	{
+		CPL_RUNTIME_ASSERTION(audioResource.refCountForThisThread() > 0 && "Thread processing audio transforms doesn't own lock");
+		SIGNALIZER_TRACE_ZONE("Spectrum::addLineGraphFrame");
+
+		auto & back = lineGraphExchange.back();
+
+		// the mapping below modifies the raw transform, so the tracker has to search it first.
+		back.tracker.found = false;
+
+		if (state.algo.load(std::memory_order_acquire) == SpectrumContent::TransformAlgorithm::FFT && state.configuration != SpectrumChannels::Complex
+			&& state.frequencyTrackingGraph == SpectrumContent::LineGraphs::Transform)
 		{
-			if (size > (std::size_t)getNumFilters())
-				CPL_RUNTIME_EXCEPTION("Incompatible incoming transform size.");
-			mapAndTransformDFTFilters(state.configuration, transform, size, content->lowDbs.getTransformedValue(), content->highDbs.getTransformedValue(), content->lowDbs.getTransformer().transform(0));
+			if (state.precision == SpectrumContent::TransformPrecision::Single)
+				findTrackedPeak(getAudioMemory<std::complex<float>>(), back.tracker);
+			else
+				findTrackedPeak(getAudioMemory<std::complex<fftType>>(), back.tracker);
 		}
 
-	void Spectrum::postProcessStdTransform()
+		mapToLinearSpace();
+
+		// the peak filters are updated once per blob, instead of once per rendered frame.
+		const auto updateRate = getSampleRate() / std::max<std::size_t>(1, sfbuf.sampleBufferSize);
+		updateLineGraphFilters(static_cast<fpoint>(updateRate));
+
+		postProcessStdTransform<ISA>();
+
+		// the results are entirely rewritten on each post processing, so we can just exchange the storage
+		// instead of copying it.
+		for (std::size_t i = 0; i < SpectrumContent::LineGraphs::LineEnd; ++i)
+			std::swap(back[i], lineGraphs[i].results);
+
+		back.clock = clock;
+		lineGraphExchange.publish();
+	}
+
+	const cpl::aligned_vector<Spectrum::UComplex, 32> & Spectrum::getLineGraphResults(std::size_t lineGraph) const noexcept
 	{
-		if (state.algo.load(std::memory_order_acquire) == SpectrumContent::TransformAlgorithm::FFT)
-			postProcessTransform(getWorkingMemory<fftType>(), getNumFilters());
-		else
-			postProcessTransform(getWorkingMemory<fpoint>(), getNumFilters());
+		return state.displayMode == SpectrumContent::DisplayMode::LineGraph ? lineGraphExchange.front()[lineGraph] : lineGraphs[lineGraph].results;
 	}
 
-	std::size_t Spectrum::mapToLinearSpace()
+	void Spectrum::rebuildBinMapping()
 	{
-		CPL_RUNTIME_ASSERTION(audioResource.refCountForThisThread() > 0 && "Thread processing audio transforms doesn't own lock");
+		CPL_RUNTIME_ASSERTION(audioResource.refCountForThisThread() > 0 && "Thread rebuilding the bin mapping doesn't own lock");
 
 		using namespace cpl;
-		std::size_t numPoints = getAxisPoints();
 
-		std::size_t numFilters = getNumFilters();
+		const auto lanczosFilterSize = 5;
+		const std::size_t N = getFFTSpace<std::complex<double>>();
+		const std::size_t numPoints = getAxisPoints();
 
-		switch (state.algo.load(std::memory_order_acquire))
+		auto & mapping = binMapping;
+		mapping.clear();
+		mapping.fftSize = N;
+		mapping.numPoints = 0;
+		mapping.interpolation = state.binPolation;
+		mapping.configuration = state.configuration;
+
+		if (N == 0 || numPoints == 0 || mappedFrequencies.size() < numPoints)
+			return;
+
+		const std::size_t numBins = N >> 1;
+		const double topFrequency = getSampleRate() / 2;
+		const double freqToBin = double(numBins) / topFrequency;
+
+		auto binPosition = [&](std::size_t x) { return mappedFrequencies[x] * freqToBin; };
+		// bandwidth of the filter for this 'line', or point
+		auto bandwidth = [&](std::size_t x) { return (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency; };
+
+		auto sinc = [](double x) { return x == 0 ? 1.0 : std::sin(simd::consts<double>::pi * x) / (simd::consts<double>::pi * x); };
+
+		// a row interpolating the bins around the fractional position, out of filterSize bins.
+		// mirrored rows read the upper half of two-for-one transforms (N - position).
+		auto addInterpolatedRow = [&](double position, std::size_t filterSize, std::size_t nearestLimit, bool mirrored)
 		{
-		case SpectrumContent::TransformAlgorithm::FFT:
+			auto addTerm = [&](cpl::ssize_t index, double weight)
+			{
+				if (index >= 0 && (std::size_t)index < filterSize && weight != 0)
+					mapping.addTerm(index, weight);
+			};
+
+			mapping.beginRow();
+
+			switch (state.binPolation)
+			{
+			case SpectrumContent::BinInterpolation::Linear:
+			{
+				const double where = mirrored ? N - position : position;
+				const auto index = static_cast<cpl::ssize_t>(std::floor(where));
+				const double fraction = where - index;
+				addTerm(index, 1 - fraction);
+				addTerm(index + 1, fraction);
+				break;
+			}
+			case SpectrumContent::BinInterpolation::Lanczos:
+			{
+				const double where = mirrored ? N - position : position;
+				const auto index = static_cast<cpl::ssize_t>(std::floor(where));
+				for (auto k = index - lanczosFilterSize + 1; k <= index + lanczosFilterSize; ++k)
+				{
+					const double distance = where - k;
+					addTerm(k, sinc(distance) * sinc(distance / lanczosFilterSize));
+				}
+				break;
+			}
+			default:
+			{
+				// +0.5 to centerly space bins.
+				auto index = Math::confineTo((std::size_t)(position + 0.5), 0, nearestLimit);
+				addTerm(mirrored ? N - index : index, 1);
+				break;
+			}
+			}
+		};
+
+		// a row selecting the largest bin in (oldBin, bin], or just oldBin if they are equal.
+		auto addPeakRow = [&](cpl::ssize_t oldBin, cpl::ssize_t bin, bool mirrored)
+		{
+			auto const diff = bin - oldBin;
+			auto const first = diff ? oldBin + 1 : oldBin;
+
+			BinMapping::PeakRange range;
+			range.count = static_cast<std::uint32_t>(std::max<cpl::ssize_t>(1, diff));
+			range.first = static_cast<std::int32_t>(mirrored ? N - first : first);
+			range.step = mirrored ? -1 : 1;
+			range.fallback = static_cast<std::uint32_t>(mirrored ? N - bin : bin);
+
+			mapping.addPeakRow(range);
+		};
+
+		// as long as the bandwidth is smaller than our fft resolution, we interpolate the points
+		// otherwise, sample the max values of the bins inside the bandwidth
+		auto addChannelRows = [&](double fftBandwidth, std::size_t filterSize, std::size_t nearestLimit, bool mirrored)
+		{
+			std::size_t x = 0;
+
+			for (; x < numPoints - 1 && bandwidth(x) <= fftBandwidth; ++x)
+				addInterpolatedRow(binPosition(x), filterSize, nearestLimit, mirrored);
+
+			cpl::ssize_t oldBin = static_cast<cpl::ssize_t>(binPosition(x));
+
+			for (; x < numPoints; ++x)
+			{
+				cpl::ssize_t bin = static_cast<std::size_t>(binPosition(x));
+				addPeakRow(oldBin, bin, mirrored);
+				oldBin = bin;
+			}
+		};
+
+		switch (state.configuration)
+		{
+		case SpectrumChannels::Left:
+		case SpectrumChannels::Right:
+		case SpectrumChannels::Merge:
+		case SpectrumChannels::Side:
+			addChannelRows(1.0 / numBins, N, numBins, false);
+			break;
+		case SpectrumChannels::Separate:
+		case SpectrumChannels::MidSide:
+			// left channel rows, followed by right channel rows
+			addChannelRows(1.0 / numBins, N + 1, numBins, false);
+			addChannelRows(1.0 / numBins, N + 1, numBins, true);
+			break;
+		case SpectrumChannels::Complex:
+		{
+			const double fftBandwidth = 1.0 / (numBins * 2);
+			cpl::ssize_t oldBin = 0;
+			std::size_t x = 0;
+
+			// the complex spectrum changes resolution twice, so alternate until all points are mapped
+			while (x < numPoints)
+			{
+				for (; x < numPoints; ++x)
+				{
+					if (x != numPoints - 1 && bandwidth(x) > fftBandwidth)
+						break;
+
+					addInterpolatedRow(binPosition(x), N + 1, N, false);
+				}
+
+				if (x != numPoints)
+					oldBin = static_cast<cpl::ssize_t>(binPosition(x));
+
+				for (; x < numPoints; ++x)
+				{
+					cpl::ssize_t bin = static_cast<std::size_t>(binPosition(x));
+
+					if (x != numPoints - 1 && bandwidth(x) < fftBandwidth)
+						break;
+
+					addPeakRow(oldBin, bin, false);
+					oldBin = bin;
+				}
+			}
+			break;
+		}
+		default:
+			// phase spectrums are mapped directly, see mapFFTToLinearSpace()
+			break;
+		}
+
+		mapping.numPoints = numPoints;
+	}
+
+	template<typename T>
+		void Spectrum::applyBinMapping(const std::complex<T> * csf, std::complex<T> * out, T invSize, std::size_t firstRow, std::size_t rows) const noexcept
+		{
+			const std::uint32_t * const offsets = binMapping.rowOffsets.data();
+			const std::uint32_t * const columns = binMapping.columns.data();
+			const fpoint * const weights = binMapping.weights.data();
+			const BinMapping::PeakRange * const peaks = binMapping.peaks.data();
+
+			for (std::size_t r = 0; r < rows; ++r)
+			{
+				const auto row = firstRow + r;
+				const auto & peak = peaks[row];
+
+				if (peak.count == 0)
+				{
+					std::complex<T> sum = 0;
+
+					for (auto i = offsets[row]; i < offsets[row + 1]; ++i)
+						sum += static_cast<T>(weights[i]) * csf[columns[i]];
+
+					out[r] = invSize * sum;
+				}
+				else
+				{
+					std::size_t maxBin = peak.fallback;
+					T maxMagnitude = 0;
+					std::int32_t offset = peak.first;
+
+					// select highest number in this chunk for display. Not exactly correct, though.
+					for (std::uint32_t n = 0; n < peak.count; ++n, offset += peak.step)
+					{
+						const T newMagnitude = std::norm(csf[offset]);
+						if (newMagnitude > maxMagnitude)
+						{
+							maxMagnitude = newMagnitude;
+							maxBin = offset;
+						}
+					}
+
+					out[r] = invSize * csf[maxBin];
+				}
+			}
+		}
+
+	template<typename T>
+		void Spectrum::mapFFTToLinearSpace(std::size_t numPoints, std::size_t numFilters)
 		{
+			using namespace cpl;
+
 			const auto lanczosFilterSize = 5;
-			cpl::ssize_t bin = 0, oldBin = 0, maxLBin, maxRBin = 0;
+			cpl::ssize_t bin = 0, oldBin = 0;
 			Types::fsint_t N = static_cast<Types::fsint_t>(getFFTSpace<std::complex<double>>());
 
 			// we rely on mapping indexes, so we need N > 2 at least.
 			if (N == 0)
-				return 0;
+				return;
+
+			// the bin mapping is rebuilt in handleFlagUpdates() for any change of these, so a mismatch is transient.
+			if (state.configuration != SpectrumChannels::Phase &&
+				(binMapping.fftSize != (std::size_t)N || binMapping.numPoints != numPoints || binMapping.configuration != state.configuration))
+				return;
 
 			std::size_t numBins = N >> 1;
 			auto const topFrequency = getSampleRate() / 2;
 			auto const freqToBin = double(numBins ) / topFrequency;
 
-			typedef fftType ftype;
+			typedef T ftype;
 
 			std::complex<ftype> leftMax, rightMax;
 
-			ftype maxLMag, maxRMag, newLMag, newRMag;
-
 			// complex transform results, N + 1 size
 			std::complex<ftype> * csf = getAudioMemory<std::complex<ftype>>();
 			// buffer for single results, numPoints * 2 size
@@ -789,7 +1103,7 @@ namespace Signalizer
 			// this will make scaling correct regardless of amount of zero-padding
 			// notice the 0.5: fft's of size 32 will output 16 for exact frequency bin matches,
 			// so we halve the reciprocal scaling factor to normalize the size.
-			auto const invSize = windowScale / (getWindowSize() * 0.5);
+			auto const invSize = static_cast<ftype>(windowScale / (getWindowSize() * 0.5));
 
 			switch (state.configuration)
 			{
@@ -798,8 +1112,6 @@ namespace Signalizer
 			case SpectrumChannels::Merge:
 			case SpectrumChannels::Side:
 			{
-				oldBin = mappedFrequencies[0] * freqToBin;
-
 				// the DC (0) and nyquist bin are NOT 'halved' due to the symmetric nature of the fft,
 				// so halve these:
 				csf[0] *= 0.5;
@@ -811,118 +1123,41 @@ namespace Signalizer
 					csf[i] = std::abs(csf[i]);
 				}
 
+				applyBinMapping(csf, csp, invSize, 0, numPoints);
+
+				break;
+			}
+			case SpectrumChannels::Phase:
+			{
+				// two-for-one pass, first channel is 0... N/2 -1, second is N/2 .. N -1
+				dsp::separateTransformsIPL(csf, N);
+
+				// fix up DC and nyquist bins (see previous function documentation)
+				csf[N] = csf[0].imag() * 0.5;
+				csf[0] = csf[0].real() * 0.5;
+				csf[N >> 1] *= 0.5;
+				csf[(N >> 1) - 1] *= 0.5;
+
+				// TODO: rewrite this.
+				// firstly, we have to do a phase cancellation pass.
+				// this is because magnitude interpolation is wrong for
+				// complex vectors, it needs to be done on magnitude.
+				// however, phase calculation needs to be done on vectors.
+				// so we first do a phase cancellation pass, and afterwards
+				// absolute the lower bottom of the transform, that needs to be interpolated.
+
+				// The index of the transform, where the bandwidth is higher than mapped pixels (so no more interpolation is needed)
+				// TODO: This can be calculated from view mapping scale and N pixels.
+				std::size_t bandWidthBreakingPoint = numPoints;
+
 				double fftBandwidth = 1.0 / numBins;
 				//double pxlBandwidth = 1.0 / numPoints;
 				cpl::Types::fint_t x = 0;
 				switch (state.binPolation)
 				{
-				case SpectrumContent::BinInterpolation::None:
-					for (x = 0; x < numPoints - 1; ++x)
-					{
-						// bandwidth of the filter for this 'line', or point
-						double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
-						// as long as the bandwidth is smaller than our fft resolution, we interpolate the points
-						// otherwise, break out and sample the max values of the bins inside the bandwidth
-						if (bwForLine > fftBandwidth)
-							break;
-						// +0.5 to centerly space bins.
-						auto index = Math::confineTo((std::size_t)(mappedFrequencies[x] * freqToBin + 0.5), 0, numBins);
-						csp[x] = invSize * csf[index];
-					}
-					break;
-				case SpectrumContent::BinInterpolation::Linear:
-					for (x = 0; x < numPoints - 1; ++x)
-					{
-						double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
-						if (bwForLine > fftBandwidth)
-							break;
-
-						csp[x] = invSize * dsp::linearFilter<std::complex<ftype>>(csf, N, mappedFrequencies[x] * freqToBin);
-					}
-					break;
-				case SpectrumContent::BinInterpolation::Lanczos:
-					for (x = 0; x < numPoints - 1; ++x)
-					{
-
-						double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
-						if (bwForLine > fftBandwidth)
-							break;
-
-						csp[x] = invSize * dsp::lanczosFilter<std::complex<ftype>, true>(csf, N, mappedFrequencies[x] * freqToBin, lanczosFilterSize);
-					}
-					break;
-				default:
-					break;
-				}
-
-				oldBin = mappedFrequencies[x] * freqToBin;
-
-				for (; x < numPoints; ++x)
-				{
-					maxLMag = maxRMag = newLMag = newRMag = 0;
-
-					bin = static_cast<std::size_t>(mappedFrequencies[x] * freqToBin);
-#ifdef DEBUG
-					if ((std::size_t)bin > getNumAudioElements < std::complex < ftype >> ())
-						CPL_RUNTIME_EXCEPTION("Corrupt frequency mapping!");
-#endif
-					maxRBin = maxLBin = bin;
-
-					auto diff = bin - oldBin;
-					auto counter = diff ? 1 : 0;
-					// here we loop over all the bins that is mapped for a single coordinate
-					do
-					{
-						auto offset = oldBin + counter;
-						newLMag = Math::square(csf[offset]);
-						// select highest number in this chunk for display. Not exactly correct, though.
-						if (newLMag > maxLMag)
-						{
-							maxLBin = oldBin + counter;
-							maxLMag = newLMag;
-						}
-						counter++;
-						diff--;
-					} while (diff > 0);
-
-					csp[x] = invSize * csf[maxLBin];
-
-					oldBin = bin;
-				}
-
-				break;
-			}
-			case SpectrumChannels::Phase:
-			{
-				// two-for-one pass, first channel is 0... N/2 -1, second is N/2 .. N -1
-				dsp::separateTransformsIPL(csf, N);
-
-				// fix up DC and nyquist bins (see previous function documentation)
-				csf[N] = csf[0].imag() * 0.5;
-				csf[0] = csf[0].real() * 0.5;
-				csf[N >> 1] *= 0.5;
-				csf[(N >> 1) - 1] *= 0.5;
-
-				// TODO: rewrite this.
-				// firstly, we have to do a phase cancellation pass.
-				// this is because magnitude interpolation is wrong for
-				// complex vectors, it needs to be done on magnitude.
-				// however, phase calculation needs to be done on vectors.
-				// so we first do a phase cancellation pass, and afterwards
-				// absolute the lower bottom of the transform, that needs to be interpolated.
-
-				// The index of the transform, where the bandwidth is higher than mapped pixels (so no more interpolation is needed)
-				// TODO: This can be calculated from view mapping scale and N pixels.
-				std::size_t bandWidthBreakingPoint = numPoints;
-
-				double fftBandwidth = 1.0 / numBins;
-				//double pxlBandwidth = 1.0 / numPoints;
-				cpl::Types::fint_t x = 0;
-				switch (state.binPolation)
-				{
-				case SpectrumContent::BinInterpolation::Linear:
-				{
-					// phase pass
+				case SpectrumContent::BinInterpolation::Linear:
+				{
+					// phase pass
 					for (x = 0; x < numPoints - 1; ++x)
 					{
 						double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
@@ -1120,120 +1355,8 @@ namespace Signalizer
 					csf[i] = std::abs(csf[i]);
 				}
 
-				// The index of the transform, where the bandwidth is higher than mapped pixels (so no more interpolation is needed)
-				// TODO: This can be calculated from view mapping scale and N pixels.
-				std::size_t bandWidthBreakingPoint = numPoints - 1;
-
-				double fftBandwidth = 1.0 / numBins;
-				//double pxlBandwidth = 1.0 / numPoints;
-				cpl::Types::fint_t x;
-				switch (state.binPolation)
-				{
-				case SpectrumContent::BinInterpolation::Linear:
-
-					// phase pass
-					for (x = 0; x < numPoints - 1; ++x)
-					{
-						double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
-						if (bwForLine > fftBandwidth)
-						{
-							bandWidthBreakingPoint = x;
-							break;
-						}
-
-						auto iLeft = dsp::linearFilter<std::complex<ftype>>(csf, N + 1, mappedFrequencies[x] * freqToBin);
-						auto iRight = dsp::linearFilter<std::complex<ftype>>(csf, N + 1, N - (mappedFrequencies[x] * freqToBin));
-
-						csp[x] = invSize * iLeft;
-						csp[numFilters + x] = invSize * iRight;
-					}
-
-					break;
-				case SpectrumContent::BinInterpolation::Lanczos:
-					for (x = 0; x < numPoints - 1; ++x)
-					{
-
-						double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
-						if (bwForLine > fftBandwidth)
-						{
-							bandWidthBreakingPoint = x;
-							break;
-						}
-
-						auto iLeft = dsp::lanczosFilter<std::complex<ftype>, true>(csf, N + 1, mappedFrequencies[x] * freqToBin, 5);
-						auto iRight = dsp::lanczosFilter<std::complex<ftype>, true>(csf, N + 1, N - (mappedFrequencies[x] * freqToBin), lanczosFilterSize);
-
-						csp[x] = invSize * iLeft;
-						csp[numFilters + x] = invSize * iRight;
-					}
-
-					break;
-				default:
-					for (x = 0; x < numPoints - 1; ++x)
-					{
-						// bandwidth of the filter for this 'line', or point
-						double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
-						// as long as the bandwidth is smaller than our fft resolution, we interpolate the points
-						// otherwise, break out and sample the max values of the bins inside the bandwidth
-						if (bwForLine > fftBandwidth)
-							break;
-
-						// +0.5 to centerly space bins.
-						auto index = Math::confineTo((std::size_t)(mappedFrequencies[x] * freqToBin + 0.5), 0, numBins);
-
-						csp[x] = invSize * csf[index];
-						csp[numFilters + x] = invSize * csf[N - index];
-					}
-					break;
-				}
-
-
-				// the process after interpolation is much simpler, as we dont have to account
-				// for wrongly interpolation of phase-mangled vectors.
-
-				oldBin = mappedFrequencies[x] * freqToBin;
-
-				for (; x < numPoints; ++x)
-				{
-					maxLMag = maxRMag = newLMag = newRMag = 0;
-
-					bin = static_cast<std::size_t>(mappedFrequencies[x] * freqToBin);
-#ifdef DEBUG
-					if ((std::size_t)bin > getNumAudioElements < std::complex < ftype >> ())
-						CPL_RUNTIME_EXCEPTION("Corrupt frequency mapping!");
-#endif
-					maxRBin = maxLBin = bin;
-
-					auto diff = bin - oldBin;
-					auto counter = diff ? 1 : 0;
-					// here we loop over all the bins that is mapped for a single coordinate
-					do
-					{
-						auto offset = oldBin + counter;
-						//offset <<= 1;
-						newLMag = Math::square(csf[offset]);
-						newRMag = Math::square(csf[N - offset]);
-						// select highest number in this chunk for display. Not exactly correct, though.
-						if (newLMag > maxLMag)
-						{
-							maxLBin = oldBin + counter;
-							maxLMag = newLMag;
-						}
-
-						if (newRMag > maxRMag)
-						{
-							maxRBin = N - (oldBin + counter);
-							maxRMag = newRMag;
-						}
-
-						counter++;
-						diff--;
-					} while (diff > 0);
-
-					csp[x] = invSize * csf[maxLBin];
-					csp[numFilters + x] = invSize * csf[maxRBin];
-					oldBin = bin;
-				}
+				applyBinMapping(csf, csp, invSize, 0, numPoints);
+				applyBinMapping(csf, csp + numFilters, invSize, numPoints, numPoints);
 			}
 			break;
 			case SpectrumChannels::Complex:
@@ -1242,114 +1365,38 @@ namespace Signalizer
 
 				// fix up DC and nyquist bins (see previous function documentation)
 				//csf[N] = csf[0].imag() * 0.5;
-				csf[0] *= (fftType) 0.5;
-
-				double fftBandwidth = 1.0 / (numBins * 2);
-				//double pxlBandwidth = 1.0 / numPoints;
-				cpl::Types::fint_t x = 0;
+				csf[0] *= (ftype) 0.5;
 
 				for (decltype(N) i = 1; i < N; ++i)
 				{
 					csf[i] = std::abs(csf[i]);
 				}
 
-				while(x < numPoints)
-				{
-
-					switch (state.binPolation)
-					{
-					case SpectrumContent::BinInterpolation::Linear:
-					{
-						for (; x < numPoints; ++x)
-						{
-							if (x != numPoints - 1)
-							{
-								double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
-								if (bwForLine > fftBandwidth)
-									break;
-							}
-							csp[x] = invSize * dsp::linearFilter<std::complex<ftype>>(csf, N + 1, mappedFrequencies[x] * freqToBin);
-						}
-						break;
-					}
-					case SpectrumContent::BinInterpolation::Lanczos:
-					{
-						for (; x < numPoints; ++x)
-						{
-							if (x != numPoints - 1)
-							{
-								double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
-								if (bwForLine > fftBandwidth)
-									break;
-							}
-
-							csp[x] = invSize * dsp::lanczosFilter<std::complex<ftype>, true>(csf, N + 1, mappedFrequencies[x] * freqToBin, lanczosFilterSize);
-						}
-
-						break;
-					}
-					default:
-						for (; x < numPoints; ++x)
-						{
-							if (x != numPoints - 1)
-							{
-								double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
-								if (bwForLine > fftBandwidth)
-									break;
-							}
-							// +0.5 to centerly space bins.
-							auto index = Math::confineTo((std::size_t)(mappedFrequencies[x] * freqToBin + 0.5), 0, N);
-							csp[x] = invSize * csf[index];
-						}
-						break;
-					}
-					if(x != numPoints)
-						oldBin = mappedFrequencies[x] * freqToBin;
-
-					for (; x < numPoints ; ++x)
-					{
-						maxLMag = maxRMag = newLMag = newRMag = 0;
+				applyBinMapping(csf, csp, invSize, 0, numPoints);
+			}
 
-						bin = static_cast<std::size_t>(mappedFrequencies[x] * freqToBin);
-	#ifdef DEBUG
-						if ((std::size_t)bin > getNumAudioElements < std::complex < ftype >> ())
-							CPL_RUNTIME_EXCEPTION("Corrupt frequency mapping!");
-	#endif
-						maxRBin = maxLBin = bin;
-						if (x != numPoints - 1)
-						{
-							double bwForLine = (mappedFrequencies[x + 1] - mappedFrequencies[x]) / topFrequency;
-							if (bwForLine < fftBandwidth)
-								break;
-						}
+			break;
+			}
+		}
 
-						auto diff = bin - oldBin;
-						auto counter = diff ? 1 : 0;
-						// here we loop over all the bins that is mapped for a single coordinate
-						do
-						{
-							auto offset = oldBin + counter;
-							//offset <<= 1;
-							newLMag = Math::square(csf[offset]);
-							// select highest number in this chunk for display. Not exactly correct, though.
-							if (newLMag > maxLMag)
-							{
-								maxLBin = oldBin + counter;
-								maxLMag = newLMag;
-							}
+	std::size_t Spectrum::mapToLinearSpace()
+	{
+		CPL_RUNTIME_ASSERTION(audioResource.refCountForThisThread() > 0 && "Thread processing audio transforms doesn't own lock");
+		SIGNALIZER_TRACE_ZONE("Spectrum::mapToLinearSpace");
 
-							counter++;
-							diff--;
-						} while (diff > 0);
+		using namespace cpl;
+		std::size_t numPoints = getAxisPoints();
 
-						csp[x] = invSize * csf[maxLBin];
-						oldBin = bin;
-					}
-				}
-			}
+		std::size_t numFilters = getNumFilters();
 
-			break;
-			}
+		switch (state.algo.load(std::memory_order_acquire))
+		{
+		case SpectrumContent::TransformAlgorithm::FFT:
+		{
+			if (state.precision == SpectrumContent::TransformPrecision::Single)
+				mapFFTToLinearSpace<float>(numPoints, numFilters);
+			else
+				mapFFTToLinearSpace<double>(numPoints, numFilters);
 			break;
 		}
 		case SpectrumContent::TransformAlgorithm::RSNT:
@@ -1395,51 +1442,15 @@ namespace Signalizer
 	}
 
 
-	bool Spectrum::processNextSpectrumFrame()
+	bool Spectrum::onAsyncAudio(const AudioStream & source, AudioStream::DataType ** buffer, std::size_t numChannels, std::size_t numSamples)
 	{
-		SFrameBuffer::FrameVector * next;
-		if (sfbuf.frameQueue.popElement(next))
-		{
-			SFrameBuffer::FrameVector & curFrame(*next);
-
-			std::size_t numFilters = getNumFilters();
-
-			// the size will be zero for a couple of frames, if there's some messing around with window sizes
-			// or we get audio running before anything is actually initiated.
-			if (curFrame.size() != 0)
-			{
-				if (curFrame.size() == numFilters)
-				{
-					postProcessTransform(reinterpret_cast<fpoint*>(curFrame.data()), numFilters);
-				}
-				else
-				{
-					// linearly interpolate bins. if we win the cpu-lottery one day, change this to sinc.
-					std::vector<std::complex<fpoint>> tempSpace(numFilters);
-
-					// interpolation factor.
-					fpoint wspToNext = (curFrame.size() - 1) / fpoint(std::max<std::size_t>(1, numFilters));
-
-					for (std::size_t n = 0; n < numFilters; ++n)
-					{
-						auto y2 = n * wspToNext;
-						auto x = static_cast<std::size_t>(y2);
-						auto yFrac = y2 - x;
-						tempSpace[n] = curFrame[x] * (fpoint(1) - yFrac) + curFrame[x + 1] * yFrac;
-					}
-					postProcessTransform(reinterpret_cast<fpoint *>(tempSpace.data()), numFilters);
-				}
-			}
+		SIGNALIZER_TRACE_THREAD("Async audio");
+		SIGNALIZER_TRACE_ZONE("Spectrum::onAsyncAudio");
 
-#pragma message cwarn("OPERATOR DELETE OMG!!")
-			delete next;
-			return true;
-		}
-		return false;
-	}
+	#ifdef DEBUG
+		CPL_RUNTIME_ASSERTION(content->systemView.getBlockTimeline().hasStamped(audioStream.getASyncPlayhead().getSteadyClock() + numSamples) && "Block timeline doesn't follow the steady clock of the stream");
+	#endif
 
-	bool Spectrum::onAsyncAudio(const AudioStream & source, AudioStream::DataType ** buffer, std::size_t numChannels, std::size_t numSamples)
-	{
 		if (state.isSuspended && globalBehaviour.stopProcessingOnSuspend.load(std::memory_order_relaxed))
 			return false;
 
@@ -1449,29 +1460,54 @@ namespace Signalizer
 	}
 
 	template<typename ISA>
-	void Spectrum::addAudioFrame()
+	void Spectrum::addAudioFrame(std::uint64_t clock)
 	{
 		CPL_RUNTIME_ASSERTION(audioResource.refCountForThisThread() > 0 && "Thread processing audio transforms doesn't own lock");
+		SIGNALIZER_TRACE_ZONE("Spectrum::addAudioFrame");
 
 		auto filters = mapToLinearSpace();
 
-		if (state.algo.load(std::memory_order_acquire) == SpectrumContent::TransformAlgorithm::RSNT)
-		{
-			auto & frame = *(new SFrameBuffer::FrameVector(getWorkingMemory<std::complex<fpoint>>(), getWorkingMemory<std::complex<fpoint>>() + filters /* channels ? */));
-			sfbuf.frameQueue.pushElement<true>(&frame);
-		}
-		else if (state.algo.load(std::memory_order_acquire) == SpectrumContent::TransformAlgorithm::FFT)
+		const auto algo = state.algo.load(std::memory_order_acquire);
+
+		if (algo != SpectrumContent::TransformAlgorithm::RSNT && algo != SpectrumContent::TransformAlgorithm::FFT)
+			return;
+
+		auto next = sfbuf.acquireFrame();
+
+		// the rendering thread hasn't caught up - drop this frame instead of allocating new ones.
+		if (!next)
+			return;
+
+		auto & frame = *next;
+		// frames are allocated with room for the current amount of filters, so this won't allocate.
+		frame.resize(std::min(filters, frame.capacity()));
+
+		if (algo == SpectrumContent::TransformAlgorithm::RSNT)
 		{
-			auto & frame = *(new SFrameBuffer::FrameVector(filters));
-			auto wsp = getWorkingMemory<std::complex<fftType>>();
+			auto wsp = getWorkingMemory<std::complex<fpoint>>();
 			for (std::size_t i = 0; i < frame.size(); ++i)
 			{
-				frame[i].real = (fpoint)wsp[i].real();
-				frame[i].imag = (fpoint)wsp[i].imag();
+				frame[i] = wsp[i];
 			}
-			sfbuf.frameQueue.pushElement<true>(&frame);
+		}
+		else
+		{
+			auto copyFrame = [&](auto * wsp)
+			{
+				for (std::size_t i = 0; i < frame.size(); ++i)
+				{
+					frame[i].real = (fpoint)wsp[i].real();
+					frame[i].imag = (fpoint)wsp[i].imag();
+				}
+			};
 
+			if (state.precision == SpectrumContent::TransformPrecision::Single)
+				copyFrame(getWorkingMemory<std::complex<float>>());
+			else
+				copyFrame(getWorkingMemory<std::complex<fftType>>());
 		}
+
+		sfbuf.pushFrame(&frame, clock);
 	}
 
 
@@ -1492,74 +1528,75 @@ namespace Signalizer
 	template<typename ISA>
 		void Spectrum::audioProcessing(float ** buffer, std::size_t numChannels, std::size_t numSamples)
 		{
-			cpl::CMutex audioLock;
+			MeasuredMutex audioLock(LockStatistics::Owner::AsyncAudio);
 
-			if (state.displayMode == SpectrumContent::DisplayMode::ColourSpectrum)
-			{
+			std::int64_t n = numSamples;
+			std::size_t offset = 0;
+			const auto blockClock = audioStream.getASyncPlayhead().getSteadyClock();
 
-				std::int64_t n = numSamples;
-				std::size_t offset = 0;
+			while (n > 0)
+			{
+				std::int64_t numRemainingSamples = sfbuf.sampleBufferSize - sfbuf.currentCounter;
+				const auto availableSamples = numRemainingSamples + std::min(std::int64_t(0), n - numRemainingSamples);
 
-				while (n > 0)
+				// do some resonation
+				if (state.algo.load(std::memory_order_acquire) == SpectrumContent::TransformAlgorithm::RSNT)
 				{
-					std::int64_t numRemainingSamples = sfbuf.sampleBufferSize - sfbuf.currentCounter;
-					const auto availableSamples = numRemainingSamples + std::min(std::int64_t(0), n - numRemainingSamples);
-
-					// do some resonation
-					if (state.algo.load(std::memory_order_acquire) == SpectrumContent::TransformAlgorithm::RSNT)
-					{
-						audioLock.acquire(audioResource);
-						fpoint * offBuf[2] = { buffer[0] + offset, buffer[1] + offset };
-						resonatingDispatch<ISA>(offBuf, numChannels, availableSamples);
-					}
+					audioLock.acquire(audioResource);
+					fpoint * offBuf[2] = { buffer[0] + offset, buffer[1] + offset };
+					resonatingDispatch<ISA>(offBuf, numChannels, availableSamples);
+				}
 
-					sfbuf.currentCounter += availableSamples;
+				sfbuf.currentCounter += availableSamples;
 
-					if (sfbuf.currentCounter >= (sfbuf.sampleBufferSize))
+				if (sfbuf.currentCounter >= (sfbuf.sampleBufferSize))
+				{
+					audioLock.acquire(audioResource);
+					bool transformReady = true;
+					if (state.algo.load(std::memory_order_acquire) == SpectrumContent::TransformAlgorithm::FFT)
 					{
-						audioLock.acquire(audioResource);
-						bool transformReady = true;
-						if (state.algo.load(std::memory_order_acquire) == SpectrumContent::TransformAlgorithm::FFT)
+						fpoint * offBuf[2] = { buffer[0], buffer[1]};
+						if (audioStream.getNumDeferredSamples() == 0)
 						{
-							fpoint * offBuf[2] = { buffer[0], buffer[1]};
-							if (audioStream.getNumDeferredSamples() == 0)
-							{
-								// the abstract timeline consists of the old data in the audio stream, with the following audio presented in this function.
-								// thus, the more we include of the buffer ('offbuf') the newer the data segment gets.
-								if((transformReady = prepareTransform(audioStream.getAudioBufferViews(), offBuf, numChannels, availableSamples + offset)))
-									doTransform();
-							}
-							else
-							{
-								// ignore the deferred samples and produce some views that is slightly out-of-date.
-								// this ONLY happens if something else is hogging the buffers.
-								if((transformReady = prepareTransform(audioStream.getAudioBufferViews())))
-									doTransform();
-							}
+							// the abstract timeline consists of the old data in the audio stream, with the following audio presented in this function.
+							// thus, the more we include of the buffer ('offbuf') the newer the data segment gets.
+							if((transformReady = prepareTransform(audioStream.getAudioBufferViews(), offBuf, numChannels, availableSamples + offset)))
+								doTransform<ISA>();
 						}
+						else
+						{
+							// ignore the deferred samples and produce some views that is slightly out-of-date.
+							// this ONLY happens if something else is hogging the buffers.
+							deferredFallbacks.fetch_add(1, std::memory_order_relaxed);
+							if((transformReady = prepareTransform(audioStream.getAudioBufferViews())))
+								doTransform<ISA>();
+						}
+					}
 
-						if(transformReady)
-							addAudioFrame<ISA>();
-
-						sfbuf.currentCounter = 0;
+					// the display mode is only switched while holding the audio lock, so it is safe to read here.
+					if (transformReady)
+					{
+						const auto clock = blockClock + offset + availableSamples;
 
-						// change this here. oh really?
-						sfbuf.sampleBufferSize = getBlobSamples();
+						if (state.displayMode == SpectrumContent::DisplayMode::ColourSpectrum)
+							addAudioFrame<ISA>(clock);
+						else
+							addLineGraphFrame<ISA>(clock);
 					}
 
-					offset += availableSamples;
-					n -= availableSamples;
-				}
+					sfbuf.currentCounter = 0;
 
+					// change this here. oh really?
+					sfbuf.sampleBufferSize = getBlobSamples();
+				}
 
-				sfbuf.sampleCounter += numSamples;
-			}
-			else if(state.algo.load(std::memory_order_acquire) == SpectrumContent::TransformAlgorithm::RSNT)
-			{
-				audioLock.acquire(audioResource);
-				resonatingDispatch<ISA>(buffer, numChannels, numSamples);
+				offset += availableSamples;
+				n -= availableSamples;
 			}
 
+
+			sfbuf.sampleCounter += numSamples;
+
 			return;
 		}
 
@@ -1568,6 +1605,7 @@ namespace Signalizer
 	void Spectrum::resonatingDispatch(fpoint ** buffer, std::size_t numChannels, std::size_t numSamples)
 	{
 		CPL_RUNTIME_ASSERTION(audioResource.refCountForThisThread() > 0 && "Thread processing audio transforms doesn't own lock");
+		SIGNALIZER_TRACE_ZONE("Spectrum::resonatingDispatch");
 
 		// TODO: asserts?
 		if (numChannels > 2)
@@ -1676,6 +1714,30 @@ namespace Signalizer
 		return sfbuf.frameQueue.enqueuededElements();
 	}
 
+	void Spectrum::updateLineGraphFilters(fpoint updateRate)
+	{
+		for (std::size_t i = 0; i < SpectrumContent::LineGraphs::LineEnd; ++i)
+		{
+			lineGraphs[i].filter.setDecayAsFraction(lineGraphs[i].decay.load(std::memory_order_relaxed), 0.1);
+			lineGraphs[i].filter.setSampleRate(updateRate);
+		}
+	}
+
+	Spectrum::Statistics Spectrum::getStatistics() const noexcept
+	{
+		Statistics s;
+
+		for (std::size_t i = 0; i < static_cast<std::size_t>(LockStatistics::Owner::End); ++i)
+			s.audioResource[i] = audioResource.statistics.get(static_cast<LockStatistics::Owner>(i));
+
+		s.deferredFallbacks = deferredFallbacks.load(std::memory_order_relaxed);
+		s.droppedAudioFrames = sfbuf.droppedFrames.load(std::memory_order_relaxed);
+		s.queueDepth = sfbuf.frameQueue.enqueuededElements();
+		s.maxQueueDepth = sfbuf.maxQueueDepth.load(std::memory_order_relaxed);
+
+		return s;
+	}
+
 	int Spectrum::getNumFilters() const noexcept
 	{
 		return getAxisPoints();
@@ -1738,4 +1800,133 @@ namespace Signalizer
 		}
 		return ret;
 	}
+
+#ifdef SIGNALIZER_BENCHMARKS
+	void Spectrum::runBenchmarks(Benchmark & suite)
+	{
+		typedef SpectrumContent::TransformPrecision Precision;
+		typedef SpectrumContent::BinInterpolation BinInterpolation;
+
+		static const char * channelNames[] = { "left", "right", "mid", "side", "phase", "separate", "mid+side", "complex" };
+		static const char * precisionNames[] = { "double", "single" };
+		static const char * interpolationNames[] = { "none", "linear", "lanczos" };
+
+		auto set = [](ChoiceParameter & choice, auto value)
+		{
+			choice.param.setTransformedValue(static_cast<double>(value));
+		};
+
+		const auto & options = suite.getOptions();
+		AFloat * block[2] = { suite.getTestChannel(0), suite.getTestChannel(1) };
+		const auto numChannels = static_cast<std::size_t>(SpectrumChannels::End);
+
+		// the line graph mode post processes the transforms on the audio thread, like measured here.
+		set(content->displayMode, SpectrumContent::DisplayMode::LineGraph);
+		set(content->algorithm, SpectrumContent::TransformAlgorithm::FFT);
+		handleFlagUpdates();
+
+		for (std::size_t w = 0; w < options.windowSizes.size(); ++w)
+		{
+			// resizes the audio history, which is completed by the audio stream
+			setWindowSize(options.windowSizes[w]);
+			handleFlagUpdates();
+			suite.settle();
+			handleFlagUpdates();
+
+			const auto windowSize = getWindowSize();
+			const auto sizeName = ", N = " + std::to_string(windowSize);
+
+			for (auto precision : { Precision::Single, Precision::Double })
+			{
+				for (std::size_t c = 0; c < numChannels; ++c)
+				{
+					const std::string variant = std::string(channelNames[c]) + ", " + precisionNames[static_cast<int>(precision)] + sizeName;
+
+					set(content->precision, precision);
+					set(content->channelConfiguration, c);
+					handleFlagUpdates();
+
+					{
+						MeasuredMutex lock(audioResource, LockStatistics::Owner::Rendering);
+						auto && audio = audioStream.getAudioBufferViews();
+
+						suite.measure("prepareTransform", variant, "none", windowSize, [&] { prepareTransform(audio); });
+
+						// transforms are in-place, so every transform restores the prepared input first.
+						prepareTransform(audio);
+						const std::vector<char> prepared(audioMemory.begin(), audioMemory.end());
+
+						auto restore = [&] { std::memcpy(audioMemory.data(), prepared.data(), prepared.size()); };
+
+						if (precision == Precision::Single)
+						{
+							Benchmark::forEachISA(
+								[&](auto isa, const char * isaName)
+								{
+									typedef decltype(isa) ISA;
+									suite.measure("doTransform", variant, isaName, windowSize, [&] { restore(); doTransform<ISA>(); });
+								}
+							);
+						}
+						else
+						{
+							// double precision transforms aren't dispatched
+							suite.measure("doTransform", variant, "none", windowSize, [&] { restore(); doTransform<Benchmark::ForcedISA<float>>(); });
+						}
+					}
+
+					for (std::size_t i = 0; i < 3; ++i)
+					{
+						set(content->binInterpolation, i);
+						handleFlagUpdates();
+
+						MeasuredMutex lock(audioResource, LockStatistics::Owner::Rendering);
+
+						if (prepareTransform(audioStream.getAudioBufferViews()))
+							doTransform<Benchmark::ForcedISA<float>>();
+
+						suite.measure("mapToLinearSpace", variant + ", " + interpolationNames[i], "none", windowSize, [&] { mapToLinearSpace(); });
+
+						// the post processing is independent of the transform size and precision
+						if (w != 0 || precision != Precision::Single || i != 0)
+							continue;
+
+						Benchmark::forEachISA(
+							[&](auto isa, const char * isaName)
+							{
+								typedef decltype(isa) ISA;
+								suite.measure("mapAndTransformDFTFilters", channelNames[c], isaName, getNumFilters(), [&] { postProcessStdTransform<ISA>(); });
+							}
+						);
+					}
+				}
+			}
+
+			if (w != 0 || !(suite.isSelected("resonateReal") || suite.isSelected("resonateComplex")))
+				continue;
+
+			set(content->algorithm, SpectrumContent::TransformAlgorithm::RSNT);
+
+			for (std::size_t c = 0; c < numChannels; ++c)
+			{
+				set(content->channelConfiguration, c);
+				handleFlagUpdates();
+
+				MeasuredMutex lock(audioResource, LockStatistics::Owner::Rendering);
+				const auto kernel = c == static_cast<std::size_t>(SpectrumChannels::Complex) ? "resonateComplex" : "resonateReal";
+
+				Benchmark::forEachISA(
+					[&](auto isa, const char * isaName)
+					{
+						typedef decltype(isa) ISA;
+						suite.measure(kernel, channelNames[c] + sizeName, isaName, options.blockSize, [&] { resonatingDispatch<ISA>(block, 2, options.blockSize); });
+					}
+				);
+			}
+
+			set(content->algorithm, SpectrumContent::TransformAlgorithm::FFT);
+			handleFlagUpdates();
+		}
+	}
+#endif
 };
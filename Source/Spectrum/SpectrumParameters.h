@@ -64,6 +64,16 @@
 				FFT, RSNT
 			};
 
+			enum class TransformPrecision
+			{
+				Double, Single
+			};
+
+			enum class ColourMapping
+			{
+				Processor, GraphicsCard
+			};
+
 			enum class ViewScaling
 			{
 				Linear,
@@ -88,6 +98,9 @@
 					
 					, kviewScaling(&parentValue.viewScaling.param)
 					, kalgorithm(&parentValue.algorithm.param)
+					, kprecision(&parentValue.precision.param)
+					, kcolourMapping(&parentValue.colourMapping.param)
+					, kresonatorThreads(&parentValue.resonatorThreads.param)
 					, kchannelConfiguration(&parentValue.channelConfiguration.param)
 					, kdisplayMode(&parentValue.displayMode.param)
 					, kbinInterpolation(&parentValue.binInterpolation.param)
@@ -224,6 +237,9 @@
 					// ------ titles -----------
 					kviewScaling.bSetTitle("Graph scale");
 					kalgorithm.bSetTitle("Transform algorithm");
+					kprecision.bSetTitle("Precision");
+					kcolourMapping.bSetTitle("Colour mapping");
+					kresonatorThreads.bSetTitle("Resonator threads");
 					kchannelConfiguration.bSetTitle("Channel conf.");
 					kdisplayMode.bSetTitle("Display mode");
 					kfrequencyTracker.bSetTitle("Frequency tracking");
@@ -250,6 +266,9 @@
 					// ------ descriptions -----
 					kviewScaling.bSetDescription("Set the scale of the frequency-axis of the coordinate system.");
 					kalgorithm.bSetDescription("Select the algorithm used for transforming the incoming audio data.");
+					kprecision.bSetDescription("Select the floating point precision of fourier transforms; single precision is faster, and precise enough for most purposes.");
+					kresonatorThreads.bSetDescription("The amount of threads the resonator transform is split across; more threads allow for higher resolutions at the cost of overall processor load.");
+					kcolourMapping.bSetDescription("Select where the colour spectrum is coloured; on the graphics card, changes to the dynamic range and the gradient also apply to the existing history.");
 					kchannelConfiguration.bSetDescription("Select how the audio channels are interpreted.");
 					kdisplayMode.bSetDescription("Select how the information is displayed; line graphs are updated each frame while the colour spectrum maintains the previous history.");
 					kbinInterpolation.bSetDescription("Choice of interpolation for transform algorithms that produce a discrete set of values instead of an continuous function.");
@@ -260,7 +279,7 @@
 					kgridColour.bSetDescription("The colour of the dB/frequency grid.");
 					kbackgroundColour.bSetDescription("The colour of the background.");
 					kpctForDivision.bSetDescription("The minimum amount of free space that triggers a recursed frequency grid division; smaller values draw more frequency divisions.");
-					kblobSize.bSetDescription("Controls how much audio data a horizontal unit represents; effectively controls the update rate of the colour spectrum.");
+					kblobSize.bSetDescription("Controls how much audio data a horizontal unit represents; effectively controls the update rate of the colour spectrum and the line graphs.");
 					kframeUpdateSmoothing.bSetDescription("Reduces jitter in spectrum updates at the (possible) expense of higher graphical latency.");
 					kfreeQ.bSetDescription("Frees the quality factor from being bounded by the window size for transforms that support it. "
 						"Although it (possibly) makes response time slower, it also makes the time/frequency resolution exact, and is a choice for analyzing static material.");
@@ -304,6 +323,7 @@
 							section->addControl(&kchannelConfiguration, 0);
 							section->addControl(&kdisplayMode, 1);
 							section->addControl(&kfrequencyTracker, 1);
+							section->addControl(&kcolourMapping, 0);
 							page->addSection(section);
 						}
 						if (auto section = new Signalizer::CContentPage::MatrixSection())
@@ -331,6 +351,7 @@
 						{
 							section->addControl(&kalgorithm, 0);
 							section->addControl(&kbinInterpolation, 1);
+							section->addControl(&kprecision, 0);
 							page->addSection(section);
 						}
 						if (auto section = new Signalizer::CContentPage::MatrixSection())
@@ -348,6 +369,7 @@
 						if (auto section = new Signalizer::CContentPage::MatrixSection())
 						{
 							section->addControl(&kfreeQ, 0);
+							section->addControl(&kresonatorThreads, 1);
 							page->addSection(section);
 						}
 
@@ -448,6 +470,9 @@
 					archive << kreferenceTuning;
 					archive << ktrackerSmoothing;
 					archive << ktrackerColour;
+					archive << kprecision;
+					archive << kcolourMapping;
+					archive << kresonatorThreads;
 				}
 
 				void deserializeEditorSettings(cpl::CSerializer::Archiver & builder, cpl::Version version)
@@ -512,6 +537,13 @@
 					{
 						builder >> ktrackerSmoothing >> ktrackerColour;
 					}
+
+					if (version >= cpl::Version(0, 3, 3))
+					{
+						builder >> kprecision;
+						builder >> kcolourMapping;
+						builder >> kresonatorThreads;
+					}
 				}
 
 				// entrypoints for completely storing values and settings in independant blobs (the preset widget)
@@ -550,6 +582,9 @@
 				cpl::CValueComboBox
 					kviewScaling,
 					kalgorithm,
+					kprecision,
+					kcolourMapping,
+					kresonatorThreads,
 					kchannelConfiguration,
 					kdisplayMode,
 					kbinInterpolation,
@@ -615,6 +650,9 @@
 
 				, viewScaling("VScale")
 				, algorithm("Algo")
+				, precision("Precision")
+				, colourMapping("ClrMap")
+				, resonatorThreads("RsnThreads")
 				, channelConfiguration("ChConf")
 				, displayMode("DispMode")
 				, binInterpolation("BinInt")
@@ -662,6 +700,9 @@
 
 				viewScaling.fmt.setValues({ "Linear", "Logarithmic" });
 				algorithm.fmt.setValues({ "FFT", "Resonator" });
+				precision.fmt.setValues({ "Double", "Single" });
+				colourMapping.fmt.setValues({ "Processor", "Graphics card" });
+				resonatorThreads.fmt.setValues({ "1", "2", "4", "8" });
 				channelConfiguration.fmt.setValues({ "Left", "Right", "Mid/Merge", "Side", "Phase", "Separate", "Mid+Side", "Complex" });
 				displayMode.fmt.setValues({ "Line graph", "Colour spectrum" });
 				binInterpolation.fmt.setValues({ "None", "Linear", "Lanczos" });
@@ -690,7 +731,7 @@
 					parameterSet.registerSingleParameter(sparam->generateUpdateRegistrator());
 				}
 
-				for (auto sparam : { &viewScaling, &algorithm, &channelConfiguration, &displayMode, &binInterpolation, &frequencyTracker })
+				for (auto sparam : { &viewScaling, &algorithm, &channelConfiguration, &displayMode, &binInterpolation, &frequencyTracker, &precision, &colourMapping, &resonatorThreads })
 				{
 					parameterSet.registerSingleParameter(sparam->param.generateUpdateRegistrator());
 				}
@@ -777,6 +818,9 @@
 				archive << audioHistoryTransformatter;
 
 				archive << trackerSmoothing << trackerColour;
+				archive << precision.param;
+				archive << colourMapping.param;
+				archive << resonatorThreads.param;
 			}
 
 			virtual void deserialize(cpl::CSerializer::Builder & builder, cpl::Version v) override
@@ -826,6 +870,13 @@
 				{
 					builder >> trackerSmoothing >> trackerColour;
 				}
+
+				if (v >= cpl::Version(0, 3, 3))
+				{
+					builder >> precision.param;
+					builder >> colourMapping.param;
+					builder >> resonatorThreads.param;
+				}
 			}
 
 			SystemView systemView;
@@ -848,7 +899,19 @@
 				channelConfiguration,
 				displayMode,
 				binInterpolation,
-				frequencyTracker;
+				frequencyTracker,
+				/// <summary>
+				/// The floating point precision used for fourier transforms, see TransformPrecision.
+				/// </summary>
+				precision,
+				/// <summary>
+				/// Whether the colour spectrum is coloured on the CPU or in a shader, see ColourMapping.
+				/// </summary>
+				colourMapping,
+				/// <summary>
+				/// The amount of threads resonators are processed on, as a power of two.
+				/// </summary>
+				resonatorThreads;
 
 			Parameter
 				lowDbs,
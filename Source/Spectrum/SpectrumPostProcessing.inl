@@ -0,0 +1,252 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:SpectrumPostProcessing.inl
+
+		Vectorized post processing of mapped transforms (peak filters and logarithmic
+		scaling), shared between the audio and the rendering thread.
+
+*************************************************************************************/
+
+#include "Spectrum.h"
+#include <cpl/simd.h>
+
+namespace Signalizer
+{
+	template<typename ISA, class V2>
+		void Spectrum::mapAndTransformDFTFilters(SpectrumChannels type, const V2 & newVals, std::size_t size, double lowDbs, double highDbs, float clip)
+		{
+			typedef typename ISA::V V;
+			using namespace cpl::simd;
+
+			const std::size_t vectorLength = elements_of<V>::value;
+			// buffers are padded (see paddedFilterSize()), so it's safe to process the last partial vector.
+			const std::size_t vectorSize = (size + vectorLength - 1) & ~(vectorLength - 1);
+
+			double lowerFraction = cpl::Math::dbToFraction<double>(lowDbs);
+			double upperFraction = cpl::Math::dbToFraction<double>(highDbs);
+
+			const V vDeltaYRecip = set1<V>(static_cast<fpoint>(1.0 / std::log(upperFraction / lowerFraction)));
+			const V vMinFracRecip = set1<V>(static_cast<fpoint>(1.0 / lowerFraction));
+			const V vLowerClip = set1<V>((fpoint)clip);
+			const V vZero = zero<V>();
+
+			fpoint * const primary = primaryMagnitudes.data();
+			fpoint * const secondary = secondaryMagnitudes.data();
+			const fpoint * const slopes = slopeMap.data();
+
+			V vPoles[SpectrumContent::LineGraphs::LineEnd];
+
+			for (std::size_t k = 0; k < lineGraphs.size(); ++k)
+				vPoles[k] = set1<V>(lineGraphs[k].filter.pole);
+
+			// log10(y / _min) / log10(_max / _min), with non-positive values replaced by the clip
+			auto logMap = [&](V slope, V magnitude)
+			{
+				const V deltaX = slope * magnitude * vMinFracRecip;
+				// lanes with the logarithm of non-positive numbers are discarded here
+				return vselect(log(deltaX) * vDeltaYRecip, vLowerClip, (V)(deltaX > vZero));
+			};
+
+			// decays the stored peak, and replaces it with the magnitude if it is larger
+			auto peakDecay = [&](fpoint * states, std::size_t k, V magnitude)
+			{
+				const V peak = max(load<V>(states) * vPoles[k], magnitude);
+				*reinterpret_cast<V *>(states) = peak;
+				return peak;
+			};
+
+			suitable_container<V> first, second;
+
+			switch (type)
+			{
+			case SpectrumChannels::Left:
+			case SpectrumChannels::Merge:
+			case SpectrumChannels::Right:
+			case SpectrumChannels::Side:
+			case SpectrumChannels::Complex:
+			{
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					auto newReal = newVals[i * 2];
+					auto newImag = newVals[i * 2 + 1];
+					primary[i] = static_cast<fpoint>(newReal * newReal + newImag * newImag);
+				}
+
+				for (std::size_t i = 0; i < vectorSize; i += vectorLength)
+				{
+					// mag = abs(cmplx)
+					const V magnitude = sqrt(load<V>(primary + i));
+					const V slope = load<V>(slopes + i);
+					const auto count = std::min(vectorLength, size - i);
+
+					for (std::size_t k = 0; k < lineGraphs.size(); ++k)
+					{
+						first = logMap(slope, peakDecay(lineGraphs[k].primaryStates.data() + i, k, magnitude));
+
+						auto results = lineGraphs[k].results.data() + i;
+						for (std::size_t n = 0; n < count; ++n)
+						{
+							results[n].magnitude = first[n];
+							results[n].phase = 0;
+						}
+					}
+				}
+
+				break;
+			}
+			case SpectrumChannels::Separate:
+			case SpectrumChannels::MidSide:
+			{
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					auto lreal = newVals[i * 2];
+					auto rreal = newVals[i * 2 + size * 2];
+					auto limag = newVals[i * 2 + 1];
+					auto rimag = newVals[i * 2 + size * 2 + 1];
+
+					primary[i] = static_cast<fpoint>(lreal * lreal + limag * limag);
+					secondary[i] = static_cast<fpoint>(rreal * rreal + rimag * rimag);
+				}
+
+				for (std::size_t i = 0; i < vectorSize; i += vectorLength)
+				{
+					const V lmag = sqrt(load<V>(primary + i));
+					const V rmag = sqrt(load<V>(secondary + i));
+					const V slope = load<V>(slopes + i);
+					const auto count = std::min(vectorLength, size - i);
+
+					for (std::size_t k = 0; k < lineGraphs.size(); ++k)
+					{
+						first = logMap(slope, peakDecay(lineGraphs[k].primaryStates.data() + i, k, lmag));
+						second = logMap(slope, peakDecay(lineGraphs[k].secondaryStates.data() + i, k, rmag));
+
+						auto results = lineGraphs[k].results.data() + i;
+						for (std::size_t n = 0; n < count; ++n)
+						{
+							results[n].leftMagnitude = first[n];
+							results[n].rightMagnitude = second[n];
+						}
+					}
+				}
+
+				break;
+			}
+			case SpectrumChannels::Phase:
+			{
+				V vPhaseFilters[SpectrumContent::LineGraphs::LineEnd];
+
+				for (std::size_t k = 0; k < lineGraphs.size(); ++k)
+					vPhaseFilters[k] = set1<V>(static_cast<fpoint>(std::pow(lineGraphs[k].filter.pole, 0.3)));
+
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					primary[i] = static_cast<fpoint>(newVals[i * 2] * 0.5);
+					secondary[i] = static_cast<fpoint>(newVals[i * 2 + 1]);
+				}
+
+				for (std::size_t i = 0; i < vectorSize; i += vectorLength)
+				{
+					const V mag = load<V>(primary + i);
+					V phase = load<V>(secondary + i);
+					const V slope = load<V>(slopes + i);
+					const auto count = std::min(vectorLength, size - i);
+
+					for (std::size_t k = 0; k < lineGraphs.size(); ++k)
+					{
+						const V peak = peakDecay(lineGraphs[k].primaryStates.data() + i, k, mag);
+
+						phase = phase * mag;
+
+						auto phaseStates = lineGraphs[k].secondaryStates.data() + i;
+						const V filteredPhase = phase + vPhaseFilters[k] * (load<V>(phaseStates) - phase);
+						*reinterpret_cast<V *>(phaseStates) = filteredPhase;
+
+						first = logMap(slope, peak);
+						second = logMap(slope, filteredPhase);
+
+						auto results = lineGraphs[k].results.data() + i;
+						for (std::size_t n = 0; n < count; ++n)
+						{
+							results[n].magnitude = first[n];
+							results[n].phase = second[n];
+						}
+					}
+				}
+				break;
+			}
+			};
+		}
+
+	template<typename ISA, class InVector>
+		void Spectrum::postProcessTransform(const InVector & transform, std::size_t size)
+		{
+			if (size > (std::size_t)getNumFilters())
+				CPL_RUNTIME_EXCEPTION("Incompatible incoming transform size.");
+			mapAndTransformDFTFilters<ISA>(state.configuration, transform, size, content->lowDbs.getTransformedValue(), content->highDbs.getTransformedValue(), content->lowDbs.getTransformer().transform(0));
+		}
+
+	template<typename ISA>
+		bool Spectrum::processNextSpectrumFrame()
+		{
+			SFrameBuffer::FrameVector * next;
+			if (sfbuf.frameQueue.popElement(next))
+			{
+				SFrameBuffer::FrameVector & curFrame(*next);
+
+				std::size_t numFilters = getNumFilters();
+
+				// the size will be zero for a couple of frames, if there's some messing around with window sizes
+				// or we get audio running before anything is actually initiated.
+				if (curFrame.size() != 0)
+				{
+					if (curFrame.size() == numFilters)
+					{
+						postProcessTransform<ISA>(reinterpret_cast<fpoint*>(curFrame.data()), numFilters);
+					}
+					else
+					{
+						// linearly interpolate bins. if we win the cpu-lottery one day, change this to sinc.
+						auto tempSpace = frameInterpolationSpace.data();
+
+						// interpolation factor.
+						fpoint wspToNext = (curFrame.size() - 1) / fpoint(std::max<std::size_t>(1, numFilters));
+
+						for (std::size_t n = 0; n < numFilters; ++n)
+						{
+							auto y2 = n * wspToNext;
+							auto x = static_cast<std::size_t>(y2);
+							auto yFrac = y2 - x;
+							tempSpace[n] = curFrame[x] * (fpoint(1) - yFrac) + curFrame[x + 1] * yFrac;
+						}
+						postProcessTransform<ISA>(reinterpret_cast<fpoint *>(tempSpace), numFilters);
+					}
+				}
+
+				drawnClock = sfbuf.getClock(next);
+				sfbuf.releaseFrame(next);
+				return true;
+			}
+			return false;
+		}
+};
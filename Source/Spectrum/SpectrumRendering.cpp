@@ -28,6 +28,7 @@
 *************************************************************************************/
 
 #include "Spectrum.h"
+#include "SpectrumPostProcessing.inl"
 #include <cstdint>
 #include <cpl/CMutex.h>
 #include <cpl/Mathext.h>
@@ -204,6 +205,20 @@ namespace Signalizer
 
 			g.drawSingleLineText(text, 10, 20);
 
+			sprintf(text, "latency: %.1f ms (p50: %.1f ms, p99: %.1f ms)", latency.getLatest(), latency.getPercentile(0.5), latency.getPercentile(0.99));
+			g.drawSingleLineText(text, 10, 40);
+
+			g.drawSingleLineText(audioResource.statistics.describe(LockStatistics::Owner::AsyncAudio), 10, 60);
+			g.drawSingleLineText(audioResource.statistics.describe(LockStatistics::Owner::Rendering), 10, 80);
+
+			const auto stats = getStatistics();
+			sprintf(text, "frames: %llu queued (max %llu), %llu dropped, %llu deferred fallbacks",
+				static_cast<unsigned long long>(stats.queueDepth),
+				static_cast<unsigned long long>(stats.maxQueueDepth),
+				static_cast<unsigned long long>(stats.droppedAudioFrames),
+				static_cast<unsigned long long>(stats.deferredFallbacks));
+			g.drawSingleLineText(text, 10, 100);
+
 		}
 	}
 
@@ -320,7 +335,7 @@ namespace Signalizer
 		mouseFraction = cpl::Math::confineTo(mouseFraction, 0, 1);
 
 		// calculate nearest peak
-		double const nearbyFractionToConsider = 0.03;
+		trackerFraction.store(mouseFraction, std::memory_order_relaxed);
 
 		auto precisionError = 0.001;
 		auto interpolationError = 0.01;
@@ -332,10 +347,10 @@ namespace Signalizer
 			if (graphN == SpectrumContent::LineGraphs::Transform)
 				graphN = SpectrumContent::LineGraphs::LineMain;
 
-			auto & results = lineGraphs[graphN].results;
+			auto & results = getLineGraphResults(graphN);
 			auto N = results.size();
 			auto pivot = cpl::Math::round<std::size_t>(N * mouseFraction);
-			auto range = cpl::Math::round<std::size_t>(N * nearbyFractionToConsider);
+			auto range = cpl::Math::round<std::size_t>(N * trackerSearchFraction);
 
 			auto lowerBound = range > pivot ? 0 : pivot - range;
 			auto higherBound = range + pivot > N ? N : range + pivot;
@@ -406,72 +421,17 @@ namespace Signalizer
 		}
 		else
 		{
-			// search the original FFT
+			// the original FFT is searched by the async audio thread, see findTrackedPeak()
 			auto N = getFFTSpace<std::complex<fftType>>();
-			auto points = getNumFilters();
-			auto lowerBound = cpl::Math::round<cpl::ssize_t>(points * (mouseFraction - nearbyFractionToConsider));
-			lowerBound = cpl::Math::round<cpl::ssize_t>((N * mappedFrequencies[cpl::Math::confineTo(lowerBound, 0, points - 1)] / sampleRate));
-			auto higherBound = cpl::Math::round<cpl::ssize_t>(points * (mouseFraction + nearbyFractionToConsider));
-			higherBound = cpl::Math::round<cpl::ssize_t>((N * mappedFrequencies[cpl::Math::confineTo(higherBound, 0, points - 1)] / sampleRate));
-
-			lowerBound = cpl::Math::confineTo(lowerBound, 0, N);
-			higherBound = cpl::Math::confineTo(higherBound, 0, N);
-
-			auto source = getAudioMemory<std::complex<fftType>>();
-
-			auto peak = std::max_element(source + lowerBound, source + higherBound + 1,
-				[](const std::complex<fftType> & left, const std::complex<fftType> & right) { return cpl::Math::square(left) < cpl::Math::square(right); });
-
-			// scan for continuously rising peaks at boundaries
-			if (peak == source + lowerBound && lowerBound != 0)
-			{
-				while (true)
-				{
-					auto nextPeak = peak - 1;
-					if (nextPeak == source)
-						break;
-					else if (cpl::Math::square(*nextPeak) < cpl::Math::square(*peak))
-						break;
-					else
-						peak = nextPeak;
-				}
-			}
-			else if (peak == source + (higherBound - 1))
-			{
-				while (true)
-				{
-					auto nextPeak = peak + 1;
-					if (nextPeak == source + N)
-						break;
-					else if (cpl::Math::square(*nextPeak) < cpl::Math::square(*peak))
-						break;
-					else
-						peak = nextPeak;
-				}
-			}
-
-			auto peakOffset = std::distance(source, peak);
-
-			auto const invSize = windowScale / (getWindowSize() * 0.5);
-
-			// interpolate using a parabolic fit
-			// https://ccrma.stanford.edu/~jos/parshl/Peak_Detection_Steps_3.html
-			// jos suggests doing the fit in logarithmic domain, it tends to create nans and infs we wouldn't have got otherwise -
-			// explaning the various isnormal() checks
-			auto alpha = 20 * std::log10(std::abs(source[peakOffset == 0 ? 0 : peakOffset - 1] * invSize));
-			auto beta = 20 * std::log10(std::abs(source[peakOffset] * invSize));
-			auto gamma = 20 * std::log10(std::abs(source[peakOffset == static_cast<std::ptrdiff_t>(N) ? peakOffset : peakOffset + 1] * invSize));
+			const auto & peak = lineGraphExchange.front().tracker;
 
-			auto phi = 0.5 * (alpha - gamma) / (alpha - 2 * beta + gamma);
+			// the tracker was switched to the transform after the latest results were published
+			if (!peak.found)
+				return;
 
-			// global
-			peakFraction = 2 * (peakOffset + (std::isnormal(phi) ? phi : 0)) / double(N);
+			peakFraction = peak.fraction;
 			peakFrequency = 0.5 * peakFraction * sampleRate;
-			// translate to local
-
-			peakDBs = beta - 0.25*(alpha - gamma) * phi;
-			if (!std::isnormal(peakDBs))
-				peakDBs = 20 * std::log10(std::abs(source[peakOffset]) / (N * 0.5));
+			peakDBs = peak.dBs;
 
 			peakX = frequencyGraph.fractionToCoordTransformed(peakFraction);
 
@@ -606,6 +566,8 @@ namespace Signalizer
 	void Spectrum::closeOpenGL()
 	{
 		textures.clear();
+		columnUploads.release(*oglc);
+		shadedSpectrogram.release(*oglc);
 		oglImage.offload();
 	}
 
@@ -688,34 +650,32 @@ namespace Signalizer
 		cpl::simd::dynamic_isa_dispatch<float, RenderingDispatcher>(*this);
     }
 
+	bool Spectrum::processNextFrame()
+	{
+		bool processed = false;
+		cpl::simd::dynamic_isa_dispatch<float, FrameDispatcher>(*this, processed);
+		return processed;
+	}
+
     template<typename ISA>
     void Spectrum::vectorGLRendering()
 	{
+		SIGNALIZER_TRACE_THREAD("Rendering");
+		SIGNALIZER_TRACE_ZONE("Spectrum::render");
+
 		auto cStart = cpl::Misc::ClockCounter();
         {
 
-            cpl::CFastMutex audioLock;
             // starting from a clean slate?
             CPL_DEBUGCHECKGL();
             juce::OpenGLHelpers::clear(state.colourBackground);
 
 
-            for (std::size_t i = 0; i < SpectrumContent::LineGraphs::LineEnd; ++i)
-                lineGraphs[i].filter.setSampleRate(fpoint(1.0 / openGLDeltaTime()));
-
-            bool lineTransformReady = false;
-
-            // lock the memory buffers, and do our thing.
-            {
-                handleFlagUpdates();
-                // line graph data for ffts are rendered now.
-                if (state.displayMode == SpectrumContent::DisplayMode::LineGraph)
-                {
-                    audioLock.acquire(audioResource);
-                    lineTransformReady = prepareTransform(audioStream.getAudioBufferViews());
-                }
+            handleFlagUpdates();
 
-            }
+            // in line graph mode, the peak filters are run by the async audio thread at the blob rate.
+            if (state.displayMode == SpectrumContent::DisplayMode::ColourSpectrum)
+                updateLineGraphFilters(fpoint(1.0 / openGLDeltaTime()));
             // flags may have altered ogl state
             CPL_DEBUGCHECKGL();
 
@@ -734,15 +694,9 @@ namespace Signalizer
             switch (state.displayMode)
             {
             case SpectrumContent::DisplayMode::LineGraph:
-                // no need to lock in this case, as this display mode is exclusively switched,
-                // such that only we have access to it.
-                if (lineTransformReady)
-                {
-                    audioLock.acquire(audioResource);
-                    doTransform();
-                    mapToLinearSpace();
-                    postProcessStdTransform();
-                }
+                // transforms are processed by the async audio thread, just pick up the latest results.
+                lineGraphExchange.acquireLatest();
+                drawnClock = lineGraphExchange.front().clock;
                 renderLineGraph<ISA>(openGLStack); break;
             case SpectrumContent::DisplayMode::ColourSpectrum:
                 // mapping and processing is already done here.
@@ -754,6 +708,7 @@ namespace Signalizer
 		CPL_DEBUGCHECKGL();
 		renderGraphics([&](juce::Graphics & g) { paint2DGraphics(g); });
 		CPL_DEBUGCHECKGL();
+		latency.frameDrawn(content->systemView.getBlockTimeline(), drawnClock);
         renderCycles = cpl::Misc::ClockCounter() - cStart;
         auto tickNow = juce::Time::getHighResolutionTicks();
         avgFps.setNext(tickNow - lastFrameTick);
@@ -764,6 +719,8 @@ namespace Signalizer
 	template<typename ISA>
 		void Spectrum::renderColourSpectrum(cpl::OpenGLRendering::COpenGLStack & ogs)
 		{
+			SIGNALIZER_TRACE_ZONE("Spectrum::renderColourSpectrum");
+
 			CPL_DEBUGCHECKGL();
 			auto pW = oglImage.getWidth();
 			if (!pW)
@@ -783,11 +740,38 @@ namespace Signalizer
 				//
 				bool shouldCap = content->frameUpdateSmoothing.getTransformedValue() != 0.0;
 
-				while ((!shouldCap || (processedFrames++ < framesThisTime)) && processNextSpectrumFrame())
+				const bool shadeColours = state.colourMapping == SpectrumContent::ColourMapping::GraphicsCard;
+				// levels of the mapped transforms are scaled to this range.
+				const auto dbs = getDBs();
+
+				if (!shadeColours && (columnUploads.getWidth() != pW || columnUploads.getHeight() != columnUpdate.size()))
+					columnUploads.resize(pW, columnUpdate.size());
+
+				if (shadeColours && (shadedSpectrogram.getWidth() != pW || shadedSpectrogram.getHeight() != columnUpdate.size()))
+				{
+					shadedSpectrogram.resize(pW, columnUpdate.size());
+					levelColumn.resize(columnUpdate.size());
+				}
+
+				while ((!shouldCap || (processedFrames++ < framesThisTime)) && processNextSpectrumFrame<ISA>())
 				{
 #pragma message cwarn("Update frames per update each time inside here, but as a local variable! There may come more updates meanwhile.")
 					// run the next frame through pixel filters and format it etc.
 
+					if (shadeColours)
+					{
+						const auto & results = lineGraphs[SpectrumContent::LineGraphs::LineMain].results;
+
+						// store levels independent of the dynamic range, which is applied when drawing.
+						for (std::size_t i = 0; i < levelColumn.size(); ++i)
+							levelColumn[i] = static_cast<float>(dbs.low + results[i].magnitude * (dbs.high - dbs.low));
+
+						shadedSpectrogram.addColumn(framePixelPosition, levelColumn.data());
+
+						framePixelPosition++;
+						framePixelPosition %= pW;
+						continue;
+					}
 
 					for (int i = 0; i < getAxisPoints(); ++i)
 					{
@@ -810,9 +794,8 @@ namespace Signalizer
 						);
 #endif
 					}
-					//CPL_DEBUGCHECKGL();
-					oglImage.updateSingleColumn(framePixelPosition, columnUpdate, GL_RGBA);
-					//CPL_DEBUGCHECKGL();
+					// staged, and uploaded together with the other new columns below.
+					columnUploads.addColumn(framePixelPosition, columnUpdate.data());
 
 					framePixelPosition++;
 					framePixelPosition %= pW;
@@ -821,9 +804,35 @@ namespace Signalizer
 
 			CPL_DEBUGCHECKGL();
 
+			if (state.colourMapping == SpectrumContent::ColourMapping::GraphicsCard)
+			{
+				const std::size_t gradientSize = 256;
+				cpl::GraphicsND::UPixel<cpl::GraphicsND::ComponentOrder::OpenGL> gradient[gradientSize];
+
+				// the same gradient as colouring on the processor, sampled evenly
+				for (std::size_t i = 0; i < gradientSize; ++i)
+				{
+					ColourScale2<SpectrumContent::numSpectrumColours + 1, 4>(
+						gradient + i,
+						i / float(gradientSize - 1),
+						state.colourSpecs,
+						state.normalizedSpecRatios
+					);
+				}
+
+				shadedSpectrogram.setGradient(gradient, gradientSize);
+
+				auto const dbs = getDBs();
+				shadedSpectrogram.render(*oglc, framePixelPosition, static_cast<float>(dbs.low), static_cast<float>(dbs.high));
+			}
+			else
 			{
 				cpl::OpenGLRendering::COpenGLImage::OpenGLImageDrawer imageDrawer(oglImage, ogs);
 
+				// the image's texture is bound by the drawer.
+				columnUploads.upload(*oglc, GL_RGBA, GL_UNSIGNED_BYTE);
+				CPL_DEBUGCHECKGL();
+
 				imageDrawer.drawCircular((float)((double)(framePixelPosition) / (pW - 1)));
 				//imageDrawer.drawCircular((float)content->frameUpdateSmoothing.getNormalizedValue());
 			}
@@ -872,6 +881,8 @@ namespace Signalizer
 	template<typename ISA>
 	void Spectrum::renderLineGraph(cpl::OpenGLRendering::COpenGLStack & ogs)
 	{
+		SIGNALIZER_TRACE_ZONE("Spectrum::renderLineGraph");
+
 		int points = getAxisPoints() - 1;
 		// render the flood fill with alpha
 		ogs.setBlender(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -892,6 +903,8 @@ namespace Signalizer
 
 			for (int k = SpectrumContent::LineGraphs::LineEnd - 1; k >= 0; --k)
 			{
+				const auto & results = getLineGraphResults(k);
+
 				switch (state.configuration)
 				{
 				case SpectrumChannels::MidSide:
@@ -902,7 +915,7 @@ namespace Signalizer
 					lineDrawer.addColour(state.colourTwo[k].withAlpha(state.alphaFloodFill));
 					for (int i = 0; i < (points + 1); ++i)
 					{
-						lineDrawer.addVertex(i, lineGraphs[k].results[i].rightMagnitude, -0.5);
+						lineDrawer.addVertex(i, results[i].rightMagnitude, -0.5);
 						lineDrawer.addVertex(i, endPoint, -0.5);
 					}
 				}
@@ -917,7 +930,7 @@ namespace Signalizer
 					lineDrawer.addColour(state.colourOne[k].withAlpha(state.alphaFloodFill));
 					for (int i = 0; i < (points + 1); ++i)
 					{
-						lineDrawer.addVertex(i, lineGraphs[k].results[i].leftMagnitude, 0);
+						lineDrawer.addVertex(i, results[i].leftMagnitude, 0);
 						lineDrawer.addVertex(i, endPoint, 0);
 					}
 				}
@@ -935,6 +948,8 @@ namespace Signalizer
 		// draw back to front
 		for (int k = SpectrumContent::LineGraphs::LineEnd - 1; k >= 0; --k)
 		{
+			const auto & results = getLineGraphResults(k);
+
 			switch (state.configuration)
 			{
 			case SpectrumChannels::MidSide:
@@ -945,7 +960,7 @@ namespace Signalizer
 				lineDrawer.addColour(state.colourTwo[k]);
 				for (int i = 0; i < (points + 1); ++i)
 				{
-					lineDrawer.addVertex(i, lineGraphs[k].results[i].rightMagnitude, -0.5);
+					lineDrawer.addVertex(i, results[i].rightMagnitude, -0.5);
 				}
 			}
 			// (fall-through intentional)
@@ -959,7 +974,7 @@ namespace Signalizer
 				lineDrawer.addColour(state.colourOne[k]);
 				for (int i = 0; i < (points + 1); ++i)
 				{
-					lineDrawer.addVertex(i, lineGraphs[k].results[i].leftMagnitude, 0);
+					lineDrawer.addVertex(i, results[i].leftMagnitude, 0);
 				}
 			}
 			default:
@@ -0,0 +1,279 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:DensityHistogram.h
+
+		A decaying two-dimensional histogram of stereo samples, accumulated on the
+		audio thread and drawn as a single colour mapped texture.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_DENSITYHISTOGRAM_H
+	#define SIGNALIZER_DENSITYHISTOGRAM_H
+
+	#include "Signalizer.h"
+	#include "PolarMapping.h"
+	#include <cpl/simd.h>
+	#include <cmath>
+	#include <memory>
+
+	#ifndef GL_RED
+		#define GL_RED 0x1903
+	#endif
+	#ifndef GL_R16F
+		#define GL_R16F 0x822D
+	#endif
+	#ifndef GL_CLAMP_TO_EDGE
+		#define GL_CLAMP_TO_EDGE 0x812F
+	#endif
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Bins stereo samples into a resolution x resolution intensity histogram covering [-1, 1] on both axes,
+		/// using the same coordinates as the vectorscope plots. Every bin decays exponentially, such that
+		/// the histogram represents about the last historySize samples.
+		///
+		/// accumulate() is called by the audio thread, which publishes the histogram wait-free to the renderer.
+		/// The cost of both sides is fixed by the resolution, and not by the length of the history.
+		/// render() and release() must be called with the OpenGL context active.
+		/// </summary>
+		class DensityHistogram
+		{
+		public:
+
+			static constexpr std::size_t resolution = 256;
+
+			typedef cpl::aligned_vector<float, 32> Bins;
+
+			DensityHistogram()
+				: bins(resolution * resolution)
+			{
+				exchange.forEach([](Bins & b) { b.resize(resolution * resolution); });
+			}
+
+			/// <summary>
+			/// Adds the samples to the histogram, scaled by gain, decays it by the duration of the samples and publishes it.
+			/// Lissajous plots place right on the x-axis and left on the y-axis, while polar plots use polarMap().
+			/// Samples outside of the plot are discarded.
+			/// </summary>
+			template<typename V>
+				void accumulate(const AFloat * left, const AFloat * right, std::size_t numSamples, float gain, bool isPolar, std::size_t historySize)
+				{
+					using namespace cpl::simd;
+					typedef typename scalar_of<V>::type T;
+
+					if (!historySize)
+						return;
+
+					const std::size_t vectorLength = elements_of<V>::value;
+					const T limit = static_cast<T>(resolution);
+					const T halfResolution = limit * T(0.5);
+
+					// each sample contributes the same weight, normalized so a trace of resolution bins spread over the history
+					// about reaches unity density.
+					const float weight = static_cast<float>(resolution) / historySize;
+
+					const V vGain = set1<V>(gain);
+					const V vScale = set1<V>(halfResolution);
+
+					suitable_container<V> xCoords, yCoords;
+
+					auto scatter = [&](std::size_t count)
+					{
+						// vector scatters aren't available before AVX-512, and many samples hit the same bins anyway.
+						for (std::size_t n = 0; n < count; ++n)
+						{
+							const T x = xCoords[n], y = yCoords[n];
+
+							// also discards nans
+							if (x >= 0 && x < limit && y >= 0 && y < limit)
+								bins[static_cast<std::size_t>(y) * resolution + static_cast<std::size_t>(x)] += weight;
+						}
+					};
+
+					std::size_t i = 0;
+
+					for (; i + vectorLength <= numSamples; i += vectorLength)
+					{
+						const V vLeft = loadu<V>(left + i) * vGain;
+						const V vRight = loadu<V>(right + i) * vGain;
+
+						V vX = vRight, vY = vLeft;
+
+						if (isPolar)
+							polarMap(vLeft, vRight, vX, vY);
+
+						// map [-1, 1] to [0, resolution)
+						xCoords = vX * vScale + vScale;
+						yCoords = vY * vScale + vScale;
+
+						scatter(vectorLength);
+					}
+
+					// the remainder is less than a vector
+					const std::size_t remaining = numSamples - i;
+
+					for (std::size_t n = 0; n < remaining; ++n)
+					{
+						const T sampleLeft = left[i + n] * gain, sampleRight = right[i + n] * gain;
+						T x = sampleRight, y = sampleLeft;
+
+						if (isPolar)
+							polarMapSample(sampleLeft, sampleRight, x, y);
+
+						xCoords[n] = x * halfResolution + halfResolution;
+						yCoords[n] = y * halfResolution + halfResolution;
+					}
+
+					scatter(remaining);
+
+					// decay the histogram while publishing it, in one pass
+					const V vDecay = set1<V>(static_cast<T>(std::exp(-static_cast<double>(numSamples) / historySize)));
+					auto & back = exchange.back();
+
+					for (std::size_t b = 0; b < bins.size(); b += vectorLength)
+					{
+						const V decayed = load<V>(bins.data() + b) * vDecay;
+						*reinterpret_cast<V *>(bins.data() + b) = decayed;
+						*reinterpret_cast<V *>(back.data() + b) = decayed;
+					}
+
+					exchange.publish();
+				}
+
+			/// <summary>
+			/// Uploads the latest published histogram, if any, and draws it over the plot area [-1, 1]
+			/// at z = 0 with the current matrices. Densities are tone mapped and multiplied onto the colour.
+			/// </summary>
+			void render(juce::OpenGLContext & context, juce::Colour colour)
+			{
+				if (!program && !createProgram(context))
+					return;
+
+				if (!texture)
+				{
+					glGenTextures(1, &texture);
+					glBindTexture(GL_TEXTURE_2D, texture);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+					glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, static_cast<GLsizei>(resolution), static_cast<GLsizei>(resolution), 0, GL_RED, GL_FLOAT, nullptr);
+					// upload the current histogram even if nothing new was published since.
+					hasContent = false;
+				}
+				else
+				{
+					glBindTexture(GL_TEXTURE_2D, texture);
+				}
+
+				if (exchange.acquireLatest() || !hasContent)
+				{
+					glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+					glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(resolution), static_cast<GLsizei>(resolution), GL_RED, GL_FLOAT, exchange.front().data());
+					hasContent = true;
+				}
+
+				program->use();
+				densities->set(0);
+				colourUniform->set(colour.getFloatRed(), colour.getFloatGreen(), colour.getFloatBlue(), colour.getFloatAlpha());
+
+				glBegin(GL_QUADS);
+				glVertex2f(-1.0f, -1.0f);
+				glVertex2f(1.0f, -1.0f);
+				glVertex2f(1.0f, 1.0f);
+				glVertex2f(-1.0f, 1.0f);
+				glEnd();
+
+				context.extensions.glUseProgram(0);
+				glBindTexture(GL_TEXTURE_2D, 0);
+			}
+
+			/// <summary>
+			/// Releases all OpenGL objects. Call before the context is destroyed.
+			/// </summary>
+			void release(juce::OpenGLContext & context)
+			{
+				densities = nullptr;
+				colourUniform = nullptr;
+				program = nullptr;
+
+				if (texture)
+				{
+					glDeleteTextures(1, &texture);
+					texture = 0;
+				}
+
+				hasContent = false;
+			}
+
+		private:
+
+			bool createProgram(juce::OpenGLContext & context)
+			{
+				static const char * vertexShader =
+					"varying vec2 position;\n"
+					"void main()\n"
+					"{\n"
+					"	position = gl_Vertex.xy * 0.5 + 0.5;\n"
+					"	gl_Position = gl_ModelViewProjectionMatrix * vec4(gl_Vertex.xy, 0.0, 1.0);\n"
+					"}\n";
+
+				static const char * fragmentShader =
+					"uniform sampler2D densities;\n"
+					"uniform vec4 colour;\n"
+					"varying vec2 position;\n"
+					"void main()\n"
+					"{\n"
+					"	float intensity = 1.0 - exp(-texture2D(densities, position).r);\n"
+					"	gl_FragColor = vec4(colour.rgb * intensity, colour.a * intensity);\n"
+					"}\n";
+
+				std::unique_ptr<juce::OpenGLShaderProgram> newProgram(new juce::OpenGLShaderProgram(context));
+
+				if (!newProgram->addVertexShader(vertexShader) || !newProgram->addFragmentShader(fragmentShader) || !newProgram->link())
+				{
+					CPL_BREAKIFDEBUGGED();
+					return false;
+				}
+
+				program = std::move(newProgram);
+				densities.reset(new juce::OpenGLShaderProgram::Uniform(*program, "densities"));
+				colourUniform.reset(new juce::OpenGLShaderProgram::Uniform(*program, "colour"));
+
+				return true;
+			}
+
+			/// <summary>
+			/// The accumulating histogram, only accessed by the audio thread.
+			/// </summary>
+			Bins bins;
+			ConcurrentTripleBuffer<Bins> exchange;
+			std::unique_ptr<juce::OpenGLShaderProgram> program;
+			std::unique_ptr<juce::OpenGLShaderProgram::Uniform> densities, colourUniform;
+			GLuint texture = 0;
+			bool hasContent = false;
+		};
+	};
+#endif
@@ -0,0 +1,94 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:PolarMapping.h
+
+		Mapping of stereo samples to the polar vectorscope plot.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_POLARMAPPING_H
+	#define SIGNALIZER_POLARMAPPING_H
+
+	#include <cpl/simd.h>
+	#include <algorithm>
+	#include <cmath>
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Maps a stereo sample to the upper half of the polar plot: The sample is rotated to center mono on the Y-axis,
+		/// folded into the upper half-plane and scaled to a length of max(|left|, |right|), converting the unit square to a half circle.
+		///
+		/// This is the direction of (sin, cos)(atan(x / y)), found algebraically: the rotated vector is normalized,
+		/// and negated if it points downwards. Silence maps to the origin.
+		/// </summary>
+		template<typename V>
+			inline void polarMap(V left, V right, V & x, V & y) noexcept
+			{
+				using namespace cpl::simd;
+				using cpl::simd::abs;
+
+				const V vZero = zero<V>();
+				const V vCosine = consts<V>::sqrt_half_two_minus; // equals e^i*0.75*pi
+				const V vSine = consts<V>::sqrt_half_two;
+
+				// the length of the hypotenuse of the triangle, we
+				// convert the unit square to.
+				const V vLength = max(abs(left), abs(right));
+
+				// rotate our view manually (to center on Y-axis).
+				// x and y are swapped at this point, btw.
+				const V vY = left * vCosine - right * vSine;
+				const V vX = left * vSine + right * vCosine;
+
+				// the rotation preserves the radius. zero radii produce nans here, which are masked out below.
+				const V vRadius = left * left + right * right;
+				const V vScale = vand(vnot((V)(vRadius == vZero)), vLength / sqrt(vRadius));
+
+				x = vselect(vZero - vX, vX, (V)(vY < vZero)) * vScale;
+				y = abs(vY) * vScale;
+			}
+
+		/// <summary>
+		/// Scalar version of polarMap().
+		/// </summary>
+		template<typename Ty>
+			inline void polarMapSample(Ty left, Ty right, Ty & x, Ty & y) noexcept
+			{
+				const Ty cosineRotation = cpl::simd::consts<Ty>::sqrt_half_two_minus;
+				const Ty sineRotation = cpl::simd::consts<Ty>::sqrt_half_two;
+
+				const Ty length = std::max(std::abs(left), std::abs(right));
+
+				const Ty rotY = left * cosineRotation - right * sineRotation;
+				const Ty rotX = left * sineRotation + right * cosineRotation;
+
+				const Ty radius = left * left + right * right;
+				const Ty scale = radius != Ty(0) ? length / std::sqrt(radius) : Ty(0);
+
+				x = (rotY < Ty(0) ? -rotX : rotX) * scale;
+				y = std::abs(rotY) * scale;
+			}
+	};
+#endif
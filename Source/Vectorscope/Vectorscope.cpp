@@ -37,6 +37,10 @@
 #include <cpl/LexicalConversion.h>
 #include "VectorscopeParameters.h"
 
+#ifdef SIGNALIZER_BENCHMARKS
+#include "../Analysis/Benchmark.h"
+#endif
+
 namespace Signalizer
 {
 	static std::vector<std::string> OperationalModeNames = {"Lissajous", "Polar"};
@@ -58,6 +62,7 @@ namespace Signalizer
 		, audioStream(data)
 		, processorSpeed(0)
 		, lastFrameTick(0)
+		, latency({ "Vectorscope latency (ms)", "Vectorscope latency p50 (ms)", "Vectorscope latency p99 (ms)" })
 		, lastMousePos()
 		, editor(nullptr)
 		, state()
@@ -73,6 +78,11 @@ namespace Signalizer
 		mtFlags.firstRun = true;
 		state.secondStereoFilterSpeed = 0.25f;
 		state.envelopeGain = 1;
+		shared.autoGainEnvelope.store(1, std::memory_order_relaxed);
+		shared.writtenSamples.store(0, std::memory_order_relaxed);
+		shared.streamClock.store(0, std::memory_order_relaxed);
+		state.rendering = VectorScopeContent::Rendering::Processor;
+		state.displayMode = VectorScopeContent::DisplayMode::Samples;
 		setOpaque(true);
 		textbuf = std::unique_ptr<char>(new char[300]);
 		processorSpeed = cpl::system::CProcessor::getMHz();
@@ -228,6 +238,8 @@ namespace Signalizer
 		state.envelopeCoeff = std::exp(-1.0 / (content->envelopeWindow.getNormalizedValue() * audioStream.getInfo().sampleRate));
 		state.stereoCoeff = std::exp(-1.0 / (content->stereoWindow.getNormalizedValue() * audioStream.getInfo().sampleRate));
 
+		state.rendering = content->rendering.param.getAsTEnum<VectorScopeContent::Rendering>();
+		state.displayMode = content->displayMode.param.getAsTEnum<VectorScopeContent::DisplayMode>();
 		state.isPolar = cpl::enum_cast<OperationalModes>(content->operationalMode.param.getTransformedValue()) == OperationalModes::Polar;
 		state.antialias = content->antialias.getTransformedValue() > 0.5;
 		state.fadeHistory = content->fadeOlderPoints.getTransformedValue() > 0.5;
@@ -269,12 +281,30 @@ namespace Signalizer
 	template<typename ISA>
 		void VectorScope::audioProcessing(AudioStream::DataType ** buffer, std::size_t numChannels, std::size_t numSamples)
 		{
+			SIGNALIZER_TRACE_ZONE("VectorScope::audioProcessing");
+
 			typedef typename ISA::V V;
 			using namespace cpl::simd;
 			typedef typename scalar_of<V>::type T;
 			if (numChannels != 2)
 				return;
 
+			if (content->displayMode.param.getAsTEnum<VectorScopeContent::DisplayMode>() == VectorScopeContent::DisplayMode::Density)
+			{
+				// the histogram is binned with the gain of the last block, as the plot can't be rescaled afterwards
+				const double envelopeGain = state.envelopeMode == EnvelopeModes::None ? 1.0 : shared.autoGainEnvelope.load(std::memory_order_acquire);
+				const bool isPolar = cpl::enum_cast<OperationalModes>(content->operationalMode.param.getTransformedValue()) == OperationalModes::Polar;
+
+				densityHistogram.accumulate<V>(
+					buffer[0],
+					buffer[1],
+					numSamples,
+					static_cast<float>(envelopeGain * content->inputGain.getTransformedValue()),
+					isPolar,
+					audioStream.getAudioHistorySize()
+				);
+			}
+
 			T filterEnv[2] = { filters.envelope[0], filters.envelope[1] };
 			T stereoPoles[2] = { state.stereoCoeff, std::pow(state.stereoCoeff, state.secondStereoFilterSpeed) };
 
@@ -285,8 +315,13 @@ namespace Signalizer
 
 			const V vDummyAngle = set1<V>((T)(M_PI * 0.25));
 			const V vZero = zero<V>();
+			const V vSign = consts<V>::sign_mask;
+
+			// peaks of this block, for the peak decay envelope
+			V vLMax = vZero, vRMax = vZero;
 
 			auto const loopIncrement = elements_of<V>::value;
+			const std::size_t blockSamples = numSamples;
 
 			// ensure a perfect multiple and no buffer overrun
 			numSamples -= numSamples & (loopIncrement - 1);
@@ -299,6 +334,9 @@ namespace Signalizer
 				const V vLeft = loadu<V>(buffer[0] + n);
 				const V vRight = loadu<V>(buffer[1] + n);
 
+				vLMax = max(vand(vLeft, vSign), vLMax);
+				vRMax = max(vand(vRight, vSign), vRMax);
+
 				// rotate 235 degrees...
 				const V vX = vLeft * vMatrixReal - vRight * vMatrixImag;
 				const V vY = vRight * vMatrixImag + vLeft * vMatrixReal;
@@ -361,14 +399,49 @@ namespace Signalizer
 
 				if (std::isnormal(currentEnvelope))
 				{
-					state.envelopeGain = currentEnvelope;
+					shared.autoGainEnvelope.store(currentEnvelope, std::memory_order_release);
+				}
+			}
+			else if (state.envelopeMode == EnvelopeModes::PeakDecay)
+			{
+				suitable_container<V> lmax = vLMax, rmax = vRMax;
+
+				double highestLeft = *std::max_element(lmax.begin(), lmax.end());
+				double highestRight = *std::max_element(rmax.begin(), rmax.end());
+
+				// the samples left over by the vector loop
+				for (std::size_t n = numSamples; n < blockSamples; ++n)
+				{
+					highestLeft = std::max<double>(highestLeft, std::abs(buffer[0][n]));
+					highestRight = std::max<double>(highestRight, std::abs(buffer[1][n]));
 				}
+
+				// this used to run on the whole history for every frame, decaying by the history size times the frame time.
+				// running for every block instead, the same decay rate is the history size times the block time.
+				const double power = audioStream.getAudioHistorySize() * (blockSamples / audioStream.getInfo().sampleRate);
+				const double coeff = std::pow(state.envelopeCoeff, power);
+
+				filters.envelope[0] = std::max(filters.envelope[0] * coeff, highestLeft  * highestLeft);
+				filters.envelope[1] = std::max(filters.envelope[1] * coeff, highestRight * highestRight);
+
+				shared.autoGainEnvelope.store(1.0 / std::max(std::sqrt(filters.envelope[0]), std::sqrt(filters.envelope[1])), std::memory_order_release);
 			}
 
 		}
 
 	bool VectorScope::onAsyncAudio(const AudioStream & source, AudioStream::DataType ** buffer, std::size_t numChannels, std::size_t numSamples)
 	{
+		SIGNALIZER_TRACE_THREAD("Async audio");
+		SIGNALIZER_TRACE_ZONE("VectorScope::onAsyncAudio");
+
+		// the history is written regardless of whether this view processes it.
+		shared.writtenSamples.fetch_add(numSamples, std::memory_order_relaxed);
+		shared.streamClock.store(audioStream.getASyncPlayhead().getSteadyClock() + numSamples, std::memory_order_release);
+
+	#ifdef DEBUG
+		CPL_RUNTIME_ASSERTION(content->systemView.getBlockTimeline().hasStamped(audioStream.getASyncPlayhead().getSteadyClock() + numSamples) && "Block timeline doesn't follow the steady clock of the stream");
+	#endif
+
 		if (state.isSuspended && globalBehaviour.stopProcessingOnSuspend.load(std::memory_order_relaxed))
 			return false;
 
@@ -381,4 +454,37 @@ namespace Signalizer
 		mtFlags.audioWindowWasResized = true;
 	}
 
+#ifdef SIGNALIZER_BENCHMARKS
+	void VectorScope::runBenchmarks(Benchmark & suite)
+	{
+		typedef VectorScopeContent::DisplayMode DisplayMode;
+
+		struct Variant { const char * name; DisplayMode mode; OperationalModes operation; };
+
+		static const Variant variants[] =
+		{
+			{ "samples", DisplayMode::Samples, OperationalModes::Lissajous },
+			{ "density, lissajous", DisplayMode::Density, OperationalModes::Lissajous },
+			{ "density, polar", DisplayMode::Density, OperationalModes::Polar }
+		};
+
+		const auto blockSize = suite.getOptions().blockSize;
+		AFloat * block[2] = { suite.getTestChannel(0), suite.getTestChannel(1) };
+
+		for (auto & variant : variants)
+		{
+			content->displayMode.param.setTransformedValue(static_cast<double>(variant.mode));
+			content->operationalMode.param.setTransformedValue(static_cast<double>(variant.operation));
+			handleFlagUpdates();
+
+			Benchmark::forEachISA(
+				[&](auto isa, const char * isaName)
+				{
+					typedef decltype(isa) ISA;
+					suite.measure("audioProcessing", variant.name, isaName, blockSize, [&] { audioProcessing<ISA>(block, 2, blockSize); });
+				}
+			);
+		}
+	}
+#endif
 };
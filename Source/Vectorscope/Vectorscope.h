@@ -34,9 +34,12 @@
 	#include <cpl/Utility.h>
 	#include <cpl/gui/controls/Controls.h>
 	#include <cpl/gui/widgets/Widgets.h>
+	#include <atomic>
 	#include <memory>
 	#include <cpl/simd.h>
 	#include "VectorscopeParameters.h"
+	#include "VertexHistory.h"
+	#include "DensityHistogram.h"
 
 	namespace cpl
 	{
@@ -49,6 +52,7 @@
 
 	namespace Signalizer
 	{
+		class Benchmark;
 
 		template<typename T, std::size_t size>
 			class LookupTable
@@ -98,12 +102,22 @@
 
 		public:
 
+			friend class OfflineAnalysis;
+
 			static const double higherAutoGainBounds;
 			static const double lowerAutoGainBounds;
 
 			VectorScope(const SharedBehaviour & globalBehaviour, const std::string & nameId, AudioStream & data, ProcessorState * params);
 			virtual ~VectorScope();
 
+#ifdef SIGNALIZER_BENCHMARKS
+			/// <summary>
+			/// Times the DSP kernels of the view in each of their variants, see Benchmark.h.
+			/// Only part of the benchmark target.
+			/// </summary>
+			void runBenchmarks(Benchmark & suite);
+#endif
+
 			// Component overrides
 			void onGraphicsRendering(juce::Graphics & g) override;
 			void mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) override;
@@ -166,6 +180,16 @@
 			template<typename ISA>
 				void drawRectPlot(cpl::OpenGLRendering::COpenGLStack &, const AudioStream::AudioBufferAccess &);
 
+			/// <summary>
+			/// Draws the plot through vertexHistory, for VectorScopeContent::Rendering::GraphicsCard.
+			/// </summary>
+			void drawShadedPlot(cpl::OpenGLRendering::COpenGLStack &, const AudioStream::AudioBufferAccess &);
+
+			/// <summary>
+			/// Draws the latest histogram of densityHistogram, for VectorScopeContent::DisplayMode::Density.
+			/// </summary>
+			void drawDensityPlot(cpl::OpenGLRendering::COpenGLStack &);
+
 			template<typename ISA>
 				void drawWireFrame(cpl::OpenGLRendering::COpenGLStack &);
 
@@ -175,8 +199,6 @@
 			template<typename ISA>
 				void drawStereoMeters(cpl::OpenGLRendering::COpenGLStack &, const AudioStream::AudioBufferAccess &);
 
-			template<typename ISA>
-				void runPeakFilter(const AudioStream::AudioBufferAccess &);
 
 			template<typename ISA>
 				void audioProcessing(AudioStream::DataType ** buffer, std::size_t numChannels, std::size_t numSamples);
@@ -190,6 +212,7 @@
 
 			// vars
 			long long lastFrameTick, renderCycles;
+			LatencyMeter latency;
 
 			struct FilterStates
 			{
@@ -236,8 +259,29 @@
 				juce::Colour colourBackground, colourWire, colourGraph, colourDraw, colourMeter;
 				cpl::ValueT envelopeGain, userGain;
 				EnvelopeModes envelopeMode;
+				VectorScopeContent::Rendering rendering;
+				VectorScopeContent::DisplayMode displayMode;
 			} state;
 
+			struct SharedStateOptions
+			{
+				/// <summary>
+				/// The auto-gain of the current envelope mode, published by the audio thread.
+				/// </summary>
+				std::atomic<double>
+					autoGainEnvelope;
+				/// <summary>
+				/// Samples received by the audio thread since the vertex history was last updated.
+				/// </summary>
+				std::atomic<std::size_t>
+					writtenSamples;
+				/// <summary>
+				/// The steady clock of the stream after the newest sample received by the audio thread.
+				/// </summary>
+				std::atomic<std::uint64_t>
+					streamClock;
+			} shared;
+
 			const SharedBehaviour & globalBehaviour;
 			VectorScopeContent * content;
 			AudioStream & audioStream;
@@ -250,6 +294,11 @@
 			unsigned long long processorSpeed; // clocks / sec
 			juce::Point<float> lastMousePos;
 			std::vector<std::unique_ptr<juce::OpenGLTexture>> textures;
+			VertexHistory vertexHistory;
+			/// <summary>
+			/// Accumulated by the audio thread in the density display mode.
+			/// </summary>
+			DensityHistogram densityHistogram;
 
 		};
 
@@ -41,6 +41,16 @@
 		{
 		public:
 
+			enum class Rendering
+			{
+				Processor, GraphicsCard
+			};
+
+			enum class DisplayMode
+			{
+				Samples, Density
+			};
+
 			class VectorScopeController 
 				: public CContentPage
 			{
@@ -66,6 +76,8 @@
 					, ktransform(&parentValue.transform)
 					, kopMode(&parentValue.operationalMode.param)
 					, kenvelopeMode(&parentValue.autoGain.param)
+					, krendering(&parentValue.rendering.param)
+					, kdisplayMode(&parentValue.displayMode.param)
 					, kpresets(&valueSerializer, "vectorscope")
 					, editorSerializer(
 						*this,
@@ -116,6 +128,8 @@
 
 					// design
 					kopMode.bSetTitle("Operational mode");
+					krendering.bSetTitle("Rendering");
+					kdisplayMode.bSetTitle("Display mode");
 
 
 					// descriptions.
@@ -138,6 +152,8 @@
 					kenvelopeSmooth.bSetDescription("Responsiveness (RMS window size) - or the time it takes for the envelope follower to decay.");
 					kopMode.bSetDescription("Changes the presentation of the data - Lissajous is the classic XY mode on oscilloscopes, while the polar mode is a wrapped circle of the former.");
 					kstereoSmooth.bSetDescription("Responsiveness (RMS window size) - or the time it takes for the stereo meters to follow.");
+					kdisplayMode.bSetDescription("Select how samples are displayed; the density mode shows how often the signal visits each point of the plot, at a cost independent of the window size.");
+					krendering.bSetDescription("Select where the samples are transformed; on the graphics card, only new samples are transferred each frame, so long histories are cheaper to draw.");
 
 				}
 
@@ -158,6 +174,7 @@
 
 							section->addControl(&kopMode, 1);
 							section->addControl(&kstereoSmooth, 1);
+							section->addControl(&kdisplayMode, 1);
 
 
 							section->addControl(&krotation, 0);
@@ -177,6 +194,7 @@
 							section->addControl(&kfadeOld, 1);
 							section->addControl(&kdrawLines, 2);
 							section->addControl(&kdiagnostics, 3);
+							section->addControl(&krendering, 0);
 							page->addSection(section, "Options");
 						}
 						if (auto section = new Signalizer::CContentPage::MatrixSection())
@@ -223,6 +241,8 @@
 					archive << kopMode;
 					archive << kstereoSmooth;
 					archive << kmeterColour;
+					archive << krendering;
+					archive << kdisplayMode;
 				}
 
 				void deserializeEditorSettings(cpl::CSerializer::Archiver & builder, cpl::Version version)
@@ -251,6 +271,12 @@
 					builder >> kopMode;
 					builder >> kstereoSmooth;
 					builder >> kmeterColour;
+
+					if (version >= cpl::Version(0, 3, 3))
+					{
+						builder >> krendering;
+						builder >> kdisplayMode;
+					}
 				}
 
 				// entrypoints for completely storing values and settings in independant blobs (the preset widget)
@@ -290,7 +316,7 @@
 				cpl::CValueKnobSlider kwindow, krotation, kgain, kprimitiveSize, kenvelopeSmooth, kstereoSmooth;
 				cpl::CColourControl kdrawingColour, kgraphColour, kbackgroundColour, kskeletonColour, kmeterColour;
 				cpl::CTransformWidget ktransform;
-				cpl::CValueComboBox kopMode, kenvelopeMode;
+				cpl::CValueComboBox kopMode, kenvelopeMode, krendering, kdisplayMode;
 				cpl::CPresetWidget kpresets;
 
 				VectorScopeContent & parent;
@@ -316,6 +342,8 @@
 
 				, autoGain("AutoGain")
 				, operationalMode("OpMode")
+				, rendering("Rendering")
+				, displayMode("DispMode")
 				, envelopeWindow("EnvWindow", windowRange, msFormatter)
 				, stereoWindow("StereoWindow", windowRange, msFormatter)
 				, inputGain("InputGain", dbRange, dbFormatter)
@@ -340,11 +368,14 @@
 			{
 				operationalMode.fmt.setValues({ "Lissajous", "Polar" });
 				autoGain.fmt.setValues({ "None", "RMS", "Peak decay" });
+				rendering.fmt.setValues({ "Processor", "Graphics card" });
+				displayMode.fmt.setValues({ "Samples", "Density" });
 
 				auto singleParameters = { 
 					&autoGain.param, &operationalMode.param, &envelopeWindow, &stereoWindow,
 					&inputGain, &windowSize, &waveZRotation, &antialias,
 					&fadeOlderPoints, &interconnectSamples, &diagnostics, &primitiveSize,
+					&rendering.param, &displayMode.param,
 				};
 
 				for (auto sparam : singleParameters)
@@ -394,6 +425,8 @@
 				archive << operationalMode.param;
 				archive << stereoWindow;
 				archive << meterColour;
+				archive << rendering.param;
+				archive << displayMode.param;
 			}
 
 			virtual void deserialize(cpl::CSerializer::Builder & builder, cpl::Version v) override
@@ -416,6 +449,12 @@
 				builder >> operationalMode.param;
 				builder >> stereoWindow;
 				builder >> meterColour;
+
+				if (v >= cpl::Version(0, 3, 3))
+				{
+					builder >> rendering.param;
+					builder >> displayMode.param;
+				}
 			}
 
 			AudioHistoryTransformatter<ParameterSet::ParameterView> audioHistoryTransformatter;
@@ -456,7 +495,15 @@
 
 			ChoiceParameter
 				autoGain,
-				operationalMode;
+				operationalMode,
+				/// <summary>
+				/// Whether samples are transformed on the CPU or in a vertex shader, see Rendering.
+				/// </summary>
+				rendering,
+				/// <summary>
+				/// Whether samples are drawn individually or binned into a histogram, see DisplayMode.
+				/// </summary>
+				displayMode;
 
 			cpl::ParameterColourValue<ParameterSet::ParameterView>::SharedBehaviour colourBehaviour;
 
@@ -29,6 +29,7 @@
 
 
 #include "Vectorscope.h"
+#include "PolarMapping.h"
 #include <cstdint>
 #include <cpl/CMutex.h>
 #include <cpl/Mathext.h>
@@ -83,6 +84,8 @@ namespace Signalizer
 				100 * audioStream.getPerfMeasures().asyncOverhead.load(std::memory_order_relaxed));
 			g.drawSingleLineText(textbuf.get(), 10, 20);
 
+			sprintf(textbuf.get(), "latency: %.1f ms (p50: %.1f ms, p99: %.1f ms)", latency.getLatest(), latency.getPercentile(0.5), latency.getPercentile(0.99));
+			g.drawSingleLineText(textbuf.get(), 10, 40);
 		}
 	}
 
@@ -132,6 +135,8 @@ namespace Signalizer
 	void VectorScope::closeOpenGL()
 	{
 		textures.clear();
+		vertexHistory.release(*oglc);
+		densityHistogram.release(*oglc);
 	}
 
 	void VectorScope::onOpenGLRendering()
@@ -142,11 +147,16 @@ namespace Signalizer
 	template<typename ISA>
 		void VectorScope::vectorGLRendering()
 		{
+			SIGNALIZER_TRACE_THREAD("Rendering");
+			SIGNALIZER_TRACE_ZONE("VectorScope::render");
 
 			CPL_DEBUGCHECKGL();
+			// the newest sample of the history drawn in this frame
+			std::uint64_t drawnClock = 0;
             {
                 auto cStart = cpl::Misc::ClockCounter();
                 auto && lockedView = audioStream.getAudioBufferViews();
+                drawnClock = shared.streamClock.load(std::memory_order_acquire);
                 handleFlagUpdates();
                 juce::OpenGLHelpers::clear(state.colourBackground);
                 {
@@ -159,14 +169,17 @@ namespace Signalizer
                     openGLStack.applyTransform3D(transform);
                     state.antialias ? openGLStack.enable(GL_MULTISAMPLE) : openGLStack.disable(GL_MULTISAMPLE);
 
-                    // the peak filter has to run on the whole buffer each time.
-                    if (state.envelopeMode == EnvelopeModes::PeakDecay)
+                    // envelopes are followed on the audio thread
+                    if (state.envelopeMode == EnvelopeModes::None)
                     {
-                        runPeakFilter<ISA>(lockedView);
+                        state.envelopeGain = 1;
                     }
-                    else if (state.envelopeMode == EnvelopeModes::None)
+                    else
                     {
-                        state.envelopeGain = 1;
+                        const auto envelope = shared.autoGainEnvelope.load(std::memory_order_acquire);
+
+                        if (std::isnormal(envelope))
+                            state.envelopeGain = envelope;
                     }
 
                     openGLStack.setLineSize(static_cast<float>(oglc->getRenderingScale()) * state.primitiveSize);
@@ -175,7 +188,15 @@ namespace Signalizer
                     // draw actual stereoscopic plot
                     if (lockedView.getNumChannels() >= 2)
                     {
-                        if (state.isPolar)
+                        if (state.displayMode == VectorScopeContent::DisplayMode::Density)
+                        {
+                            drawDensityPlot(openGLStack);
+                        }
+                        else if (state.rendering == VectorScopeContent::Rendering::GraphicsCard)
+                        {
+                            drawShadedPlot(openGLStack, lockedView);
+                        }
+                        else if (state.isPolar)
                         {
                             drawPolarPlot<ISA>(openGLStack, lockedView);
                         }
@@ -202,6 +223,8 @@ namespace Signalizer
             }
 			renderGraphics([&](juce::Graphics & g) { paint2DGraphics(g); });
 
+			latency.frameDrawn(content->systemView.getBlockTimeline(), drawnClock);
+
 			auto tickNow = juce::Time::getHighResolutionTicks();
 			avgFps.setNext(tickNow - lastFrameTick);
 			lastFrameTick = tickNow;
@@ -453,6 +476,32 @@ namespace Signalizer
 		}
 
 
+	void VectorScope::drawShadedPlot(cpl::OpenGLRendering::COpenGLStack & openGLStack, const AudioStream::AudioBufferAccess & audio)
+	{
+		cpl::OpenGLRendering::MatrixModification matrixMod;
+
+		// the polar plot is not rotated, see drawPolarPlot()
+		if (!state.isPolar)
+			matrixMod.rotate(state.rotation * 360, 0, 0, 1);
+
+		const auto gain = static_cast<GLfloat>(state.envelopeGain * state.userGain);
+		matrixMod.scale(gain, gain, 1);
+
+		vertexHistory.update(*oglc, audio, shared.writtenSamples.exchange(0, std::memory_order_relaxed));
+		vertexHistory.render(*oglc, { state.colourDraw, state.isPolar, state.fadeHistory, state.fillPath });
+	}
+
+	void VectorScope::drawDensityPlot(cpl::OpenGLRendering::COpenGLStack & openGLStack)
+	{
+		cpl::OpenGLRendering::MatrixModification matrixMod;
+
+		// gain is applied while binning
+		if (!state.isPolar)
+			matrixMod.rotate(state.rotation * 360, 0, 0, 1);
+
+		densityHistogram.render(*oglc, state.colourDraw);
+	}
+
 	template<typename ISA>
 		void VectorScope::drawPolarPlot(cpl::OpenGLRendering::COpenGLStack & openGLStack, const AudioStream::AudioBufferAccess & audio)
 		{
@@ -460,7 +509,6 @@ namespace Signalizer
 			AudioStream::AudioBufferView views[2] = { audio.getView(0), audio.getView(1) };
 
 			using namespace cpl::simd;
-			using cpl::simd::abs;
 			typedef typename scalar_of<V>::type Ty;
 
 			cpl::OpenGLRendering::MatrixModification matrixMod;
@@ -473,13 +521,7 @@ namespace Signalizer
 			suitable_container<V> outX, outY, outFade;
 
 			// simd consts
-			const Ty cosineRotation = consts<Ty>::sqrt_half_two_minus;
-			const Ty sineRotation = consts<Ty>::sqrt_half_two;
-			const V vCosine = consts<V>::sqrt_half_two_minus; // equals e^i*0.75*pi
-			const V vSine = consts<V>::sqrt_half_two;
-			const V vZero = zero<V>();
 			const V vOne = consts<V>::one;
-			const V vSign = consts<V>::sign_bit;
 			auto const fadePerSample = (Ty)1.0 / numSamples;
 			auto const vIncrementalFade = set1<V>(fadePerSample * vectorLength);
 
@@ -517,30 +559,11 @@ namespace Signalizer
 						V vLeft = loadu<V>(left + i);
 						V vRight = loadu<V>(right + i);
 
-						// the length of the hypotenuse of the triangle, we
-						// convert the unit square to.
-						auto const vLength = max(abs(vLeft), abs(vRight));
-
-						// rotate our view manually (to center on Y-axis)
-						V vY = vLeft * vCosine - vRight * vSine;
-						V vX = vLeft * vSine + vRight * vCosine;
-
-						// check for any zero elements.
-						vLeft = (vLeft == vZero);
-						vRight = (vRight == vZero);
-						auto vMask = vnot(vand(vLeft, vRight));
-
-						// get the phase angle. use atan2 if you want to draw the full circle.
-						// x and y are swapped at this point, btw.
-						auto vAngle = atan(vX / vY);
-						// replace nan elements of angle with zero
-						vAngle = vand(vMask, vAngle);
-						// calcuate x,y coordinates for the right triangle
-						sincos(vAngle, &vX, &vY);
+						V vX, vY;
+						polarMap(vLeft, vRight, vX, vY);
 
-						// construct triangle.
-						outX = vX * vLength;
-						outY = vY * vLength;
+						outX = vX;
+						outY = vY;
 
 						outFade = vSampleFade - vOne;
 
@@ -563,25 +586,10 @@ namespace Signalizer
 						Ty vLeft = left[i];
 						Ty vRight = right[i];
 
-						// the length of the hypotenuse of the triangle, we
-						// convert the unit square to.
-						auto const length = std::max(std::abs(vLeft), std::abs(vRight));
+						Ty vX, vY;
+						polarMapSample(vLeft, vRight, vX, vY);
 
-						// rotate our view manually (to center on Y-axis)
-						Ty vY = vLeft * cosineRotation - vRight * sineRotation;
-						Ty vX = vLeft * sineRotation + vRight * cosineRotation;
-
-						// check for any zero elements.
-
-						// get the phase angle. use atan2 if you want to draw the full circle.
-						// x and y are swapped at this point, btw.
-						auto angle = std::atan(vX / vY);
-						// replace nan elements of angle with zero
-						angle = (vLeft == Ty(0) && vRight == Ty(0)) ? Ty(0) : angle;
-						// calcuate x,y coordinates for the right triangle
-						sincos(angle, &vX, &vY);
-
-						drawer.addVertex(vX * length, vY * length, (currentSampleFade - remaindingSamples * fadePerSample));
+						drawer.addVertex(vX, vY, (currentSampleFade - remaindingSamples * fadePerSample));
 
 
 
@@ -618,30 +626,11 @@ namespace Signalizer
 						V vLeft = loadu<V>(left + i);
 						V vRight = loadu<V>(right + i);
 
-						// the length of the hypotenuse of the triangle, we
-						// convert the unit square to.
-						auto const vLength = max(abs(vLeft), abs(vRight));
-
-						// rotate our view manually (to center on Y-axis)
-						V vY = vLeft * vCosine - vRight * vSine;
-						V vX = vLeft * vSine + vRight * vCosine;
+						V vX, vY;
+						polarMap(vLeft, vRight, vX, vY);
 
-						// check for any zero elements.
-						vLeft = (vLeft == vZero);
-						vRight = (vRight == vZero);
-						auto vMask = vnot(vand(vLeft, vRight));
-
-						// get the phase angle. use atan2 if you want to draw the full circle.
-						// x and y are swapped at this point, btw.
-						auto vAngle = atan(vX / vY);
-						// replace nan elements of angle with zero
-						vAngle = vand(vMask, vAngle);
-						// calcuate x,y coordinates for the right triangle
-						sincos(vAngle, &vX, &vY);
-
-						// construct triangle.
-						outX = vX * vLength;
-						outY = vY * vLength;
+						outX = vX;
+						outY = vY;
 
 						outFade = vSampleFade - vOne;
 
@@ -671,27 +660,12 @@ namespace Signalizer
 						Ty vLeft = left[i];
 						Ty vRight = right[i];
 
-						// the length of the hypotenuse of the triangle, we
-						// convert the unit square to.
-						auto const length = std::max(std::abs(vLeft), std::abs(vRight));
-
-						// rotate our view manually (to center on Y-axis)
-						Ty vY = vLeft * cosineRotation - vRight * sineRotation;
-						Ty vX = vLeft * sineRotation + vRight * cosineRotation;
-
-						// check for any zero elements.
-
-						// get the phase angle. use atan2 if you want to draw the full circle.
-						// x and y are swapped at this point, btw.
-						auto angle = std::atan(vX / vY);
-						// replace nan elements of angle with zero
-						angle = (vLeft == Ty(0) && vRight == Ty(0)) ? Ty(0) : angle;
-						// calcuate x,y coordinates for the right triangle
-						sincos(angle, &vX, &vY);
+						Ty vX, vY;
+						polarMapSample(vLeft, vRight, vX, vY);
 
 						auto currentFade = (currentSampleFade - remaindingSamples * fadePerSample);
 						drawer.addColour(red * (currentFade + 1), green * (currentFade + 1), blue * (currentFade + 1));
-						drawer.addVertex(vX * length, vY * length, currentFade);
+						drawer.addVertex(vX, vY, currentFade);
 
 					}
 					// fractionally increase sample fade levels
@@ -774,72 +748,4 @@ namespace Signalizer
 			rect.setBounds(-balanceX, stereoY + stereoLength * 0.5f - indicatorSize * 0.125f, sideSize * heightToWidthFactor, indicatorSize * 0.125f);
 			rect.fill();
 		}
-
-
-	template<typename ISA>
-		void VectorScope::runPeakFilter(const AudioStream::AudioBufferAccess & audio)
-		{
-			typedef typename ISA::V V;
-
-			double currentEnvelope = 1;
-
-			if (audio.getNumChannels() >= 2)
-			{
-				AudioStream::AudioBufferView views[2] = { audio.getView(0), audio.getView(1) };
-
-				std::size_t numSamples = views[0].size();
-
-				// since this runs in every frame, we need to scale the coefficient by how often this function runs
-				// (and the amount of samples)
-				double power = numSamples * (avgFps.getAverage() / juce::Time::getHighResolutionTicksPerSecond());
-
-				double coeff = std::pow(state.envelopeCoeff, power);
-
-				// there is a number of optimisations we can do here, mostly that we actually don't care about
-				// timing, we are only interested in the current largest value in the set.
-				using namespace cpl;
-				using namespace cpl::simd;
-				using cpl::simd::load;
-
-				V
-					vLMax = zero<V>(),
-					vRMax = zero<V>(),
-					vSign = consts<V>::sign_mask;
-
-				auto const loopIncrement = elements_of<V>::value;
-
-				auto * leftBuffer = views[0].begin();
-				auto * rightBuffer = views[1].begin();
-
-				auto stop = numSamples - (numSamples & (loopIncrement - 1));
-				if (stop <= 0)
-					stop = 0;
-
-				for (std::size_t i = 0; i < stop; i += loopIncrement)
-				{
-					auto const vLInput = loadu<V>(leftBuffer + i);
-					vLMax = max(vand(vLInput, vSign), vLMax);
-					auto const vRInput = loadu<V>(rightBuffer + i);
-					vRMax = max(vand(vRInput, vSign), vRMax);
-				}
-
-				// TODO: remainder?
-
-				suitable_container<V> lmax = vLMax, rmax = vRMax;
-
-				double highestLeft = *std::max_element(lmax.begin(), lmax.end());
-				double highestRight = *std::max_element(rmax.begin(), rmax.end());
-
-				filters.envelope[0] = std::max(filters.envelope[0] * coeff, highestLeft  * highestLeft);
-				filters.envelope[1] = std::max(filters.envelope[1] * coeff, highestRight * highestRight);
-
-				currentEnvelope = 1.0 / std::max(std::sqrt(filters.envelope[0]), std::sqrt(filters.envelope[1]));
-
-			}
-
-			if (std::isnormal(currentEnvelope))
-			{
-				state.envelopeGain = currentEnvelope;
-			}
-		}
 };
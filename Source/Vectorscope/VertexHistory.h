@@ -0,0 +1,313 @@
+/*************************************************************************************
+
+	Signalizer - cross-platform audio visualization plugin - v. 0.x.y
+
+	Copyright (C) 2017 Janus Lynggaard Thorborg (www.jthorborg.com)
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	See \licenses\ for additional details on licenses associated with this program.
+
+**************************************************************************************
+
+	file:VertexHistory.h
+
+		A mirror of the stereo audio history in a persistent vertex buffer, that is
+		transformed into a vectorscope plot by a vertex shader.
+
+*************************************************************************************/
+
+#ifndef SIGNALIZER_VERTEXHISTORY_H
+	#define SIGNALIZER_VERTEXHISTORY_H
+
+	#include "Signalizer.h"
+	#include <memory>
+	#include <vector>
+
+	#ifndef GL_ARRAY_BUFFER
+		#define GL_ARRAY_BUFFER 0x8892
+	#endif
+	#ifndef GL_ELEMENT_ARRAY_BUFFER
+		#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+	#endif
+	#ifndef GL_STATIC_DRAW
+		#define GL_STATIC_DRAW 0x88E4
+	#endif
+	#ifndef GL_DYNAMIC_DRAW
+		#define GL_DYNAMIC_DRAW 0x88E8
+	#endif
+
+	namespace Signalizer
+	{
+		/// <summary>
+		/// Keeps the left and right audio history in a vertex buffer, laid out like the circular buffer of the audio stream.
+		/// Each frame, only the samples written since the last frame are uploaded. The Lissajous or polar mapping,
+		/// the age of samples and the history fade are evaluated in a vertex shader, while gain and rotation are
+		/// taken from the current modelview matrix.
+		///
+		/// All functions must be called with the OpenGL context active.
+		/// </summary>
+		class VertexHistory
+		{
+		public:
+
+			struct Options
+			{
+				juce::Colour colour;
+				bool isPolar, fadeHistory, interconnect;
+			};
+
+			/// <summary>
+			/// Copies samples written to the audio history since the last call into the vertex buffer.
+			/// writtenSamples is the amount of samples the audio stream has received since the last call;
+			/// it is only used to detect whether the history has been overwritten completely.
+			/// </summary>
+			void update(juce::OpenGLContext & context, const AudioStream::AudioBufferAccess & audio, std::size_t writtenSamples)
+			{
+				if (audio.getNumChannels() < 2)
+					return;
+
+				AudioStream::AudioBufferView views[2] = { audio.getView(0), audio.getView(1) };
+
+				// the history is iterated oldest first: from the write cursor to the end of the buffer, then from the start.
+				// thus, the second range starts at the beginning of the buffer and is as long as the cursor position.
+				const std::size_t newSize = views[0].getItRange(0) + views[0].getItRange(1);
+				const bool wrapped = views[0].getItRange(1) != 0;
+				const AFloat * newBases[2] =
+				{
+					wrapped ? views[0].getItIndex(1) : views[0].getItIndex(0),
+					wrapped ? views[1].getItIndex(1) : views[1].getItIndex(0)
+				};
+				const std::size_t newCursor = wrapped ? views[0].getItRange(1) : 0;
+
+				if (newSize == 0)
+					return;
+
+				auto & gl = context.extensions;
+
+				if (!vertexBuffer)
+				{
+					gl.glGenBuffers(1, &vertexBuffer);
+					gl.glGenBuffers(1, &indexBuffer);
+					size = 0;
+				}
+
+				// anything but new samples written into the same buffer requires uploading all of it.
+				const bool complete = newSize != size || newBases[0] != bases[0] || newBases[1] != bases[1] || writtenSamples >= newSize;
+
+				if (newSize != size)
+				{
+					size = newSize;
+					staging.resize(size * 2);
+
+					// the physical index of every sample, from which the shader computes the age
+					std::vector<GLfloat> indices(size);
+					for (std::size_t i = 0; i < size; ++i)
+						indices[i] = static_cast<GLfloat>(i);
+
+					gl.glBindBuffer(GL_ARRAY_BUFFER, indexBuffer);
+					gl.glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(size * sizeof(GLfloat)), indices.data(), GL_STATIC_DRAW);
+
+					gl.glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+					gl.glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(staging.size() * sizeof(GLfloat)), nullptr, GL_DYNAMIC_DRAW);
+				}
+				else
+				{
+					gl.glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+				}
+
+				bases[0] = newBases[0];
+				bases[1] = newBases[1];
+
+				auto uploadRange = [&](std::size_t offset, std::size_t count)
+				{
+					if (!count)
+						return;
+
+					GLfloat * interleaved = staging.data() + offset * 2;
+
+					for (std::size_t i = 0; i < count; ++i)
+					{
+						interleaved[i * 2] = bases[0][offset + i];
+						interleaved[i * 2 + 1] = bases[1][offset + i];
+					}
+
+					gl.glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset * 2 * sizeof(GLfloat)), static_cast<GLsizeiptr>(count * 2 * sizeof(GLfloat)), interleaved);
+				};
+
+				if (complete)
+				{
+					uploadRange(0, size);
+				}
+				else if (newCursor != cursor)
+				{
+					if (newCursor > cursor)
+					{
+						uploadRange(cursor, newCursor - cursor);
+					}
+					else
+					{
+						uploadRange(cursor, size - cursor);
+						uploadRange(0, newCursor);
+					}
+				}
+
+				cursor = newCursor;
+
+				gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+			}
+
+			/// <summary>
+			/// Draws the history with the current matrices, from the oldest to the newest sample.
+			/// </summary>
+			void render(juce::OpenGLContext & context, const Options & options)
+			{
+				if (!vertexBuffer || size < 2)
+					return;
+
+				if (!program && !createProgram(context))
+					return;
+
+				auto & gl = context.extensions;
+
+				program->use();
+				cursorUniform->set(static_cast<GLfloat>(cursor));
+				sizeUniform->set(static_cast<GLfloat>(size));
+				ageScaleUniform->set(1.0f / (size - 1));
+				colourUniform->set(options.colour.getFloatRed(), options.colour.getFloatGreen(), options.colour.getFloatBlue(), options.colour.getFloatAlpha());
+				polarUniform->set(options.isPolar ? 1.0f : 0.0f);
+				fadeUniform->set(options.fadeHistory ? 1.0f : 0.0f);
+
+				glEnableClientState(GL_VERTEX_ARRAY);
+				glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+				gl.glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+				glVertexPointer(2, GL_FLOAT, 0, nullptr);
+				gl.glBindBuffer(GL_ARRAY_BUFFER, indexBuffer);
+				glTexCoordPointer(1, GL_FLOAT, 0, nullptr);
+				gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+				const GLenum mode = options.interconnect ? GL_LINE_STRIP : GL_POINTS;
+
+				glDrawArrays(mode, static_cast<GLint>(cursor), static_cast<GLsizei>(size - cursor));
+
+				if (cursor)
+				{
+					glDrawArrays(mode, 0, static_cast<GLsizei>(cursor));
+
+					if (options.interconnect)
+					{
+						// join the two ranges across the end of the buffer
+						const GLuint joint[] = { static_cast<GLuint>(size - 1), 0 };
+						gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+						glDrawElements(GL_LINES, 2, GL_UNSIGNED_INT, joint);
+					}
+				}
+
+				glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+				glDisableClientState(GL_VERTEX_ARRAY);
+
+				gl.glUseProgram(0);
+			}
+
+			/// <summary>
+			/// Releases all OpenGL objects. Call before the context is destroyed.
+			/// </summary>
+			void release(juce::OpenGLContext & context)
+			{
+				for (auto uniform : { &cursorUniform, &sizeUniform, &ageScaleUniform, &colourUniform, &polarUniform, &fadeUniform })
+					uniform->reset();
+
+				program = nullptr;
+
+				if (vertexBuffer)
+				{
+					context.extensions.glDeleteBuffers(1, &vertexBuffer);
+					context.extensions.glDeleteBuffers(1, &indexBuffer);
+					vertexBuffer = indexBuffer = 0;
+				}
+
+				size = cursor = 0;
+				bases[0] = bases[1] = nullptr;
+			}
+
+		private:
+
+			bool createProgram(juce::OpenGLContext & context)
+			{
+				// the polar mapping is the same as polarMapSample() in PolarMapping.h.
+				static const char * vertexShader =
+					"uniform float cursor;\n"
+					"uniform float size;\n"
+					"uniform float ageScale;\n"
+					"uniform vec4 colour;\n"
+					"uniform float polar;\n"
+					"uniform float fade;\n"
+					"void main()\n"
+					"{\n"
+					"	float left = gl_Vertex.x;\n"
+					"	float right = gl_Vertex.y;\n"
+					"	float age = mod(gl_MultiTexCoord0.x - cursor + size, size) * ageScale;\n"
+					"	vec2 position = vec2(right, left);\n"
+					"	if (polar > 0.5)\n"
+					"	{\n"
+					"		float rotY = (left + right) * -0.707106781186547;\n"
+					"		float rotX = (left - right) * 0.707106781186547;\n"
+					"		float radius = left * left + right * right;\n"
+					"		float scale = radius > 0.0 ? max(abs(left), abs(right)) * inversesqrt(radius) : 0.0;\n"
+					"		position = vec2(rotY < 0.0 ? -rotX : rotX, abs(rotY)) * scale;\n"
+					"	}\n"
+					"	gl_FrontColor = vec4(colour.rgb * mix(1.0, age, fade), colour.a);\n"
+					"	gl_Position = gl_ModelViewProjectionMatrix * vec4(position, age - 1.0, 1.0);\n"
+					"}\n";
+
+				static const char * fragmentShader =
+					"void main()\n"
+					"{\n"
+					"	gl_FragColor = gl_Color;\n"
+					"}\n";
+
+				std::unique_ptr<juce::OpenGLShaderProgram> newProgram(new juce::OpenGLShaderProgram(context));
+
+				if (!newProgram->addVertexShader(vertexShader) || !newProgram->addFragmentShader(fragmentShader) || !newProgram->link())
+				{
+					CPL_BREAKIFDEBUGGED();
+					return false;
+				}
+
+				program = std::move(newProgram);
+				cursorUniform.reset(new juce::OpenGLShaderProgram::Uniform(*program, "cursor"));
+				sizeUniform.reset(new juce::OpenGLShaderProgram::Uniform(*program, "size"));
+				ageScaleUniform.reset(new juce::OpenGLShaderProgram::Uniform(*program, "ageScale"));
+				colourUniform.reset(new juce::OpenGLShaderProgram::Uniform(*program, "colour"));
+				polarUniform.reset(new juce::OpenGLShaderProgram::Uniform(*program, "polar"));
+				fadeUniform.reset(new juce::OpenGLShaderProgram::Uniform(*program, "fade"));
+
+				return true;
+			}
+
+			typedef std::unique_ptr<juce::OpenGLShaderProgram::Uniform> UniformPtr;
+
+			/// <summary>
+			/// Interleaved left and right samples, mirroring the vertex buffer.
+			/// </summary>
+			std::vector<GLfloat> staging;
+			std::unique_ptr<juce::OpenGLShaderProgram> program;
+			UniformPtr cursorUniform, sizeUniform, ageScaleUniform, colourUniform, polarUniform, fadeUniform;
+			const AFloat * bases[2] = { nullptr, nullptr };
+			std::size_t size = 0, cursor = 0;
+			GLuint vertexBuffer = 0, indexBuffer = 0;
+		};
+	};
+#endif
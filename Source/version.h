@@ -1,7 +1,7 @@
 #define SIGNALIZER_MAJOR 0
 #define SIGNALIZER_MINOR 3
-#define SIGNALIZER_BUILD 2
+#define SIGNALIZER_BUILD 3
 #define SIGNALIZER_BUILD_INFO "  dev\n* master\n  osc/peak-triggers\n\n2dcf5fc\n"
 
-#define SIGNALIZER_VERSION_STRING "0.3.2"
-#define SIGNALIZER_VST_VERSION_HEX 0x000302
\ No newline at end of file
+#define SIGNALIZER_VERSION_STRING "0.3.3"
+#define SIGNALIZER_VST_VERSION_HEX 0x000303
\ No newline at end of file